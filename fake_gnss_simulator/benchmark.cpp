@@ -0,0 +1,509 @@
+/**
+ * @file benchmark.cpp
+ * @brief Load benchmark of the simulator, reading its output back through a PTY
+ */
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <interface.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <ubx_checksum.h>
+#include <ubx_parser.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;  //!< @brief clock of epoch timers of the simulator
+
+//! @brief Classes swept by UBX-CFG-MSG to enable every periodic message, NMEA being 0xF0
+static const uint8_t sweep_classes[] = {0x01, 0x02, 0x0A, 0x0D, 0x10, 0x28, 0xF0, 0xF1};
+
+//! @brief Keys of UBX-RXM-SFRBX and UBX-ESF-MEAS, which are not sent in every epoch
+static const uint32_t sparse_keys[] = {0x0213, 0x1002};
+
+//! @brief Allocations by operator new in every thread but the reader
+static std::atomic<uint64_t> allocations(0);
+
+//! @brief Thread does not count its allocations
+static thread_local bool uncounted = false;
+
+void * operator new(std::size_t size)
+{
+  if (!uncounted) allocations.fetch_add(1, std::memory_order_relaxed);
+  void * p = malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void * p) noexcept { free(p); }
+
+void operator delete(void * p, std::size_t) noexcept { free(p); }
+
+/**
+ * @brief Output of one navigation epoch as seen at the far end
+ */
+typedef struct
+{
+  Clock::time_point first_;     //!< @brief arrival of the first byte
+  Clock::time_point last_;      //!< @brief arrival of the last byte
+  uint32_t messages_;           //!< @brief UBX frames and NMEA sentences
+  uint32_t bytes_;              //!< @brief bytes
+  std::vector<uint32_t> keys_;  //!< @brief (class << 8) | id of UBX, or NMEA formatter, once each
+} BURST;
+
+/**
+ * @brief State shared with the reader thread
+ */
+typedef struct
+{
+  int fd_;                        //!< @brief far end of USB
+  Clock::duration gap_;           //!< @brief silence which ends a burst of epoch or sensor samples
+  std::atomic<int> phase_;        //!< @brief 0 configuring, 1 measuring, 2 done
+  std::atomic<uint32_t> acks_;    //!< @brief UBX-ACK-ACK of UBX-CFG-MSG
+  std::atomic<uint32_t> naks_;    //!< @brief UBX-ACK-NAK of UBX-CFG-MSG
+  std::vector<BURST> bursts_;     //!< @brief bursts starting while measuring
+  uint64_t nmea_errors_;          //!< @brief NMEA sentences with wrong checksum while measuring
+  std::vector<uint32_t> tags_;    //!< @brief timeTag of UBX-ESF-MEAS while measuring
+  uint64_t overflows_;            //!< @brief UBX-MON-COMMS reporting dropped output while measuring
+  struct timeval cpu_[2];         //!< @brief CPU time of reader at start and end of measurement
+} READER;
+
+/**
+ * @brief Show usage
+ * @param [in] name program name
+ */
+static void usage(const char * name)
+{
+  printf("Usage: %s [options]\n", name);
+  printf("  -m, --meas-rate MS     measurement rate of UBX-CFG-RATE [ms], 25 by default\n");
+  printf("  -t, --duration SEC     measure for SEC seconds, 10 by default\n");
+  printf("  -w, --warmup SEC       run SEC seconds before measuring, 1 by default\n");
+  printf("  -o, --output FILE      write JSON results to FILE instead of stdout\n");
+  printf("  -h, --help             show this help\n");
+}
+
+/**
+ * @brief Open pseudo terminal in raw mode
+ * @param [out] name device name of the slave
+ * @return file descriptor of the master, -1 on error
+ */
+static int openPty(std::string & name)
+{
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0) return -1;
+  if (grantpt(fd) != 0 || unlockpt(fd) != 0) {
+    close(fd);
+    return -1;
+  }
+  name = ptsname(fd);
+
+  // Slave is opened by the simulator, which sets it up as a serial port
+  struct termios t;
+  tcgetattr(fd, &t);
+  cfmakeraw(&t);
+  tcsetattr(fd, TCSANOW, &t);
+  return fd;
+}
+
+/**
+ * @brief Write UBX frame
+ * @param [in] fd file descriptor
+ * @param [in] message_class message class
+ * @param [in] message_id message id
+ * @param [in] payload payload
+ * @param [in] length length of payload
+ */
+static void writeUbx(
+  int fd, uint8_t message_class, uint8_t message_id, const uint8_t * payload, uint16_t length)
+{
+  std::vector<uint8_t> d = {0xB5, 0x62, message_class, message_id};
+  d.push_back(length & 0xFF);
+  d.push_back(length >> 8);
+  d.insert(d.end(), payload, payload + length);
+  uint8_t ck_a = 0;
+  uint8_t ck_b = 0;
+  ubxChecksum(&d[2], d.size() - 2, ck_a, ck_b);
+  d.push_back(ck_a);
+  d.push_back(ck_b);
+
+  for (std::size_t n = 0; n < d.size();) {
+    ssize_t r = write(fd, &d[n], d.size() - n);
+    if (r <= 0) return;
+    n += r;
+  }
+}
+
+/**
+ * @brief Check if message is not sent in every epoch
+ * @param [in] key (class << 8) | id of UBX, or formatter of NMEA
+ * @return true if the message is sparse
+ */
+static bool isSparse(uint32_t key)
+{
+  return std::find(std::begin(sparse_keys), std::end(sparse_keys), key) != std::end(sparse_keys);
+}
+
+/**
+ * @brief Add key of message received in burst, unless already there
+ * @param [inout] burst burst
+ * @param [in] key (class << 8) | id of UBX, or formatter of NMEA
+ */
+static void addKey(BURST & burst, uint32_t key)
+{
+  if (std::find(burst.keys_.begin(), burst.keys_.end(), key) == burst.keys_.end()) {
+    burst.keys_.push_back(key);
+  }
+}
+
+/**
+ * @brief Count complete NMEA sentences in received data
+ * @param [in] data received data
+ * @param [in] size size of data
+ * @param [inout] line sentence carried over from the previous data
+ * @param [inout] errors sentences with wrong checksum
+ * @param [inout] burst burst the sentences are added to by formatter
+ * @return number of sentences with valid checksum
+ */
+static uint32_t countNmea(
+  const uint8_t * data, std::size_t size, std::string & line, uint64_t & errors, BURST & burst)
+{
+  uint32_t n = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    char c = data[i];
+    if (c == '$') {
+      line.assign(1, c);
+    } else if (!line.empty() && c == '\n') {
+      // $...*hh\r\n, checksum being XOR between $ and *
+      std::size_t star = line.size() - 4;
+      if (line.size() >= 5 && line[star] == '*') {
+        uint8_t sum = 0;
+        for (std::size_t j = 1; j < star; ++j) sum ^= line[j];
+        if (strtoul(line.substr(star + 1, 2).c_str(), nullptr, 16) == sum) {
+          // Formatter follows the talker ID of $GNGGA, packed above keys of UBX
+          if (star > 6) addKey(burst, (line[3] << 16) | (line[4] << 8) | line[5]);
+          ++n;
+        } else {
+          ++errors;
+        }
+      }
+      line.clear();
+    } else if (!line.empty()) {
+      // Binary data of UBX frames is not a sentence
+      if (line.size() > 82 || c < 0x0D || c > 0x7E) {
+        line.clear();
+      } else {
+        line.push_back(c);
+      }
+    }
+  }
+  return n;
+}
+
+/**
+ * @brief Read output of the simulator, and split it into bursts of epochs
+ * @param [inout] arg READER
+ * @return nullptr
+ */
+static void * reader(void * arg)
+{
+  READER & r = *static_cast<READER *>(arg);
+  uncounted = true;
+  static UbxParser parser;
+  std::string line;
+  uint8_t buf[4096];
+  BURST burst = {};
+  bool open = false;
+  int phase = 0;
+
+  while (phase < 2) {
+    // Take CPU time of this thread on phase changes, to exclude it from that of the simulator
+    int p = r.phase_.load();
+    if (p != phase) {
+      struct rusage u;
+      getrusage(RUSAGE_THREAD, &u);
+      timeradd(&u.ru_utime, &u.ru_stime, &r.cpu_[p - 1]);
+      phase = p;
+    }
+
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(r.fd_, &fds);
+    struct timeval tv = {0, 1000};
+    if (select(r.fd_ + 1, &fds, nullptr, nullptr, &tv) <= 0) continue;
+    ssize_t size = read(r.fd_, buf, sizeof(buf));
+    if (size <= 0) continue;
+    Clock::time_point now = Clock::now();
+
+    // Silence longer than the gap starts the burst of the next epoch
+    if (open && now - burst.last_ > r.gap_) {
+      if (phase == 1) r.bursts_.push_back(burst);
+      open = false;
+    }
+    if (!open) {
+      burst = {now, now, 0, 0, {}};
+      open = true;
+    }
+    burst.last_ = now;
+    burst.bytes_ += size;
+
+    parser.feed(buf, size);
+    const uint8_t * frame;
+    std::size_t n;
+    while (parser.next(frame, n)) {
+      ++burst.messages_;
+      if (frame[2] == 0x05 && frame[6] == 0x06 && frame[7] == 0x01) {
+        (frame[3] == 0x01) ? ++r.acks_ : ++r.naks_;
+      }
+      if (frame[2] != 0x05) addKey(burst, (frame[2] << 8) | frame[3]);
+      if (phase != 1) continue;
+
+      // Samples of UBX-ESF-MEAS are missed by gaps of timeTag, and drops of any message are
+      // flagged by the alloc bit of txErrors of UBX-MON-COMMS
+      if (frame[2] == 0x10 && frame[3] == 0x02) {
+        uint32_t tag;
+        memcpy(&tag, frame + 6, sizeof(tag));
+        r.tags_.push_back(tag);
+      }
+      if (frame[2] == 0x0A && frame[3] == 0x36 && (frame[8] & 0x02)) ++r.overflows_;
+    }
+    uint64_t errors = 0;
+    burst.messages_ += countNmea(buf, size, line, errors, burst);
+    if (phase == 1) r.nmea_errors_ += errors;
+  }
+
+  return nullptr;
+}
+
+/**
+ * @brief Get percentile of sorted values by nearest rank
+ * @param [in] v sorted values
+ * @param [in] p percentile [%]
+ * @return value, 0 if none
+ */
+static double percentile(const std::vector<double> & v, double p)
+{
+  if (v.empty()) return 0.0;
+  std::size_t i = static_cast<std::size_t>(p / 100.0 * (v.size() - 1) + 0.5);
+  return v[std::min(i, v.size() - 1)];
+}
+
+/**
+ * @brief Write percentiles as JSON object
+ * @param [in] out output
+ * @param [in] name name of object
+ * @param [inout] v values, sorted on return
+ */
+static void writePercentiles(FILE * out, const char * name, std::vector<double> & v)
+{
+  std::sort(v.begin(), v.end());
+  fprintf(
+    out, "  \"%s\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f},\n", name,
+    percentile(v, 50), percentile(v, 90), percentile(v, 99), percentile(v, 100));
+}
+
+/**
+ * @brief Main function
+ * @param [in] argc the count of command line arguments
+ * @param [in] argv the command line arguments
+ */
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    {"meas-rate", required_argument, NULL, 'm'},
+    {"duration", required_argument, NULL, 't'},
+    {"warmup", required_argument, NULL, 'w'},
+    {"output", required_argument, NULL, 'o'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+  };
+  uint16_t meas_rate = 25;
+  double duration = 10.0;
+  double warmup = 1.0;
+  const char * output = nullptr;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "m:t:w:o:h", options, NULL)) != -1) {
+    switch (opt) {
+      case 'm':
+        meas_rate = atoi(optarg);
+        break;
+      case 't':
+        duration = atof(optarg);
+        break;
+      case 'w':
+        warmup = atof(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      case 'h':
+        usage(argv[0]);
+        return EXIT_SUCCESS;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (meas_rate == 0 || duration <= 0.0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // UART1 is required and stays silent, USB carries the load without a baud rate limit
+  std::string uart1_name;
+  std::string usb_name;
+  int uart1 = openPty(uart1_name);
+  int usb = openPty(usb_name);
+  if (uart1 < 0 || usb < 0) {
+    perror("posix_openpt");
+    return EXIT_FAILURE;
+  }
+  setDeviceName(uart1_name.c_str());
+  setUsbDeviceName(usb_name.c_str());
+  if (start() != 0) return EXIT_FAILURE;
+
+  static READER r;
+  Clock::duration period = std::chrono::milliseconds(meas_rate);
+  r.fd_ = usb;
+  r.gap_ = std::min<Clock::duration>(period / 2, std::chrono::milliseconds(50));
+  pthread_t th;
+  pthread_create(&th, nullptr, reader, &r);
+
+  // Navigation rate, and every periodic message at every epoch on USB
+  uint8_t rate[] = {
+    static_cast<uint8_t>(meas_rate & 0xFF), static_cast<uint8_t>(meas_rate >> 8), 1, 0, 1, 0};
+  writeUbx(usb, 0x06, 0x08, rate, sizeof(rate));
+  uint32_t requests = 0;
+  for (auto c : sweep_classes) {
+    for (int id = 0; id <= 0xFF; ++id) {
+      uint8_t msg[] = {c, static_cast<uint8_t>(id), 1};
+      writeUbx(usb, 0x06, 0x01, msg, sizeof(msg));
+      ++requests;
+    }
+  }
+  Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+  while (r.acks_ + r.naks_ < requests && Clock::now() < deadline) usleep(10000);
+  usleep(static_cast<useconds_t>(warmup * 1e6));
+
+  // Measure simulator in every thread but the reader
+  struct rusage u[2];
+  uint64_t allocs[2];
+  Clock::time_point t[2];
+  getrusage(RUSAGE_SELF, &u[0]);
+  allocs[0] = allocations.load();
+  t[0] = Clock::now();
+  r.phase_ = 1;
+  usleep(static_cast<useconds_t>(duration * 1e6));
+  r.phase_ = 2;
+  getrusage(RUSAGE_SELF, &u[1]);
+  allocs[1] = allocations.load();
+  t[1] = Clock::now();
+  pthread_join(th, nullptr);
+  stop();
+  close(uart1);
+  close(usb);
+
+  // Bursts of sensor samples alone are sent between epochs
+  std::vector<BURST> bursts;
+  uint64_t messages = 0;
+  uint64_t bytes = 0;
+  for (const auto & b : r.bursts_) {
+    messages += b.messages_;
+    bytes += b.bytes_;
+    if (!std::all_of(b.keys_.begin(), b.keys_.end(), isSparse)) bursts.push_back(b);
+  }
+
+  // Epochs start on a grid of the period, its phase being that of the burst which started
+  // earliest relative to it
+  std::vector<double> latencies;
+  std::vector<double> jitters;
+  if (!bursts.empty()) {
+    Clock::time_point origin = bursts.front().first_;
+    std::vector<int64_t> epochs;
+    Clock::duration phase = Clock::duration::max();
+    for (const auto & b : bursts) {
+      int64_t k = ((b.first_ - origin) + period / 2) / period;
+      epochs.push_back(k);
+      phase = std::min(phase, (b.first_ - origin) - k * period);
+    }
+    for (std::size_t i = 0; i < bursts.size(); ++i) {
+      const BURST & b = bursts[i];
+      Clock::time_point start = origin + epochs[i] * period + phase;
+      latencies.push_back(std::chrono::duration<double, std::micro>(b.last_ - start).count());
+      if (i > 0) {
+        Clock::duration d = b.first_ - bursts[i - 1].first_;
+        d -= (epochs[i] - epochs[i - 1]) * period;
+        jitters.push_back(std::abs(std::chrono::duration<double, std::micro>(d).count()));
+      }
+    }
+  }
+
+  // Messages received in most epochs are expected in every one, except those not sent in every
+  // epoch, whose samples are expected on the grid of the shortest timeTag step
+  std::map<uint32_t, std::size_t> received;
+  for (const auto & b : bursts) {
+    for (auto key : b.keys_) ++received[key];
+  }
+  uint64_t dropped = 0;
+  for (const auto & k : received) {
+    if (!isSparse(k.first) && 2 * k.second > bursts.size()) dropped += bursts.size() - k.second;
+  }
+  uint32_t step = UINT32_MAX;
+  for (std::size_t i = 1; i < r.tags_.size(); ++i) {
+    if (r.tags_[i] > r.tags_[i - 1]) step = std::min(step, r.tags_[i] - r.tags_[i - 1]);
+  }
+  for (std::size_t i = 1; i < r.tags_.size(); ++i) {
+    if (r.tags_[i] > r.tags_[i - 1]) dropped += (r.tags_[i] - r.tags_[i - 1]) / step - 1;
+  }
+
+  struct timeval cpu[2];
+  struct timeval reader_cpu;
+  struct timeval busy;
+  timeradd(&u[0].ru_utime, &u[0].ru_stime, &cpu[0]);
+  timeradd(&u[1].ru_utime, &u[1].ru_stime, &cpu[1]);
+  timersub(&cpu[1], &cpu[0], &busy);
+  timersub(&r.cpu_[1], &r.cpu_[0], &reader_cpu);
+  timersub(&busy, &reader_cpu, &busy);
+  double seconds = std::chrono::duration<double>(t[1] - t[0]).count();
+  double epochs = std::max<std::size_t>(bursts.size(), 1);
+
+  FILE * out = (output != nullptr) ? fopen(output, "w") : stdout;
+  if (out == nullptr) {
+    perror(output);
+    return EXIT_FAILURE;
+  }
+  fprintf(out, "{\n");
+  fprintf(out, "  \"meas_rate_ms\": %u,\n", meas_rate);
+  fprintf(out, "  \"duration_s\": %.3f,\n", seconds);
+  fprintf(out, "  \"messages_enabled\": %u,\n", r.acks_.load());
+  fprintf(out, "  \"epochs\": %zu,\n", bursts.size());
+  fprintf(out, "  \"epochs_expected\": %.0f,\n", seconds * 1000.0 / meas_rate);
+  fprintf(out, "  \"messages\": %" PRIu64 ",\n", messages);
+  fprintf(out, "  \"messages_per_s\": %.1f,\n", messages / seconds);
+  fprintf(out, "  \"bytes_per_s\": %.1f,\n", bytes / seconds);
+  fprintf(out, "  \"nmea_checksum_errors\": %" PRIu64 ",\n", r.nmea_errors_);
+  fprintf(out, "  \"dropped_messages\": %" PRIu64 ",\n", dropped);
+  fprintf(out, "  \"overflow_reports\": %" PRIu64 ",\n", r.overflows_);
+  writePercentiles(out, "latency_us", latencies);
+  writePercentiles(out, "jitter_us", jitters);
+  fprintf(out, "  \"cpu_us_per_epoch\": %.1f,\n", (busy.tv_sec * 1e6 + busy.tv_usec) / epochs);
+  fprintf(out, "  \"allocations_per_epoch\": %.2f\n", (allocs[1] - allocs[0]) / epochs);
+  fprintf(out, "}\n");
+  if (out != stdout) fclose(out);
+
+  // Output which does not keep up with the load fails the run
+  return (dropped > 0 || r.overflows_ > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
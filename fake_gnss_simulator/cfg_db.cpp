@@ -0,0 +1,127 @@
+/**
+ * @file cfg_db.cpp
+ * @brief Layered configuration database of generation 9 receivers
+ */
+
+#include <cfg_db.h>
+#include <algorithm>
+
+static constexpr uint32_t ITEM_MASK = 0x00000FFF;     //!< @brief item ID bits of key
+static constexpr uint32_t WILDCARD_ALL = 0x0FFFFFFF;  //!< @brief key matching all items
+static constexpr int LAYERS = 3;                      //!< @brief RAM, BBR and flash
+
+std::size_t CfgDb::valueSize(uint32_t key)
+{
+  // One bit values take a byte in messages
+  static const std::size_t sizes[8] = {0, 1, 1, 2, 4, 8, 0, 0};
+  return sizes[(key >> 28) & 0x07];
+}
+
+void CfgDb::add(uint32_t key, uint64_t value, uint64_t min, uint64_t max)
+{
+  Item item = {{value, value, value}, value, min, max, 0};
+
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  std::size_t i = it - keys_.begin();
+  if (it != keys_.end() && *it == key) {
+    items_[i] = item;
+  } else {
+    keys_.insert(it, key);
+    items_.insert(items_.begin() + i, item);
+  }
+}
+
+void CfgDb::reset(void)
+{
+  for (auto & item : items_) {
+    if (item.stored_ & LAYER_BBR) {
+      item.value_[RAM] = item.value_[BBR];
+    } else if (item.stored_ & LAYER_FLASH) {
+      item.value_[RAM] = item.value_[FLASH];
+    } else {
+      item.value_[RAM] = item.default_;
+    }
+  }
+  changes_.clear();
+}
+
+uint64_t CfgDb::get(uint32_t key) const
+{
+  std::size_t i = find(key);
+  return (i < keys_.size()) ? items_[i].value_[RAM] : 0;
+}
+
+bool CfgDb::select(uint32_t key, Layer layer, std::vector<Value> & values) const
+{
+  bool all = (key & WILDCARD_ALL) == WILDCARD_ALL;
+  bool group = (key & ITEM_MASK) == ITEM_MASK;
+  std::size_t begin = find(key);
+  std::size_t end = begin + 1;
+  if (all || group) {
+    begin = 0;
+    end = keys_.size();
+  } else if (begin == keys_.size()) {
+    return false;
+  }
+
+  for (std::size_t i = begin; i < end; ++i) {
+    // Group ID is bits 16-23
+    if (group && !all && ((keys_[i] ^ key) & 0x00FF0000) != 0) continue;
+    const Item & item = items_[i];
+    switch (layer) {
+      case RAM:
+        values.push_back({keys_[i], item.value_[RAM]});
+        break;
+      case BBR:
+      case FLASH:
+        if (item.stored_ & (1 << layer)) values.push_back({keys_[i], item.value_[layer]});
+        break;
+      case DEFAULT:
+        values.push_back({keys_[i], item.default_});
+        break;
+    }
+  }
+  return true;
+}
+
+bool CfgDb::set(uint32_t key, uint64_t value, uint8_t layers)
+{
+  std::size_t i = find(key);
+  if (i == keys_.size() || (layers & (LAYER_RAM | LAYER_BBR | LAYER_FLASH)) == 0) return false;
+  if (value < items_[i].min_ || value > items_[i].max_) return false;
+
+  changes_.push_back({i, value, layers, false});
+  return true;
+}
+
+bool CfgDb::del(uint32_t key, uint8_t layers)
+{
+  std::size_t i = find(key);
+  if (i == keys_.size() || (layers & (LAYER_BBR | LAYER_FLASH)) == 0) return false;
+  if ((layers & ~(LAYER_BBR | LAYER_FLASH)) != 0) return false;
+
+  changes_.push_back({i, 0, layers, true});
+  return true;
+}
+
+void CfgDb::commit(void)
+{
+  for (const auto & c : changes_) {
+    Item & item = items_[c.index_];
+    if (c.delete_) {
+      item.stored_ &= ~c.layers_;
+      continue;
+    }
+    for (int l = 0; l < LAYERS; ++l) {
+      if (c.layers_ & (1 << l)) item.value_[l] = c.value_;
+    }
+    item.stored_ |= c.layers_ & (LAYER_BBR | LAYER_FLASH);
+  }
+  changes_.clear();
+}
+
+std::size_t CfgDb::find(uint32_t key) const
+{
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  return (it != keys_.end() && *it == key) ? it - keys_.begin() : keys_.size();
+}
@@ -0,0 +1,140 @@
+#ifndef FAKE_GNSS_SIMULATOR_CFG_DB_H_
+#define FAKE_GNSS_SIMULATOR_CFG_DB_H_
+
+/**
+ * @file cfg_db.h
+ * @brief Layered configuration database of generation 9 receivers
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class CfgDb
+{
+public:
+  /**
+   * @brief Layer to read from, as in UBX-CFG-VALGET
+   */
+  enum Layer {
+    RAM = 0,      //!< @brief current configuration
+    BBR = 1,      //!< @brief battery backed RAM
+    FLASH = 2,    //!< @brief flash
+    DEFAULT = 7,  //!< @brief default configuration
+  };
+
+  static constexpr uint8_t LAYER_RAM = 0x01;    //!< @brief RAM bit of layers to write
+  static constexpr uint8_t LAYER_BBR = 0x02;    //!< @brief BBR bit of layers to write
+  static constexpr uint8_t LAYER_FLASH = 0x04;  //!< @brief flash bit of layers to write
+
+  typedef std::pair<uint32_t, uint64_t> Value;  //!< @brief key and value
+
+  /**
+   * @brief Get size of value from key
+   * @param[in] key key ID
+   * @return size of value in bytes, 0 if the size field is invalid
+   */
+  static std::size_t valueSize(uint32_t key);
+
+  /**
+   * @brief Add configuration item, replacing the one with the same key
+   * @param[in] key key ID
+   * @param[in] value default value, also loaded to RAM
+   * @param[in] min minimum value accepted
+   * @param[in] max maximum value accepted
+   */
+  void add(uint32_t key, uint64_t value, uint64_t min, uint64_t max);
+
+  /**
+   * @brief Load RAM from BBR, flash or default in this order, as on power up
+   */
+  void reset(void);
+
+  /**
+   * @brief Check if key is known
+   * @param[in] key key ID
+   * @return true if key is known
+   */
+  bool contains(uint32_t key) const { return find(key) < keys_.size(); }
+
+  /**
+   * @brief Get current value
+   * @param[in] key key ID
+   * @return value in RAM, 0 if key is unknown
+   */
+  uint64_t get(uint32_t key) const;
+
+  /**
+   * @brief Get values matching a key, which may be a group or all wildcard
+   * @param[in] key key ID, item ID 0xFFF for all items of group, 0x0FFFFFFF for all items
+   * @param[in] layer layer to read from
+   * @param[out] values values appended in key order, skipping ones not stored in layer
+   * @return false if key is neither known nor a wildcard
+   */
+  bool select(uint32_t key, Layer layer, std::vector<Value> & values) const;
+
+  /**
+   * @brief Stage value to write on commit
+   * @param[in] key key ID
+   * @param[in] value value
+   * @param[in] layers LAYER_* bits to write to
+   * @return false if key is unknown, value is out of range or no layer is given
+   */
+  bool set(uint32_t key, uint64_t value, uint8_t layers);
+
+  /**
+   * @brief Stage deletion of value on commit
+   * @param[in] key key ID
+   * @param[in] layers LAYER_BBR and/or LAYER_FLASH to delete from
+   * @return false if key is unknown or layers are invalid
+   */
+  bool del(uint32_t key, uint8_t layers);
+
+  /**
+   * @brief Apply staged changes at once
+   */
+  void commit(void);
+
+  /**
+   * @brief Discard staged changes
+   */
+  void rollback(void) { changes_.clear(); }
+
+private:
+  /**
+   * @brief Values of item
+   */
+  struct Item
+  {
+    uint64_t value_[3];  //!< @brief values in RAM, BBR and flash
+    uint64_t default_;   //!< @brief default value
+    uint64_t min_;       //!< @brief minimum value
+    uint64_t max_;       //!< @brief maximum value
+    uint8_t stored_;     //!< @brief LAYER_BBR and LAYER_FLASH bits holding a value
+  };
+
+  /**
+   * @brief Staged change
+   */
+  struct Change
+  {
+    std::size_t index_;  //!< @brief index of item
+    uint64_t value_;     //!< @brief value to write
+    uint8_t layers_;     //!< @brief LAYER_* bits to write to, or delete from
+    bool delete_;        //!< @brief deletion or not
+  };
+
+  /**
+   * @brief Find item
+   * @param[in] key key ID
+   * @return index of item, size of index if key is unknown
+   */
+  std::size_t find(uint32_t key) const;
+
+  std::vector<uint32_t> keys_;   //!< @brief sorted keys, searched without touching values
+  std::vector<Item> items_;      //!< @brief items in the same order as keys
+  std::vector<Change> changes_;  //!< @brief changes staged until commit
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_CFG_DB_H_
@@ -0,0 +1,324 @@
+/**
+ * @file constellation.cpp
+ * @brief Satellite orbits from almanac, and their geometry seen from the receiver
+ */
+
+#include <constellation.h>
+#include <csv_reader.h>
+#include <nav_solution.h>
+#include <cerrno>
+#include <cmath>
+#include <iostream>
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr double GM = 3.986005e14;              //!< @brief gravitational constant [m^3/s^2]
+static constexpr double OMEGA_E = 7.2921151467e-5;     //!< @brief earth rotation rate [rad/s]
+static constexpr double SPEED_OF_LIGHT = 299792458.0;  //!< @brief speed of light [m/s]
+static constexpr int KEPLER_ITERATIONS = 8;            //!< @brief enough for eccentricity < 0.05
+static constexpr double TRAVEL_TIME = 0.075;           //!< @brief first guess of signal travel [s]
+static constexpr double VELOCITY_STEP = 0.01;          //!< @brief step of satellite velocity [s]
+static constexpr double ELEVATION_MASK = 10.0;         //!< @brief lowest elevation tracked [deg]
+static constexpr double TRACK_CNO = 20.0;              //!< @brief weakest signal tracked [dBHz]
+static constexpr double LOCK_CNO = 28.0;               //!< @brief weakest carrier phase lock [dBHz]
+
+// Link budget giving about 47 dBHz at zenith and 39 dBHz at the elevation mask
+static constexpr double EIRP = 57.0;             //!< @brief transmitted power [dBm]
+static constexpr double RX_LOSS = 2.0;           //!< @brief cable and implementation loss [dB]
+static constexpr double NOISE_DENSITY = -172.0;  //!< @brief N0 with 2 dB noise figure [dBm/Hz]
+
+static constexpr double L1 = 1575.42e6;        //!< @brief GPS L1 and Galileo E1 [Hz]
+static constexpr double B1I = 1561.098e6;      //!< @brief BeiDou B1I [Hz]
+static constexpr double L1OF = 1602.0e6;       //!< @brief GLONASS L1 of channel 0 [Hz]
+static constexpr double L1OF_STEP = 0.5625e6;  //!< @brief GLONASS L1 channel spacing [Hz]
+
+int Constellation::load(const char * path)
+{
+  clear();
+
+  CsvReader csv;
+  int ret = csv.open(path);
+  if (ret != 0) return ret;
+
+  double v[14];
+  int n;
+  while ((n = csv.next(v, 13, 14)) > 0) {
+    uint8_t gnss = v[0];
+    if (gnss != GNSS_ID_GPS && gnss != GNSS_ID_GALILEO && gnss != GNSS_ID_BEIDOU &&
+        gnss != GNSS_ID_GLONASS) {
+      csv.reject("unsupported gnssId");
+      continue;
+    }
+    if (size() >= MAX_SATELLITES) {
+      csv.reject("too many satellites");
+      break;
+    }
+    Elements e = {static_cast<uint16_t>(v[2]), v[3], v[4], v[5], v[6] * DEG_TO_RAD,
+                  v[7] * DEG_TO_RAD, v[8] * DEG_TO_RAD, v[9] * DEG_TO_RAD, v[10] * DEG_TO_RAD,
+                  v[11], v[12]};
+    add(gnss, v[1], (n > 13) ? static_cast<int>(v[13]) : 0, e);
+  }
+
+  if (size() == 0) {
+    std::cerr << path << ": no satellite found" << std::endl;
+    return EINVAL;
+  }
+  return 0;
+}
+
+void Constellation::setDefault(uint16_t week, double toa)
+{
+  // Walker constellations with one slot of phasing between adjacent planes
+  static const struct
+  {
+    uint8_t gnssId_;  //!< @brief GNSS identifier
+    int planes_;      //!< @brief number of orbital planes
+    int slots_;       //!< @brief satellites per plane
+    double a_;        //!< @brief semi-major axis [m]
+    double i0_;       //!< @brief inclination [deg]
+  } walkers[] = {
+    {GNSS_ID_GPS, 6, 4, 26559.7e3, 55.0},
+    {GNSS_ID_GLONASS, 3, 8, 25510.0e3, 64.8},
+    {GNSS_ID_GALILEO, 3, 8, 29600.0e3, 56.0},
+    {GNSS_ID_BEIDOU, 3, 8, 27906.0e3, 55.0},
+  };
+  // Frequency channels of GLONASS by slot, antipodal satellites sharing one
+  static const int channels[] = {1,  -4, 5,  6, 1,  -4, 5, 6, -2, -7, 0, -1,
+                                 -2, -7, 0, -1, 4, -3, 3, 2, 4,  -3, 3, 2};
+
+  clear();
+  for (const auto & w : walkers) {
+    int n = w.planes_ * w.slots_;
+    for (int k = 0; k < n; ++k) {
+      int plane = k / w.slots_;
+      int slot = k % w.slots_;
+      Elements e;
+      e.week_ = week;
+      e.toa_ = toa;
+      e.sqrtA_ = std::sqrt(w.a_);
+      e.e_ = 0.005;
+      e.i0_ = w.i0_ * DEG_TO_RAD;
+      e.omega0_ = 2.0 * M_PI * plane / w.planes_;
+      e.omegaDot_ = -8.0e-9;
+      e.omega_ = 0.0;
+      e.m0_ = 2.0 * M_PI * (slot + static_cast<double>(plane) / w.planes_) / w.slots_;
+      // Satellite clocks are off by up to 0.3 ms, differently for each satellite
+      e.af0_ = ((k * 37) % 61 - 30) * 1e-5;
+      e.af1_ = ((k * 11) % 7 - 3) * 1e-12;
+      add(w.gnssId_, k + 1, channels[k % 24], e);
+    }
+  }
+}
+
+void Constellation::elements(std::size_t i, uint16_t week, double toe, Elements & e) const
+{
+  // Same orbit, with the anomaly, node and clock advanced to the new reference time
+  double start = week * WEEK;
+  double dt = start + toe - t0_[i];
+  e.week_ = week;
+  e.toa_ = toe;
+  e.sqrtA_ = std::sqrt(a_[i]);
+  e.e_ = e_[i];
+  e.i0_ = i0_[i];
+  e.omega0_ =
+    std::remainder(omega0_[i] + omegaDot_[i] * dt - OMEGA_E * (start - week0_[i]), 2 * M_PI);
+  e.omegaDot_ = omegaDot_[i];
+  e.omega_ = omega_[i];
+  e.m0_ = std::remainder(m0_[i] + n_[i] * dt, 2 * M_PI);
+  e.af0_ = af0_[i] + af1_[i] * dt;
+  e.af1_ = af1_[i];
+}
+
+void Constellation::observe(
+  double t, const double pos[3], const double vel[3], double lat, double lon, Sky & sky) const
+{
+  std::size_t n = size();
+  double tt[MAX_SATELLITES], tau[MAX_SATELLITES];
+  double x[MAX_SATELLITES], y[MAX_SATELLITES], z[MAX_SATELLITES];
+  double x1[MAX_SATELLITES], y1[MAX_SATELLITES], z1[MAX_SATELLITES];
+
+  // Signals leave satellites one travel time before reception
+  for (std::size_t i = 0; i < n; ++i) tt[i] = t - TRAVEL_TIME;
+  propagate(tt, x, y, z);
+  for (std::size_t i = 0; i < n; ++i) {
+    double dx = x[i] - pos[0];
+    double dy = y[i] - pos[1];
+    double dz = z[i] - pos[2];
+    tau[i] = std::sqrt(dx * dx + dy * dy + dz * dz) / SPEED_OF_LIGHT;
+    tt[i] = t - tau[i];
+  }
+  propagate(tt, x, y, z);
+  for (std::size_t i = 0; i < n; ++i) tt[i] += VELOCITY_STEP;
+  propagate(tt, x1, y1, z1);
+
+  double sin_lat = std::sin(lat);
+  double cos_lat = std::cos(lat);
+  double sin_lon = std::sin(lon);
+  double cos_lon = std::cos(lon);
+  sky.n_ = n;
+  for (std::size_t i = 0; i < n; ++i) {
+    // Earth rotates while signals travel
+    double theta = OMEGA_E * tau[i];
+    double c = std::cos(theta);
+    double s = std::sin(theta);
+    double sx = c * x[i] + s * y[i];
+    double sy = -s * x[i] + c * y[i];
+    double vx = (c * x1[i] + s * y1[i] - sx) / VELOCITY_STEP;
+    double vy = (-s * x1[i] + c * y1[i] - sy) / VELOCITY_STEP;
+    double vz = (z1[i] - z[i]) / VELOCITY_STEP;
+
+    double dx = sx - pos[0];
+    double dy = sy - pos[1];
+    double dz = z[i] - pos[2];
+    double range = std::sqrt(dx * dx + dy * dy + dz * dz);
+    double ux = dx / range;
+    double uy = dy / range;
+    double uz = dz / range;
+    sky.range_[i] = range;
+    sky.rate_[i] = ux * (vx - vel[0]) + uy * (vy - vel[1]) + uz * (vz - vel[2]);
+    sky.clock_[i] = af0_[i] + af1_[i] * (tt[i] - t0_[i]);
+
+    double north = -sin_lat * cos_lon * ux - sin_lat * sin_lon * uy + cos_lat * uz;
+    double east = -sin_lon * ux + cos_lon * uy;
+    double up = cos_lat * cos_lon * ux + cos_lat * sin_lon * uy + sin_lat * uz;
+    double elev = std::asin(up);
+    double azim = std::atan2(east, north) / DEG_TO_RAD;
+    sky.elev_[i] = elev / DEG_TO_RAD;
+    sky.azim_[i] = azim + 360.0 * (azim < 0);
+
+    // Free space loss, and antenna gain from -5 dBi at horizon to 3 dBi at zenith
+    double loss = 20.0 * std::log10(4.0 * M_PI * range * freq_[i] / SPEED_OF_LIGHT);
+    double gain = -5.0 + 8.0 * std::sin(elev);
+    sky.cno_[i] = EIRP - loss + gain - RX_LOSS - NOISE_DENSITY;
+  }
+  track(sky);
+}
+
+void Constellation::track(Sky & sky)
+{
+  // Quality is 0 below horizon, 1 searching, 4 code locked and 7 carrier locked
+  for (std::size_t i = 0; i < sky.n_; ++i) {
+    uint8_t above = sky.elev_[i] >= 0.0;
+    uint8_t tracked = (sky.elev_[i] >= ELEVATION_MASK) & (sky.cno_[i] >= TRACK_CNO);
+    uint8_t locked = tracked & (sky.cno_[i] >= LOCK_CNO);
+    sky.visible_[i] = tracked;
+    sky.quality_[i] = above + 3 * tracked + 3 * locked;
+    sky.used_[i] = locked;
+  }
+}
+
+bool Constellation::dop(const Sky & sky, double & pdop, double & hdop, double & vdop)
+{
+  // Normal matrix of east, north, up and clock, summed over satellites used
+  double q[4][4] = {};
+  int used = 0;
+  for (std::size_t i = 0; i < sky.n_; ++i) {
+    double el = sky.elev_[i] * DEG_TO_RAD;
+    double az = sky.azim_[i] * DEG_TO_RAD;
+    double w = sky.used_[i];
+    double g[4] = {std::cos(el) * std::sin(az), std::cos(el) * std::cos(az), std::sin(el), 1.0};
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) q[r][c] += w * g[r] * g[c];
+    }
+    used += sky.used_[i];
+  }
+  if (used < 4) return false;
+
+  // Gauss-Jordan elimination, which needs no pivoting as the matrix is positive definite
+  double inv[4][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+  for (int k = 0; k < 4; ++k) {
+    double pivot = q[k][k];
+    if (pivot < 1e-9) return false;
+    for (int c = 0; c < 4; ++c) {
+      q[k][c] /= pivot;
+      inv[k][c] /= pivot;
+    }
+    for (int r = 0; r < 4; ++r) {
+      if (r == k) continue;
+      double f = q[r][k];
+      for (int c = 0; c < 4; ++c) {
+        q[r][c] -= f * q[k][c];
+        inv[r][c] -= f * inv[k][c];
+      }
+    }
+  }
+  pdop = std::sqrt(inv[0][0] + inv[1][1] + inv[2][2]);
+  hdop = std::sqrt(inv[0][0] + inv[1][1]);
+  vdop = std::sqrt(inv[2][2]);
+  return true;
+}
+
+void Constellation::add(uint8_t gnssId, uint8_t svId, int channel, const Elements & e)
+{
+  double a = e.sqrtA_ * e.sqrtA_;
+  gnssId_.push_back(gnssId);
+  svId_.push_back(svId);
+  if (gnssId == GNSS_ID_GLONASS) {
+    freqId_.push_back(channel + 7);
+    freq_.push_back(L1OF + channel * L1OF_STEP);
+  } else {
+    freqId_.push_back(0);
+    freq_.push_back((gnssId == GNSS_ID_BEIDOU) ? B1I : L1);
+  }
+  week0_.push_back(e.week_ * WEEK);
+  t0_.push_back(e.week_ * WEEK + e.toa_);
+  a_.push_back(a);
+  n_.push_back(std::sqrt(GM / (a * a * a)));
+  e_.push_back(e.e_);
+  i0_.push_back(e.i0_);
+  omega0_.push_back(e.omega0_);
+  omegaDot_.push_back(e.omegaDot_);
+  omega_.push_back(e.omega_);
+  m0_.push_back(e.m0_);
+  af0_.push_back(e.af0_);
+  af1_.push_back(e.af1_);
+}
+
+void Constellation::clear(void)
+{
+  gnssId_.clear();
+  svId_.clear();
+  freqId_.clear();
+  freq_.clear();
+  t0_.clear();
+  week0_.clear();
+  a_.clear();
+  n_.clear();
+  e_.clear();
+  i0_.clear();
+  omega0_.clear();
+  omegaDot_.clear();
+  omega_.clear();
+  m0_.clear();
+  af0_.clear();
+  af1_.clear();
+}
+
+void Constellation::propagate(const double * t, double * x, double * y, double * z) const
+{
+  std::size_t n = size();
+  for (std::size_t i = 0; i < n; ++i) {
+    // Kepler's equation by a fixed number of iterations
+    double tk = t[i] - t0_[i];
+    double mk = std::remainder(m0_[i] + n_[i] * tk, 2 * M_PI);
+    double ek = mk;
+    for (int k = 0; k < KEPLER_ITERATIONS; ++k) ek = mk + e_[i] * std::sin(ek);
+
+    double sin_e = std::sin(ek);
+    double cos_e = std::cos(ek);
+    double v = std::atan2(std::sqrt(1.0 - e_[i] * e_[i]) * sin_e, cos_e - e_[i]);
+    double u = v + omega_[i];
+    double r = a_[i] * (1.0 - e_[i] * cos_e);
+    double xp = r * std::cos(u);
+    double yp = r * std::sin(u);
+
+    // Node drifts, and earth rotates from the start of week of reference time
+    double node = omega0_[i] + omegaDot_[i] * tk - OMEGA_E * (t[i] - week0_[i]);
+    double sin_n = std::sin(node);
+    double cos_n = std::cos(node);
+    double sin_i = std::sin(i0_[i]);
+    double cos_i = std::cos(i0_[i]);
+    x[i] = xp * cos_n - yp * cos_i * sin_n;
+    y[i] = xp * sin_n + yp * cos_i * cos_n;
+    z[i] = yp * sin_i;
+  }
+}
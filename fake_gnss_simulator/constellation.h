@@ -0,0 +1,186 @@
+#ifndef FAKE_GNSS_SIMULATOR_CONSTELLATION_H_
+#define FAKE_GNSS_SIMULATOR_CONSTELLATION_H_
+
+/**
+ * @file constellation.h
+ * @brief Satellite orbits from almanac, and their geometry seen from the receiver
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Constellation
+{
+public:
+  static constexpr std::size_t MAX_SATELLITES = 128;  //!< @brief largest number of satellites
+  static constexpr double WEEK = 604800.0;            //!< @brief seconds of GPS week
+
+  /**
+   * @brief Orbit and clock of satellite, angles in radians
+   */
+  struct Elements
+  {
+    uint16_t week_;    //!< @brief GPS week of reference time
+    double toa_;       //!< @brief reference time, time of week [s]
+    double sqrtA_;     //!< @brief square root of semi-major axis [m^0.5]
+    double e_;         //!< @brief eccentricity
+    double i0_;        //!< @brief inclination [rad]
+    double omega0_;    //!< @brief longitude of ascending node at the start of week [rad]
+    double omegaDot_;  //!< @brief rate of right ascension [rad/s]
+    double omega_;     //!< @brief argument of perigee [rad]
+    double m0_;        //!< @brief mean anomaly at reference time [rad]
+    double af0_;       //!< @brief clock bias at reference time [s]
+    double af1_;       //!< @brief clock drift [s/s]
+  };
+
+  /**
+   * @brief Geometry of all satellites at an epoch
+   */
+  struct Sky
+  {
+    std::size_t n_;                    //!< @brief number of satellites
+    double range_[MAX_SATELLITES];     //!< @brief geometric range at transmission [m]
+    double rate_[MAX_SATELLITES];      //!< @brief range rate [m/s]
+    double clock_[MAX_SATELLITES];     //!< @brief satellite clock bias [s]
+    double elev_[MAX_SATELLITES];      //!< @brief elevation [deg]
+    double azim_[MAX_SATELLITES];      //!< @brief azimuth [deg]
+    double cno_[MAX_SATELLITES];       //!< @brief carrier to noise ratio [dBHz]
+    uint8_t visible_[MAX_SATELLITES];  //!< @brief tracked, above elevation mask and strong enough
+    uint8_t quality_[MAX_SATELLITES];  //!< @brief signal quality indicator as in UBX-NAV-SAT
+    uint8_t used_[MAX_SATELLITES];     //!< @brief used in navigation solution
+  };
+
+  /**
+   * @brief Load almanac from CSV file
+   * @param[in] path path of file with lines of gnssId, svId, week, toa [s], sqrtA [m^0.5], e,
+   *                 i0 [deg], Omega0 [deg], OmegaDot [deg/s], omega [deg], M0 [deg], af0 [s],
+   *                 af1 [s/s], and optionally the frequency channel of GLONASS
+   * @return 0 on success, otherwise error
+   * @note Rows are read by CsvReader::next(), which skips a header
+   */
+  int load(const char * path);
+
+  /**
+   * @brief Set nominal constellations of GPS, GLONASS, Galileo and BeiDou
+   * @param[in] week GPS week of reference time
+   * @param[in] toa reference time, time of week [s]
+   */
+  void setDefault(uint16_t week, double toa);
+
+  /**
+   * @brief Get number of satellites
+   * @return number of satellites
+   */
+  std::size_t size(void) const { return gnssId_.size(); }
+
+  /**
+   * @brief Get GNSS identifier
+   * @param[in] i index of satellite
+   * @return GNSS identifier as in UBX
+   */
+  uint8_t gnssId(std::size_t i) const { return gnssId_[i]; }
+
+  /**
+   * @brief Get satellite identifier
+   * @param[in] i index of satellite
+   * @return satellite identifier as in UBX
+   */
+  uint8_t svId(std::size_t i) const { return svId_[i]; }
+
+  /**
+   * @brief Get frequency slot
+   * @param[in] i index of satellite
+   * @return frequency channel + 7 for GLONASS, 0 otherwise
+   */
+  uint8_t freqId(std::size_t i) const { return freqId_[i]; }
+
+  /**
+   * @brief Get carrier frequency of the signal tracked, L1 C/A, E1, B1I or L1OF
+   * @param[in] i index of satellite
+   * @return carrier frequency [Hz]
+   */
+  double frequency(std::size_t i) const { return freq_[i]; }
+
+  /**
+   * @brief Get orbit referred to another time, as broadcast ephemeris would be
+   * @param[in] i index of satellite
+   * @param[in] week GPS week of reference time
+   * @param[in] toe reference time, time of week [s]
+   * @param[out] e elements
+   */
+  void elements(std::size_t i, uint16_t week, double toe, Elements & e) const;
+
+  /**
+   * @brief Compute geometry of all satellites
+   * @param[in] t GPS time of reception [s since 1980-01-06]
+   * @param[in] pos ECEF position of receiver [m]
+   * @param[in] vel ECEF velocity of receiver [m/s]
+   * @param[in] lat latitude of receiver [rad]
+   * @param[in] lon longitude of receiver [rad]
+   * @param[out] sky geometry
+   */
+  void observe(
+    double t, const double pos[3], const double vel[3], double lat, double lon, Sky & sky) const;
+
+  /**
+   * @brief Decide tracking state of all satellites from elevation and C/N0
+   * @param[inout] sky geometry, of which visible_, quality_ and used_ are updated
+   * @note Satellites above the elevation mask are tracked from 20 dBHz and used from 28 dBHz, when
+   *       carrier phase is locked
+   */
+  static void track(Sky & sky);
+
+  /**
+   * @brief Compute dilution of precision of satellites used
+   * @param[in] sky geometry
+   * @param[out] pdop position DOP
+   * @param[out] hdop horizontal DOP
+   * @param[out] vdop vertical DOP
+   * @return false if fewer than 4 satellites are used or the geometry is singular
+   */
+  static bool dop(const Sky & sky, double & pdop, double & hdop, double & vdop);
+
+private:
+  /**
+   * @brief Add satellite
+   * @param[in] gnssId GNSS identifier
+   * @param[in] svId satellite identifier
+   * @param[in] channel frequency channel of GLONASS
+   * @param[in] e elements
+   */
+  void add(uint8_t gnssId, uint8_t svId, int channel, const Elements & e);
+
+  /**
+   * @brief Remove all satellites
+   */
+  void clear(void);
+
+  /**
+   * @brief Compute ECEF positions of all satellites
+   * @param[in] t GPS time [s since 1980-01-06] for each satellite
+   * @param[out] x ECEF x [m]
+   * @param[out] y ECEF y [m]
+   * @param[out] z ECEF z [m]
+   */
+  void propagate(const double * t, double * x, double * y, double * z) const;
+
+  std::vector<uint8_t> gnssId_;   //!< @brief GNSS identifiers
+  std::vector<uint8_t> svId_;     //!< @brief satellite identifiers
+  std::vector<uint8_t> freqId_;   //!< @brief frequency channels + 7 of GLONASS
+  std::vector<double> freq_;      //!< @brief carrier frequencies [Hz]
+  std::vector<double> t0_;        //!< @brief reference times [s since 1980-01-06]
+  std::vector<double> week0_;     //!< @brief starts of week of reference times [s since 1980-01-06]
+  std::vector<double> a_;         //!< @brief semi-major axes [m]
+  std::vector<double> n_;         //!< @brief mean motions [rad/s]
+  std::vector<double> e_;         //!< @brief eccentricities
+  std::vector<double> i0_;        //!< @brief inclinations [rad]
+  std::vector<double> omega0_;    //!< @brief longitudes of ascending node at start of week [rad]
+  std::vector<double> omegaDot_;  //!< @brief rates of right ascension [rad/s]
+  std::vector<double> omega_;     //!< @brief arguments of perigee [rad]
+  std::vector<double> m0_;        //!< @brief mean anomalies at reference times [rad]
+  std::vector<double> af0_;       //!< @brief clock biases at reference times [s]
+  std::vector<double> af1_;       //!< @brief clock drifts [s/s]
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_CONSTELLATION_H_
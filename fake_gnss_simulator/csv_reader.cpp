@@ -0,0 +1,60 @@
+/**
+ * @file csv_reader.cpp
+ * @brief Rows of numbers read from CSV files of scenarios
+ */
+
+#include <csv_reader.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+CsvReader::CsvReader() : path_(""), fp_(nullptr), line_(nullptr), capacity_(0), number_(0) {}
+
+CsvReader::~CsvReader()
+{
+  if (fp_ != nullptr) fclose(fp_);
+  free(line_);
+}
+
+int CsvReader::open(const char * path)
+{
+  path_ = path;
+  fp_ = fopen(path, "r");
+  if (fp_ == nullptr) {
+    int ret = errno;
+    std::cerr << path << ": " << strerror(ret) << std::endl;
+    return ret;
+  }
+  return 0;
+}
+
+int CsvReader::next(double * v, int min, int max)
+{
+  while (getline(&line_, &capacity_, fp_) >= 0) {
+    ++number_;
+
+    // Numbers are separated by commas and blanks
+    char * p = line_;
+    int n = 0;
+    for (; n < max; ++n) {
+      char * end;
+      v[n] = strtod(p, &end);
+      if (end == p) break;
+      p = end;
+      while (*p == ',' || *p == ' ' || *p == '\t') ++p;
+    }
+    if (n == 0) continue;
+    if (n < min || p[strspn(p, " \t\r\n")] != '\0') {
+      reject("malformed row");
+      continue;
+    }
+    return n;
+  }
+  return 0;
+}
+
+void CsvReader::reject(const std::string & reason) const
+{
+  std::cerr << path_ << ":" << number_ << ": " << reason << std::endl;
+}
@@ -0,0 +1,58 @@
+#ifndef FAKE_GNSS_SIMULATOR_CSV_READER_H_
+#define FAKE_GNSS_SIMULATOR_CSV_READER_H_
+
+/**
+ * @file csv_reader.h
+ * @brief Rows of numbers read from CSV files of scenarios
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+class CsvReader
+{
+public:
+  /**
+   * @brief Constructor
+   */
+  CsvReader();
+
+  /**
+   * @brief Destructor, closing the file
+   */
+  ~CsvReader();
+
+  /**
+   * @brief Open file
+   * @param[in] path path of file, kept until the reader is destroyed
+   * @return 0 on success, otherwise errno reported on stderr
+   */
+  int open(const char * path);
+
+  /**
+   * @brief Read the next row
+   * @param[out] v values of row
+   * @param[in] min number of values required
+   * @param[in] max number of values at most, size of v
+   * @return number of values, 0 at the end of file
+   * @note Lines which do not start with a number, such as a header, are skipped. Rows with fewer
+   *       values than required or with text after them are rejected.
+   */
+  int next(double * v, int min, int max);
+
+  /**
+   * @brief Report the row just read as rejected, with its line number, on stderr
+   * @param[in] reason reason of rejection
+   */
+  void reject(const std::string & reason) const;
+
+private:
+  const char * path_;     //!< @brief path of file
+  FILE * fp_;             //!< @brief file, null if not opened
+  char * line_;           //!< @brief line buffer, grown by getline()
+  std::size_t capacity_;  //!< @brief size of line buffer
+  int number_;            //!< @brief number of the line just read, from 1
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_CSV_READER_H_
@@ -36,6 +36,17 @@ typedef enum {
   PORT_ID_SPI,
 } PortId;
 
+typedef enum {
+  FAULT_DROP = 0,
+  FAULT_DUPLICATE,
+  FAULT_REORDER,
+  FAULT_TRUNCATE,
+  FAULT_LENGTH,
+  FAULT_GARBAGE,
+  FAULT_DELAY,
+  FAULT_TYPES,
+} FaultType;
+
 typedef struct
 {
   int port_enabled;
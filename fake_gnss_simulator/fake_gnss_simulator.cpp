@@ -4,49 +4,224 @@
  */
 
 #include <fake_gnss_simulator.h>
+#include <geodesy.h>
+#include <gps_lnav.h>
 #include <boost/bind.hpp>
 #include <boost/optional.hpp>
 #include <boost/process.hpp>
 #include <boost/property_tree/ini_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/thread.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
 
 namespace pt = boost::property_tree;
 
-static constexpr int MAX_SIZE = 1024;
-static constexpr int SLEEP_CNT_1MS = 1000;
-static constexpr int ADJUST_COUNT = 130;
 
 FakeGNSSSimulator * FakeGNSSSimulator::gnss_ = nullptr;
 
-std::map<UBX_ID, FakeGNSSSimulator::HANDLE_FUNC> FakeGNSSSimulator::handle_map_ = {
-  {{0x0A, 0x04}, &FakeGNSSSimulator::handleUbxMonVER},
-  {{0x06, 0x00}, &FakeGNSSSimulator::handleUbxCfgPRT},
-  {{0x06, 0x01}, &FakeGNSSSimulator::handleUbxCfgMSG},
+//! @brief Height above ellipsoid minus height above mean sea level at the default position [mm]
+static constexpr int32_t GEOID_SEPARATION = 46525;
+
+//! @brief Bytes written to serial port at once while transmit buffer drains
+static constexpr std::size_t DRAIN_CHUNK = 64;
+
+//! @brief Shortest interval of writes while transmit buffer drains
+static constexpr std::chrono::milliseconds MIN_DRAIN_TICK(1);
+
+//! @brief Transmit buffer of USB, which holds epochs of every message as it is not baud limited
+static constexpr std::size_t USB_TX_BUFFER_SIZE = 65536;
+
+//! @brief Longest interval of UBX-ESF-MEAS batches, which keeps 100 Hz of them within a UART
+static constexpr std::chrono::milliseconds SENSOR_PERIOD(100);
+
+//! @brief User equivalent range error, accuracy estimates being DOP times this [m]
+static constexpr double UERE = 5.6;
+
+//! @brief User equivalent range error by solution of RtkState, from standalone to fixed [m]
+static constexpr double RTK_UERE[] = {UERE, 0.8, 0.3, 0.02};
+
+//! @brief Accuracy of baseline by solution of RtkState, valid with carrier phase [0.1 mm]
+static constexpr uint32_t BASELINE_ACC[] = {0, 0, 2000, 100};
+
+//! @brief Upper bounds of lastCorrectionAge of UBX-NAV-PVT, code being the index + 1 [s]
+static constexpr double CORRECTION_AGES[] = {1, 2, 5, 10, 15, 20, 30, 45, 60, 90, 120};
+
+//! @brief DOP reported without fix [0.01]
+static constexpr uint16_t NO_FIX_DOP = 9999;
+
+//! @brief Largest number of GPS satellites sending subframes at once
+static constexpr std::size_t MAX_GPS_SATELLITES = 32;
+
+//! @brief UBX-RXM-SFRBX frame of a GPS subframe
+static constexpr std::size_t SFRBX_GPS_FRAME =
+  UbxFrame<UbxRxmSFRBX>::HEADER_SIZE + UbxRxmSFRBX::LENGTH +
+  UbxRxmSFRBX::WORD_SIZE * GPS_LNAV_WORDS + UbxFrame<UbxRxmSFRBX>::CHECKSUM_SIZE;
+
+//! @brief Time of week of ephemeris in subframes is refreshed every two hours [s]
+static constexpr uint32_t EPHEMERIS_INTERVAL = 7200;
+
+//! @brief Sensors of UBX-ESF-MEAS and UBX-ESF-STATUS: gyroscopes and accelerometers on x, y and z,
+//! and speed
+static const struct
+{
+  uint8_t type_;  //!< @brief data type
+  double scale_;  //!< @brief data field per unit, deg/s, m/s^2 or m/s
+} esf_sensors[] = {
+  {14, 4096}, {13, 4096}, {5, 4096}, {16, 1024}, {17, 1024}, {18, 1024}, {11, 1000},
+};
+
+//! @brief Number of sensors
+static constexpr std::size_t ESF_SENSORS = sizeof(esf_sensors) / sizeof(esf_sensors[0]);
+
+//! @brief UBX-ESF-MEAS frame of a sample of all sensors
+static constexpr std::size_t ESF_MEAS_FRAME =
+  UbxFrame<UbxEsfMEAS>::HEADER_SIZE + UbxEsfMEAS::LENGTH + UbxEsfMEAS::WORD_SIZE * ESF_SENSORS +
+  UbxFrame<UbxEsfMEAS>::CHECKSUM_SIZE;
+
+const FakeGNSSSimulator::UBX_MESSAGE FakeGNSSSimulator::message_list_[] = {
+  {{0x01, 0x03}, nullptr, &FakeGNSSSimulator::encodeUbxNavSTATUS, UbxNavSTATUS::LENGTH,
+   0x2091001A},
+  {{0x01, 0x07}, nullptr, &FakeGNSSSimulator::encodeUbxNavPVT, UbxNavPVT::LENGTH, 0x20910006},
+  {{0x01, 0x35}, nullptr, &FakeGNSSSimulator::encodeUbxNavSAT,
+   UbxNavSAT::LENGTH + UbxNavSAT::BLOCK_SIZE * Constellation::MAX_SATELLITES, 0x20910015},
+  {{0x01, 0x3C}, nullptr, &FakeGNSSSimulator::encodeUbxNavRELPOSNED, UbxNavRELPOSNED::LENGTH,
+   0x2091008D},
+  {{0x01, 0x43}, nullptr, &FakeGNSSSimulator::encodeUbxNavSIG,
+   UbxNavSIG::LENGTH + UbxNavSIG::BLOCK_SIZE * Constellation::MAX_SATELLITES, 0x20910345},
+  {{0x02, 0x13}, nullptr, &FakeGNSSSimulator::encodeUbxRxmSFRBX,
+   SFRBX_GPS_FRAME * MAX_GPS_SATELLITES, 0x20910231},
+  {{0x02, 0x15}, nullptr, &FakeGNSSSimulator::encodeUbxRxmRAWX,
+   UbxRxmRAWX::LENGTH + UbxRxmRAWX::BLOCK_SIZE * UbxRxmRAWX::MAX_MEAS, 0x209102A4},
+  {{0x02, 0x32}, nullptr, nullptr, 0, 0x20910268},
+  {{0x06, 0x00}, &FakeGNSSSimulator::handleUbxCfgPRT, nullptr, 0, 0},
+  {{0x06, 0x01}, &FakeGNSSSimulator::handleUbxCfgMSG, nullptr, 0, 0},
+  {{0x06, 0x04}, &FakeGNSSSimulator::handleUbxCfgRST, nullptr, 0, 0},
+  {{0x06, 0x08}, &FakeGNSSSimulator::handleUbxCfgRATE, nullptr, 0, 0},
+  {{0x06, 0x8A}, &FakeGNSSSimulator::handleUbxCfgVALSET, nullptr, 0, 0},
+  {{0x06, 0x8B}, &FakeGNSSSimulator::handleUbxCfgVALGET, nullptr, 0, 0},
+  {{0x06, 0x8C}, &FakeGNSSSimulator::handleUbxCfgVALDEL, nullptr, 0, 0},
+  {{0x0A, 0x04}, &FakeGNSSSimulator::handleUbxMonVER, nullptr, 0, 0},
+  {{0x0A, 0x09}, nullptr, &FakeGNSSSimulator::encodeUbxMonHW, UbxMonHW::LENGTH, 0x209101B4},
+  {{0x0A, 0x36}, nullptr, &FakeGNSSSimulator::encodeUbxMonCOMMS,
+   UbxMonCOMMS::LENGTH + UbxMonCOMMS::BLOCK_SIZE * UbxMonCOMMS::MAX_PORTS, 0x2091034F},
+  {{0x10, 0x02}, nullptr, &FakeGNSSSimulator::encodeUbxEsfMEAS,
+   ESF_MEAS_FRAME * ImuModel::MAX_SAMPLES, 0x20910277},
+  {{0x10, 0x10}, nullptr, &FakeGNSSSimulator::encodeUbxEsfSTATUS,
+   UbxEsfSTATUS::LENGTH + UbxEsfSTATUS::BLOCK_SIZE * ESF_SENSORS, 0x20910105},
+  {{0x10, 0x15}, nullptr, &FakeGNSSSimulator::encodeUbxEsfINS, UbxEsfINS::LENGTH, 0x20910114},
+  {{0xF0, 0x00}, nullptr, &FakeGNSSSimulator::encodeNmea<nmeaGGA>, NMEA_MAX_SENTENCE, 0x209100BA},
+  {{0xF0, 0x01}, nullptr, &FakeGNSSSimulator::encodeNmea<nmeaGLL>, NMEA_MAX_SENTENCE, 0x209100C9},
+  {{0xF0, 0x02}, nullptr, &FakeGNSSSimulator::encodeNmea<nmeaGSA>, NMEA_MAX_SENTENCE * 4,
+   0x209100BF},
+  {{0xF0, 0x03}, nullptr, &FakeGNSSSimulator::encodeNmea<nmeaGSV>,
+   NMEA_MAX_SENTENCE * (NavSolution::MAX_SATELLITES / 4 + 4), 0x209100C4},
+  {{0xF0, 0x04}, nullptr, &FakeGNSSSimulator::encodeNmea<nmeaRMC>, NMEA_MAX_SENTENCE, 0x209100AB},
+  {{0xF0, 0x05}, nullptr, &FakeGNSSSimulator::encodeNmea<nmeaVTG>, NMEA_MAX_SENTENCE, 0x209100B0},
+  {{0xF0, 0x08}, nullptr, &FakeGNSSSimulator::encodeNmea<nmeaZDA>, NMEA_MAX_SENTENCE, 0x209100D8},
 };
 
-std::map<UBX_ID, FakeGNSSSimulator::PERIODIC_TRANSMIT> FakeGNSSSimulator::periodic_map_ = {
-  {{0x01, 0x03}, {&FakeGNSSSimulator::sendUbxNavSTATUS, 0, 0}},
-  {{0x01, 0x07}, {&FakeGNSSSimulator::sendUbxNavPVT, 0, 0}},
-  {{0x01, 0x3C}, {&FakeGNSSSimulator::sendUbxNavRELPOSNED, 0, 0}},
-  {{0x0A, 0x09}, {&FakeGNSSSimulator::sendUbxMonHW, 0, 0}},
-  {{0x0A, 0x36}, {&FakeGNSSSimulator::sendUbxMonCOMMS, 0, 0}},
+//! @brief Configuration items other than CFG-MSGOUT
+static const struct
+{
+  uint32_t key_;      //!< @brief key ID
+  uint64_t default_;  //!< @brief default value
+  uint64_t min_;      //!< @brief minimum value
+  uint64_t max_;      //!< @brief maximum value
+} cfg_items[] = {
+  // Receivers reject rates faster than their navigation engine supports
+  {CFG_RATE_MEAS, 1000, 25, UINT16_MAX},
+  {CFG_RATE_NAV, 1, 1, 127},
+  {CFG_RATE_TIMEREF, 1, 0, 4},
+  {CFG_UART1_BAUDRATE, 38400, 4800, 921600},
+  {CFG_UART2_BAUDRATE, 38400, 4800, 921600},
 };
 
-std::map<int, PortBlock> FakeGNSSSimulator::port_blocks_ = {
-  {PORT_ID_I2C, {false, 0}}, {PORT_ID_UART1, {false, 0}}, {PORT_ID_UART2, {false, 0}},
-  {PORT_ID_USB, {true, 0}},  {PORT_ID_SPI, {false, 0}},
+//! @brief Protocol keys of ports, input and output by port ID, 0 if not available
+static const uint32_t cfg_prot_keys[][2] = {
+  {0, 0},
+  {CFG_UART1INPROT_UBX, CFG_UART1OUTPROT_UBX},
+  {CFG_UART2INPROT_UBX, CFG_UART2OUTPROT_UBX},
+  {CFG_USBINPROT_UBX, CFG_USBOUTPROT_UBX},
+  {0, 0},
+};
+
+//! @brief Protocols of port, key offset from UBX key and bit of UBX-CFG-PRT protocol masks
+static const struct
+{
+  uint32_t offset_;  //!< @brief key minus UBX key
+  uint16_t mask_;    //!< @brief bit of inProtoMask and outProtoMask
+} cfg_protocols[] = {
+  {0, 0x0001},
+  {CFG_PROT_NMEA_OFFSET, 0x0002},
+  {CFG_PROT_RTCM3X_OFFSET, 0x0020},
 };
 
+
 FakeGNSSSimulator::FakeGNSSSimulator()
-: aStatus_(A_STATUS_OK),
-  jammingState_(JAMMING_STATE_OK),
+: encoded_epoch_(0),
+  meas_rate_(1000),
+  nav_rate_(1),
+  time_ref_(1),
+  reply_link_(LINK_UART1),
+  time_scale_(1.0),
+  sensor_rate_(50),
+  sensor_time_(0.0),
+  fusion_(false),
+  lever_arm_{1.0, 0.0, 0.0},
+  rover_pvt_(FRAME_OVERHEAD + UbxNavPVT::LENGTH),
+  rover_relposned_(FRAME_OVERHEAD + UbxNavRELPOSNED::LENGTH),
+  rover_encoded_(false),
+  rtk_float_time_(5.0),
+  rtk_fix_time_(20.0),
+  correction_timeout_(10.0),
+  fault_seed_(1),
+  outputs_{Output(io_), Output(io_), Output(io_, USB_TX_BUFFER_SIZE), Output(io_)},
   portId_(PORT_ID_I2C),
-  spoofDetState_(SPOOF_DET_STATE_NO_SPOOFING)
+  state_({A_STATUS_OK,
+          JAMMING_STATE_OK,
+          SPOOF_DET_STATE_NO_SPOOFING,
+          {{false, 0}, {true, 0}, {false, 0}, {true, 0}, {false, 0}},
+          false,
+          false})
 {
+  // Wait for deadlines on the same clock as TimerQueue
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&cond_timer_, &attr);
+  pthread_condattr_destroy(&attr);
+
+  // Build dispatch table indexed by (class << 8) | id
+  memset(index_, 0, sizeof(index_));
+  for (const auto & m : message_list_) {
+    std::vector<uint8_t> frame;
+    if (m.encode_ != nullptr) frame.resize(FRAME_OVERHEAD + m.max_length_);
+    messages_.push_back({m.handle_, m.encode_, m.cfg_key_, {}, frame, 0, 0});
+    index_[m.id_.key()] = messages_.size();
+  }
+
+  // Configuration starts from defaults of all items, messages being disabled on every port
+  for (const auto & m : message_list_) {
+    if (m.cfg_key_ == 0) continue;
+    for (uint32_t port = PORT_ID_I2C; port <= PORT_ID_SPI; ++port) {
+      cfg_.add(m.cfg_key_ + port, 0, 0, UINT8_MAX);
+    }
+  }
+  for (const auto & item : cfg_items) {
+    cfg_.add(item.key_, item.default_, item.min_, item.max_);
+  }
+  for (const auto & keys : cfg_prot_keys) {
+    for (auto key : keys) {
+      if (key == 0) continue;
+      for (const auto & p : cfg_protocols) cfg_.add(key + p.offset_, 1, 0, 1);
+    }
+  }
+  for (auto & p : protocols_) p = {true, true, true, true};
 }
 
 FakeGNSSSimulator * FakeGNSSSimulator::get(void)
@@ -59,10 +234,14 @@ FakeGNSSSimulator * FakeGNSSSimulator::get(void)
   return gnss_;
 }
 
+void FakeGNSSSimulator::setIniFile(const char * ini_file) { ini_path_ = ini_file; }
+
 void FakeGNSSSimulator::loadIniFile(void)
 {
-  auto env = boost::this_process::environment();
-  ini_path_ = env["HOME"].to_string() + "/.config/fake_gnss_simulator.ini";
+  if (ini_path_.empty()) {
+    auto env = boost::this_process::environment();
+    ini_path_ = env["HOME"].to_string() + "/.config/fake_gnss_simulator.ini";
+  }
 
   if (!fs::exists(ini_path_)) return;
 
@@ -71,7 +250,74 @@ void FakeGNSSSimulator::loadIniFile(void)
 
   if (boost::optional<std::string> v = pt.get_optional<std::string>("device_name")) {
     const char * str = v.get().c_str();
-    strncpy(device_name_, str, strlen(str));
+    strncpy(device_name_, str, sizeof(device_name_) - 1);
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("uart2_device_name")) {
+    const char * str = v.get().c_str();
+    strncpy(uart2_device_name_, str, sizeof(uart2_device_name_) - 1);
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("usb_device_name")) {
+    const char * str = v.get().c_str();
+    strncpy(usb_device_name_, str, sizeof(usb_device_name_) - 1);
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("log_file")) {
+    const char * str = v.get().c_str();
+    strncpy(log_file_, str, sizeof(log_file_) - 1);
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("trajectory_file")) {
+    const char * str = v.get().c_str();
+    strncpy(trajectory_file_, str, sizeof(trajectory_file_) - 1);
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("start_time")) {
+    const char * str = v.get().c_str();
+    strncpy(start_time_, str, sizeof(start_time_) - 1);
+  }
+  if (boost::optional<double> v = pt.get_optional<double>("time_scale")) {
+    time_scale_ = v.get();
+  }
+  if (boost::optional<int> v = pt.get_optional<int>("sensor_rate")) {
+    sensor_rate_ = v.get();
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("almanac_file")) {
+    const char * str = v.get().c_str();
+    strncpy(almanac_file_, str, sizeof(almanac_file_) - 1);
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("obstruction_file")) {
+    const char * str = v.get().c_str();
+    strncpy(obstruction_file_, str, sizeof(obstruction_file_) - 1);
+  }
+  if (boost::optional<double> v = pt.get_optional<double>("rtk_float_time")) {
+    rtk_float_time_ = v.get();
+  }
+  if (boost::optional<double> v = pt.get_optional<double>("rtk_fix_time")) {
+    rtk_fix_time_ = v.get();
+  }
+  if (boost::optional<double> v = pt.get_optional<double>("correction_timeout")) {
+    correction_timeout_ = v.get();
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("interference_file")) {
+    const char * str = v.get().c_str();
+    strncpy(interference_file_, str, sizeof(interference_file_) - 1);
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("fault_file")) {
+    const char * str = v.get().c_str();
+    strncpy(fault_file_, str, sizeof(fault_file_) - 1);
+  }
+  if (boost::optional<unsigned int> v = pt.get_optional<unsigned int>("fault_seed")) {
+    fault_seed_ = v.get();
+  }
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("rover_device_name")) {
+    const char * str = v.get().c_str();
+    strncpy(rover_device_name_, str, sizeof(rover_device_name_) - 1);
+  }
+  if (boost::optional<double> v = pt.get_optional<double>("lever_arm_forward")) {
+    lever_arm_[0] = v.get();
+  }
+  if (boost::optional<double> v = pt.get_optional<double>("lever_arm_right")) {
+    lever_arm_[1] = v.get();
+  }
+  if (boost::optional<double> v = pt.get_optional<double>("lever_arm_down")) {
+    lever_arm_[2] = v.get();
   }
 }
 
@@ -80,6 +326,25 @@ void FakeGNSSSimulator::saveIniFile(void)
   pt::ptree pt;
 
   pt.put("device_name", device_name_);
+  pt.put("uart2_device_name", uart2_device_name_);
+  pt.put("usb_device_name", usb_device_name_);
+  pt.put("log_file", log_file_);
+  pt.put("trajectory_file", trajectory_file_);
+  pt.put("start_time", start_time_);
+  pt.put("time_scale", time_scale_);
+  pt.put("sensor_rate", sensor_rate_);
+  pt.put("almanac_file", almanac_file_);
+  pt.put("obstruction_file", obstruction_file_);
+  pt.put("rtk_float_time", rtk_float_time_);
+  pt.put("rtk_fix_time", rtk_fix_time_);
+  pt.put("correction_timeout", correction_timeout_);
+  pt.put("interference_file", interference_file_);
+  pt.put("fault_file", fault_file_);
+  pt.put("fault_seed", fault_seed_);
+  pt.put("rover_device_name", rover_device_name_);
+  pt.put("lever_arm_forward", lever_arm_[0]);
+  pt.put("lever_arm_right", lever_arm_[1]);
+  pt.put("lever_arm_down", lever_arm_[2]);
 
   write_ini(ini_path_, pt);
 }
@@ -87,28 +352,270 @@ void FakeGNSSSimulator::saveIniFile(void)
 // General
 void FakeGNSSSimulator::setDeviceName(const char * device_name)
 {
-  strncpy(device_name_, device_name, strlen(device_name));
+  strncpy(device_name_, device_name, sizeof(device_name_) - 1);
 }
 
 const char * FakeGNSSSimulator::getDeviceName(void) const { return device_name_; }
 
+void FakeGNSSSimulator::setUart2DeviceName(const char * uart2_device_name)
+{
+  strncpy(uart2_device_name_, uart2_device_name, sizeof(uart2_device_name_) - 1);
+}
+
+const char * FakeGNSSSimulator::getUart2DeviceName(void) const { return uart2_device_name_; }
+
+void FakeGNSSSimulator::setUsbDeviceName(const char * usb_device_name)
+{
+  strncpy(usb_device_name_, usb_device_name, sizeof(usb_device_name_) - 1);
+}
+
+const char * FakeGNSSSimulator::getUsbDeviceName(void) const { return usb_device_name_; }
+
+void FakeGNSSSimulator::setLogFile(const char * log_file)
+{
+  strncpy(log_file_, log_file, sizeof(log_file_) - 1);
+}
+
+const char * FakeGNSSSimulator::getLogFile(void) const { return log_file_; }
+
+void FakeGNSSSimulator::setTrajectoryFile(const char * trajectory_file)
+{
+  strncpy(trajectory_file_, trajectory_file, sizeof(trajectory_file_) - 1);
+}
+
+const char * FakeGNSSSimulator::getTrajectoryFile(void) const { return trajectory_file_; }
+
+void FakeGNSSSimulator::setStartTime(const char * start_time)
+{
+  strncpy(start_time_, start_time, sizeof(start_time_) - 1);
+}
+
+const char * FakeGNSSSimulator::getStartTime(void) const { return start_time_; }
+
+void FakeGNSSSimulator::setTimeScale(double time_scale) { time_scale_ = time_scale; }
+
+double FakeGNSSSimulator::getTimeScale(void) const { return time_scale_; }
+
+void FakeGNSSSimulator::setAlmanacFile(const char * almanac_file)
+{
+  strncpy(almanac_file_, almanac_file, sizeof(almanac_file_) - 1);
+}
+
+const char * FakeGNSSSimulator::getAlmanacFile(void) const { return almanac_file_; }
+
+void FakeGNSSSimulator::setObstructionFile(const char * obstruction_file)
+{
+  strncpy(obstruction_file_, obstruction_file, sizeof(obstruction_file_) - 1);
+}
+
+const char * FakeGNSSSimulator::getObstructionFile(void) const { return obstruction_file_; }
+
+void FakeGNSSSimulator::setInterferenceFile(const char * interference_file)
+{
+  strncpy(interference_file_, interference_file, sizeof(interference_file_) - 1);
+}
+
+const char * FakeGNSSSimulator::getInterferenceFile(void) const { return interference_file_; }
+
+void FakeGNSSSimulator::setSensorRate(int sensor_rate) { sensor_rate_ = sensor_rate; }
+
+int FakeGNSSSimulator::getSensorRate(void) const { return sensor_rate_; }
+
+void FakeGNSSSimulator::setFaultFile(const char * fault_file)
+{
+  strncpy(fault_file_, fault_file, sizeof(fault_file_) - 1);
+}
+
+const char * FakeGNSSSimulator::getFaultFile(void) const { return fault_file_; }
+
+void FakeGNSSSimulator::setFaultSeed(unsigned int fault_seed) { fault_seed_ = fault_seed; }
+
+unsigned int FakeGNSSSimulator::getFaultSeed(void) const { return fault_seed_; }
+
+void FakeGNSSSimulator::setRoverDeviceName(const char * rover_device_name)
+{
+  strncpy(rover_device_name_, rover_device_name, sizeof(rover_device_name_) - 1);
+}
+
+const char * FakeGNSSSimulator::getRoverDeviceName(void) const { return rover_device_name_; }
+
 int FakeGNSSSimulator::start(void)
 {
   int ret = 0;
 
   // Preparation for a subsequent run() invocation
   io_.reset();
-  port_ = boost::shared_ptr<as::serial_port>(new as::serial_port(io_));
+  boost::shared_ptr<as::serial_port> & port = outputs_[LINK_UART1].port_;
+  port = boost::shared_ptr<as::serial_port>(new as::serial_port(io_));
+  for (int link = LINK_UART2; link < LINKS; ++link) outputs_[link].port_.reset();
 
   // Open the serial port using the specified device name
   try {
-    port_->open(device_name_);
+    port->open(device_name_);
   } catch (const boost::system::system_error & e) {
     ret = ENOENT;
     std::cerr << e.what() << std::endl;
     return ret;
   }
 
+  // Other ports of moving base are opened when named
+  const char * names[BASE_LINKS] = {device_name_, uart2_device_name_, usb_device_name_};
+  for (int link = LINK_UART2; link < BASE_LINKS; ++link) {
+    if (strlen(names[link]) == 0) continue;
+    boost::shared_ptr<as::serial_port> other(new as::serial_port(io_));
+    try {
+      other->open(names[link]);
+    } catch (const boost::system::system_error & e) {
+      std::cerr << e.what() << std::endl;
+      closePorts();
+      return ENOENT;
+    }
+    outputs_[link].port_ = other;
+  }
+
+  // Map log file, and make its messages known to CFG-MSG. Messages of the previous log are
+  // forgotten first, leaving the supported ones.
+  log_.close();
+  const std::size_t supported = sizeof(message_list_) / sizeof(message_list_[0]);
+  for (auto & i : index_) {
+    if (i > supported) i = 0;
+  }
+  auto forgotten = [this](uint16_t key) { return index_[key] == 0; };
+  enabled_.erase(std::remove_if(enabled_.begin(), enabled_.end(), forgotten), enabled_.end());
+  messages_.erase(messages_.begin() + supported, messages_.end());
+  if (strlen(log_file_) > 0) {
+    ret = log_.open(log_file_);
+    if (ret != 0) {
+      closePorts();
+      return ret;
+    }
+    for (auto key : log_.keys()) {
+      if (index_[key] > 0) continue;
+      if (messages_.size() >= UINT8_MAX) break;
+      messages_.push_back({nullptr, nullptr, 0, {}, {}, 0, 0});
+      index_[key] = messages_.size();
+    }
+  }
+  // Load trajectory, which starts over on every run
+  trajectory_.clear();
+  if (strlen(trajectory_file_) > 0) {
+    ret = trajectory_.load(trajectory_file_);
+    if (ret != 0) {
+      closePorts();
+      return ret;
+    }
+  }
+  // Simulated time starts at the configured UTC, or at the current time
+  int64_t utc = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::system_clock::now().time_since_epoch())
+                  .count();
+  if (time_scale_ <= 0.0) {
+    std::cerr << time_scale_ << ": invalid time scale" << std::endl;
+    closePorts();
+    return EINVAL;
+  }
+  if (strlen(start_time_) > 0) {
+    int64_t sec;
+    if (!GnssClock::parse(start_time_, sec)) {
+      std::cerr << start_time_ << ": invalid start time" << std::endl;
+      closePorts();
+      return EINVAL;
+    }
+    utc = sec * 1000000000;
+  }
+  clock_.start(TimerQueue::Clock::now(), utc, time_scale_);
+  if (sensor_rate_ <= 0 || sensor_rate_ > ImuModel::MAX_RATE) {
+    std::cerr << sensor_rate_ << ": invalid sensor rate" << std::endl;
+    closePorts();
+    return EINVAL;
+  }
+  clock_.get(TimerQueue::Clock::now(), meas_rate_ * nav_rate_, epoch_time_);
+
+  // Satellites follow almanac, or nominal orbits referred to the start
+  if (strlen(almanac_file_) > 0) {
+    ret = constellation_.load(almanac_file_);
+    if (ret != 0) {
+      closePorts();
+      return ret;
+    }
+  } else {
+    constellation_.setDefault(epoch_time_.week_, epoch_time_.iTOW_ / 1000);
+  }
+  obstruction_.clear();
+  if (strlen(obstruction_file_) > 0) {
+    ret = obstruction_.load(obstruction_file_);
+    if (ret != 0) {
+      closePorts();
+      return ret;
+    }
+  }
+  interference_.clear();
+  if (strlen(interference_file_) > 0) {
+    ret = interference_.load(interference_file_);
+    if (ret != 0) {
+      closePorts();
+      return ret;
+    }
+  }
+  raw_model_.reset(1);
+  imu_model_.reset(1);
+  sensor_time_ = epoch_time_.elapsed_;
+  fusion_ = false;
+
+  // Faults start over from the seed, with probabilities of file or those set
+  if (strlen(fault_file_) > 0) {
+    ret = faults_.load(fault_file_);
+    if (ret != 0) {
+      closePorts();
+      return ret;
+    }
+  }
+  faults_.seed(fault_seed_);
+
+  // Solution starts without corrections
+  rtk_.reset();
+  rtk_.setTimes(rtk_float_time_, rtk_fix_time_, correction_timeout_);
+  rtk_solution_ = RtkState::RTK_NONE;
+  correction_age_ = -1;
+  reference_station_ = 0;
+  sky_time_ = -1;
+  subframe_ = epochSeconds() / GPS_LNAV_SUBFRAME;
+
+  // Rover of moving base writes to a port of its own
+  if (strlen(rover_device_name_) > 0) {
+    boost::shared_ptr<as::serial_port> rover(new as::serial_port(io_));
+    try {
+      rover->open(rover_device_name_);
+    } catch (const boost::system::system_error & e) {
+      std::cerr << e.what() << std::endl;
+      closePorts();
+      return ENOENT;
+    }
+    outputs_[LINK_ROVER].port_ = rover;
+  }
+  rover_encoded_ = false;
+
+  replay_epoch_ = 0;
+  replay_count_ = 0;
+  replay_deadline_ = TimerQueue::Clock::now();
+
+  // Restart epoch clock
+  epoch_count_ = 0;
+  timers_.clear();
+  scheduleEpoch();
+
+  // Transmit buffers start empty on every run
+  for (auto & output : outputs_) {
+    output.drain_timer_.cancel();
+    output.uart_.reset();
+    output.draining_ = false;
+  }
+
+  for (auto & input : inputs_) {
+    input.parser_.reset();
+    input.rtcm3_parser_.reset();
+    input.crc_failures_ = 0;
+  }
   stop_thread_ = false;
   pthread_create(&th_, nullptr, &FakeGNSSSimulator::threadHelper, this);
   return ret;
@@ -118,6 +625,7 @@ void FakeGNSSSimulator::stop(void)
 {
   pthread_mutex_lock(&mutex_stop_);
   stop_thread_ = true;
+  pthread_cond_signal(&cond_timer_);
   pthread_mutex_unlock(&mutex_stop_);
   pthread_join(th_, NULL);
 
@@ -127,35 +635,61 @@ void FakeGNSSSimulator::stop(void)
 void FakeGNSSSimulator::setChecksumError(int is_error)
 {
   pthread_mutex_lock(&mutex_send_);
-  checksum_error_ = is_error;
+  STATE s = state_.load();
+  s.checksum_error_ = is_error;
+  state_.store(s);
   pthread_mutex_unlock(&mutex_send_);
 }
 
 void FakeGNSSSimulator::setDebugOutput(int is_debug)
 {
-  pthread_mutex_lock(&mutex_dump_);
-  dump_ = is_debug;
-  pthread_mutex_unlock(&mutex_dump_);
+  pthread_mutex_lock(&mutex_send_);
+  STATE s = state_.load();
+  s.dump_ = is_debug;
+  state_.store(s);
+  pthread_mutex_unlock(&mutex_send_);
+}
+
+void FakeGNSSSimulator::setFaultRate(int message_class, FaultType fault, double probability)
+{
+  pthread_mutex_lock(&mutex_stop_);
+  faults_.setRate(message_class, fault, probability);
+  pthread_mutex_unlock(&mutex_stop_);
+}
+
+double FakeGNSSSimulator::getFaultRate(int message_class, FaultType fault)
+{
+  pthread_mutex_lock(&mutex_stop_);
+  double probability = faults_.getRate(message_class, fault);
+  pthread_mutex_unlock(&mutex_stop_);
+  return probability;
 }
 
 // UBX-MON-HW
 void FakeGNSSSimulator::setAStatus(AStatus aStatus)
 {
   pthread_mutex_lock(&mutex_send_);
-  aStatus_ = aStatus;
+  STATE s = state_.load();
+  s.aStatus_ = aStatus;
+  state_.store(s);
   pthread_mutex_unlock(&mutex_send_);
 }
 
-AStatus FakeGNSSSimulator::getAStatus(void) const { return aStatus_; }
+AStatus FakeGNSSSimulator::getAStatus(void) const { return state_.load().aStatus_; }
 
 void FakeGNSSSimulator::setJammingState(JammingState jammingState)
 {
   pthread_mutex_lock(&mutex_send_);
-  jammingState_ = jammingState;
+  STATE s = state_.load();
+  s.jammingState_ = jammingState;
+  state_.store(s);
   pthread_mutex_unlock(&mutex_send_);
 }
 
-JammingState FakeGNSSSimulator::getJammingState(void) const { return jammingState_; }
+JammingState FakeGNSSSimulator::getJammingState(void) const
+{
+  return state_.load().jammingState_;
+}
 
 void FakeGNSSSimulator::setPortId(PortId portId)
 {
@@ -166,19 +700,26 @@ void FakeGNSSSimulator::setPortId(PortId portId)
 
 PortId FakeGNSSSimulator::getPortId(void) const { return portId_; }
 
-PortBlock FakeGNSSSimulator::getPortBlock(void) const { return port_blocks_[portId_]; }
+PortBlock FakeGNSSSimulator::getPortBlock(void) const
+{
+  return state_.load().port_blocks_[portId_];
+}
 
 void FakeGNSSSimulator::setPortEnabled(int port_enabled)
 {
   pthread_mutex_lock(&mutex_send_);
-  port_blocks_[portId_].port_enabled = port_enabled;
+  STATE s = state_.load();
+  s.port_blocks_[portId_].port_enabled = port_enabled;
+  state_.store(s);
   pthread_mutex_unlock(&mutex_send_);
 }
 
 void FakeGNSSSimulator::setTxUsage(int tx_usage)
 {
   pthread_mutex_lock(&mutex_send_);
-  port_blocks_[portId_].tx_usage = tx_usage;
+  STATE s = state_.load();
+  s.port_blocks_[portId_].tx_usage = tx_usage;
+  state_.store(s);
   pthread_mutex_unlock(&mutex_send_);
 }
 
@@ -186,49 +727,342 @@ void FakeGNSSSimulator::setTxUsage(int tx_usage)
 void FakeGNSSSimulator::setSpoofDetState(SpoofDetState spoofDetState)
 {
   pthread_mutex_lock(&mutex_send_);
-  spoofDetState_ = spoofDetState;
+  STATE s = state_.load();
+  s.spoofDetState_ = spoofDetState;
+  state_.store(s);
   pthread_mutex_unlock(&mutex_send_);
 }
 
-SpoofDetState FakeGNSSSimulator::getSpoofDetState(void) const { return spoofDetState_; }
+SpoofDetState FakeGNSSSimulator::getSpoofDetState(void) const
+{
+  return state_.load().spoofDetState_;
+}
 
 void * FakeGNSSSimulator::thread(void)
 {
+  // asynchronously read data on every port of moving base, which keeps the io thread running
+  for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+    if (outputs_[link].port_) read(static_cast<Link>(link));
+  }
   boost::thread thr_io(boost::bind(&as::io_service::run, &io_));
 
-  // asynchronously read data
-  uint8_t data[MAX_SIZE] = "";
-  port_->async_read_some(
-    as::buffer(data), boost::bind(
-                        &FakeGNSSSimulator::onRead, this, as::placeholders::error,
-                        as::placeholders::bytes_transferred, data));
-
-  while (true) {
-    bool b;
+  std::vector<uint16_t> keys;
+  pthread_mutex_lock(&mutex_stop_);
+
+  while (!stop_thread_) {
+    // Sleep until the earliest deadline, or until stopped or timers are changed
+    bool replay = log_.isOpen();
+    if (timers_.empty() && !replay) {
+      pthread_cond_wait(&cond_timer_, &mutex_stop_);
+      continue;
+    }
+    TimerQueue::Clock::time_point deadline = replay ? replay_deadline_ : timers_.next();
+    if (replay && !timers_.empty()) deadline = std::min(deadline, timers_.next());
+    TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+    if (now < deadline) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+      struct timespec ts;
+      ts.tv_sec = ns.count() / 1000000000;
+      ts.tv_nsec = ns.count() % 1000000000;
+      pthread_cond_timedwait(&cond_timer_, &mutex_stop_, &ts);
+      continue;
+    }
+
+    // Collect expired timers, and transmit without holding the lock
+    uint16_t key;
+    bool epoch = false;
+    bool sensors = false;
+    while (timers_.pop(now, key)) {
+      if (key == EPOCH_TIMER) epoch = true;
+      if (key == SENSOR_TIMER) sensors = true;
+    }
+    pthread_mutex_unlock(&mutex_stop_);
+    if (replay && replay_deadline_ <= now) {
+      handleReplay();
+    }
+    if (epoch) {
+      handleEpoch();
+    }
+    if (sensors) {
+      handleSensors();
+    }
     pthread_mutex_lock(&mutex_stop_);
-    b = stop_thread_;
+  }
+
+  pthread_mutex_unlock(&mutex_stop_);
+
+  // Reads and writes pending on ports, even stalled ones, are aborted on the io thread, which
+  // then runs out of work
+  io_.post(boost::bind(&FakeGNSSSimulator::closePorts, this));
+  thr_io.join();
+
+  return nullptr;
+}
+
+void FakeGNSSSimulator::closePorts(void)
+{
+  boost::system::error_code error;
+  for (auto & output : outputs_) {
+    output.drain_timer_.cancel();
+    if (output.port_) output.port_->close(error);
+  }
+}
+
+void FakeGNSSSimulator::handleEpoch(void)
+{
+  // Messages due in this epoch, rate of CFG-MSG being the number of epochs between them.
+  // Messages recorded in log are replayed instead of generated, and sensor samples are sent in
+  // batches of their own.
+  due_.clear();
+  due_links_.clear();
+  TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+  GnssClock::Time time;
+  pthread_mutex_lock(&mutex_stop_);
+  clock_.get(now, meas_rate_ * nav_rate_, time);
+  for (auto key : enabled_) {
+    const MESSAGE_ENTRY & m = messages_[index_[key] - 1];
+    bool sampled = m.encode_ == &FakeGNSSSimulator::encodeUbxEsfMEAS;
+    if (m.encode_ == nullptr || sampled || log_.contains(key)) continue;
+    uint8_t links = dueLinks(key, epoch_count_);
+    if (links == 0) continue;
+    due_.push_back(key);
+    due_links_.push_back(links);
+  }
+  ++epoch_count_;
+  pthread_mutex_unlock(&mutex_stop_);
+
+  // Frames and the sky they are encoded from are shared with polls
+  pthread_mutex_lock(&mutex_frame_);
+  epoch_time_ = time;
+  ++encoded_epoch_;
+
+  // Carrier phase solution of the epoch follows corrections received so far, and needs a fix
+  NavSolution s;
+  getNavSolution(s);
+  pthread_mutex_lock(&mutex_stop_);
+  rtk_solution_ = rtk_.update(now, s.fixType_ != 0x00);
+  correction_age_ = rtk_.age(now);
+  reference_station_ = rtk_.station();
+  pthread_mutex_unlock(&mutex_stop_);
+
+  // Sensor fusion initializes with the first fix, and stays initialized
+  fusion_ = fusion_ || s.fixType_ != 0x00;
+
+  // Encode in place into the frame buffers of the dispatch table, patching the previous encoding
+  // once there is one. Each frame is encoded once and referred to by every port it is due on.
+  for (auto & buffers : buffers_) buffers.clear();
+  for (std::size_t i = 0; i < due_.size(); ++i) {
+    MESSAGE_ENTRY & m = messages_[index_[due_[i]] - 1];
+    m.size_ = (this->*(m.encode_))(&m.frame_[0], m.size_ > 0);
+    m.epoch_ = encoded_epoch_;
+    queueFrames(m, due_links_[i]);
+  }
+  sendFrames(std::chrono::milliseconds(meas_rate_ * nav_rate_));
+
+  // Rover reports in the same epoch, from the same solution of moving base, and fixes the
+  // baseline with corrections of moving base, whatever those of moving base are
+  if (!outputs_[LINK_ROVER].port_) {
+    pthread_mutex_unlock(&mutex_frame_);
+    return;
+  }
+  getNavSolution(s);
+  NavSolution r = s;
+  getRoverSolution(r);
+  rover_buffers_.clear();
+  std::size_t size = encodeUbxNavPVT(&rover_pvt_[0], rover_encoded_, r);
+  rover_buffers_.push_back(as::buffer(rover_pvt_.data(), size));
+  size = encodeUbxNavRELPOSNED(&rover_relposned_[0], rover_encoded_, s, RtkState::RTK_FIXED, 0);
+  rover_buffers_.push_back(as::buffer(rover_relposned_.data(), size));
+  rover_encoded_ = true;
+  write(rover_buffers_, LINK_ROVER);
+  pthread_mutex_unlock(&mutex_frame_);
+}
+
+void FakeGNSSSimulator::handleSensors(void)
+{
+  // Samples are taken at every batch, but sent only in epochs UBX-ESF-MEAS is due in, from the
+  // first epoch on
+  uint16_t key = UBX_ID(UbxEsfMEAS::CLASS_ID, UbxEsfMEAS::MESSAGE_ID).key();
+  MESSAGE_ENTRY & m = messages_[index_[key] - 1];
+  TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+  GnssClock::Time time;
+  pthread_mutex_lock(&mutex_stop_);
+  clock_.get(now, meas_rate_ * nav_rate_, time);
+  bool enabled = std::find(enabled_.begin(), enabled_.end(), key) != enabled_.end();
+  if (!enabled || log_.contains(key)) {
     pthread_mutex_unlock(&mutex_stop_);
-    if (b) break;
+    return;
+  }
+  uint8_t links = epoch_count_ > 0 ? dueLinks(key, epoch_count_ - 1) : 0;
+  TimerQueue::Clock::duration period = std::chrono::milliseconds(meas_rate_) * nav_rate_;
+  pthread_mutex_unlock(&mutex_stop_);
 
-    // Handle periodic transmission
-    handlePeriodicTransmit();
-    usleep(SLEEP_CNT_1MS);
+  pthread_mutex_lock(&mutex_frame_);
+  sensor_time_ = time.elapsed_;
+  m.size_ = encodeUbxEsfMEAS(&m.frame_[0], false);
+  m.epoch_ = encoded_epoch_;
+  for (auto & buffers : buffers_) buffers.clear();
+  queueFrames(m, links);
+  sendFrames(std::min<TimerQueue::Clock::duration>(period, SENSOR_PERIOD));
+  pthread_mutex_unlock(&mutex_frame_);
+}
+
+void FakeGNSSSimulator::queueFrames(const MESSAGE_ENTRY & m, uint8_t links)
+{
+  // Batches of UBX frames and groups of NMEA sentences are queued frame by frame, to be dropped
+  // and corrupted one by one
+  const uint8_t * data = m.frame_.data();
+  for (std::size_t offset = 0; offset < m.size_;) {
+    std::size_t size = m.size_ - offset;
+    if (data[offset] == 0xB5) {
+      size = FRAME_OVERHEAD + (data[offset + 4] | (data[offset + 5] << 8));
+    } else if (const void * end = memchr(data + offset, '\n', size)) {
+      size = static_cast<const uint8_t *>(end) + 1 - (data + offset);
+    }
+    as::const_buffer frame = as::buffer(data + offset, size);
+    for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+      if (links & (1 << link)) buffers_[link].push_back(frame);
+    }
+    offset += size;
   }
+}
 
-  return nullptr;
+void FakeGNSSSimulator::sendFrames(TimerQueue::Clock::duration period)
+{
+  // Every port sends all of its frames at once, and suffers faults of its own
+  for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+    if (buffers_[link].empty()) continue;
+    pthread_mutex_lock(&mutex_stop_);
+    TimerQueue::Clock::duration delay = faults_.apply(buffers_[link], period);
+    pthread_mutex_unlock(&mutex_stop_);
+    if (!buffers_[link].empty()) write(buffers_[link], static_cast<Link>(link), delay);
+  }
+}
+
+void FakeGNSSSimulator::handleReplay(void)
+{
+  // Rate of CFG-MSG is the number of epochs between transmissions, frames of log being shared
+  // by every port they are due on
+  for (auto & buffers : replay_buffers_) buffers.clear();
+  const UbxLog::Epoch & e = log_.epoch(replay_epoch_);
+  pthread_mutex_lock(&mutex_stop_);
+  for (std::size_t i = e.begin_; i < e.end_; ++i) {
+    const UbxLog::Frame & f = log_.frame(i);
+    if (index_[f.key_] == 0) continue;
+    uint8_t links = dueLinks(f.key_, replay_count_);
+    for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+      if (links & (1 << link)) replay_buffers_[link].push_back(as::buffer(f.data_, f.size_));
+    }
+  }
+  pthread_mutex_unlock(&mutex_stop_);
+  for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+    if (replay_buffers_[link].empty()) continue;
+    pthread_mutex_lock(&mutex_stop_);
+    TimerQueue::Clock::duration delay =
+      faults_.apply(replay_buffers_[link], log_.interval(replay_epoch_));
+    pthread_mutex_unlock(&mutex_stop_);
+    if (!replay_buffers_[link].empty()) {
+      write(replay_buffers_[link], static_cast<Link>(link), delay);
+    }
+  }
+
+  // Keep recorded spacing without drift, but do not catch up in a burst
+  TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+  replay_deadline_ += log_.interval(replay_epoch_);
+  if (replay_deadline_ <= now) replay_deadline_ = now + log_.interval(replay_epoch_);
+
+  replay_epoch_ = (replay_epoch_ + 1) % log_.epochs();
+  ++replay_count_;
+}
+
+void FakeGNSSSimulator::scheduleEpoch(void)
+{
+  // Sensor samples of an epoch are split into batches, which drain between those of the epoch
+  TimerQueue::Clock::duration period = std::chrono::milliseconds(meas_rate_) * nav_rate_;
+  TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+
+  pthread_mutex_lock(&mutex_stop_);
+  timers_.schedule(EPOCH_TIMER, period, now);
+  timers_.schedule(SENSOR_TIMER, std::min<TimerQueue::Clock::duration>(period, SENSOR_PERIOD), now);
+  pthread_cond_signal(&cond_timer_);
+  pthread_mutex_unlock(&mutex_stop_);
+}
+
+void FakeGNSSSimulator::setRate(uint16_t key, uint32_t port, int rate)
+{
+  MESSAGE_ENTRY & m = messages_[index_[key] - 1];
+  m.rates_[port] = rate;
+
+  // Keep list of messages enabled on any port to iterate only them
+  bool enabled = std::any_of(std::begin(m.rates_), std::end(m.rates_), [](int r) { return r > 0; });
+  auto it = std::find(enabled_.begin(), enabled_.end(), key);
+  if (enabled && it == enabled_.end()) enabled_.push_back(key);
+  if (!enabled && it != enabled_.end()) enabled_.erase(it);
 }
 
-void FakeGNSSSimulator::handlePeriodicTransmit(void)
+uint8_t FakeGNSSSimulator::dueLinks(uint16_t key, uint32_t count) const
 {
-  for (auto & p : periodic_map_) {
-    if (p.second.rate_ > 0) {
-      --p.second.cnt_;
-      if (p.second.cnt_ <= 0) {
-        (this->*(p.second.func_))();
-        p.second.cnt_ = p.second.rate_;
-      }
+  // Open ports whose output protocol carries the message and whose rate falls on the epoch
+  const MESSAGE_ENTRY & m = messages_[index_[key] - 1];
+  uint8_t links = 0;
+  for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+    PortId port = linkPort(link);
+    const Protocols & p = protocols_[port];
+    bool out = ((key >> 8) == 0xF0) ? p.out_nmea_ : p.out_ubx_;
+    int rate = m.rates_[port];
+    if (outputs_[link].port_ && out && rate > 0 && count % rate == 0) links |= 1 << link;
+  }
+  return links;
+}
+
+void FakeGNSSSimulator::applyConfig(void)
+{
+  uint16_t meas_rate = cfg_.get(CFG_RATE_MEAS);
+  uint16_t nav_rate = cfg_.get(CFG_RATE_NAV);
+  bool reschedule = meas_rate != meas_rate_ || nav_rate != nav_rate_;
+
+  pthread_mutex_lock(&mutex_stop_);
+  for (const auto & m : message_list_) {
+    if (m.cfg_key_ == 0) continue;
+    for (uint32_t port = PORT_ID_I2C; port <= PORT_ID_SPI; ++port) {
+      setRate(m.id_.key(), port, cfg_.get(m.cfg_key_ + port));
     }
   }
+  meas_rate_ = meas_rate;
+  nav_rate_ = nav_rate;
+  time_ref_ = cfg_.get(CFG_RATE_TIMEREF);
+  for (uint32_t port = PORT_ID_I2C; port <= PORT_ID_SPI; ++port) {
+    uint32_t in = cfg_prot_keys[port][0];
+    uint32_t out = cfg_prot_keys[port][1];
+    if (in == 0) continue;
+    protocols_[port].in_ubx_ = cfg_.get(in);
+    protocols_[port].in_rtcm3_ = cfg_.get(in + CFG_PROT_RTCM3X_OFFSET);
+    protocols_[port].out_ubx_ = cfg_.get(out);
+    protocols_[port].out_nmea_ = cfg_.get(out + CFG_PROT_NMEA_OFFSET);
+  }
+  pthread_mutex_unlock(&mutex_stop_);
+
+  // Rover is set up like UART1 of moving base, and USB is not limited by a baud rate
+  pthread_mutex_lock(&mutex_write_);
+  outputs_[LINK_UART1].uart_.setBaudrate(cfg_.get(CFG_UART1_BAUDRATE));
+  outputs_[LINK_UART2].uart_.setBaudrate(cfg_.get(CFG_UART2_BAUDRATE));
+  outputs_[LINK_USB].uart_.setBaudrate(0);
+  outputs_[LINK_ROVER].uart_.setBaudrate(cfg_.get(CFG_UART1_BAUDRATE));
+  pthread_mutex_unlock(&mutex_write_);
+
+  if (reschedule) scheduleEpoch();
+}
+
+void FakeGNSSSimulator::endTransaction(bool ok, uint8_t transaction)
+{
+  // Without transaction, changes of a message are applied at once.
+  // A transaction is applied on its last message, and discarded on any error.
+  if (!ok) {
+    cfg_.rollback();
+  } else if (transaction == 0 || transaction == 3) {
+    cfg_.commit();
+    applyConfig();
+  }
 }
 
 void FakeGNSSSimulator::dump(Direction dir, const uint8_t * data, std::size_t size)
@@ -243,50 +1077,84 @@ void FakeGNSSSimulator::dump(Direction dir, const uint8_t * data, std::size_t si
 }
 
 void FakeGNSSSimulator::onRead(
-  const boost::system::error_code & error, std::size_t bytes_transfered, const uint8_t * data)
+  const boost::system::error_code & error, std::size_t bytes_transfered, Link link)
 {
   if (error) {
-    std::cout << error.message() << std::endl;
+    if (error != as::error::operation_aborted) std::cout << error.message() << std::endl;
   } else {
-    bool b;
-    pthread_mutex_lock(&mutex_dump_);
-    b = dump_;
-    pthread_mutex_unlock(&mutex_dump_);
-    if (b) {
+    Input & input = inputs_[link];
+    const uint8_t * data = input.read_buf_;
+    if (state_.load().dump_) {
       dump(Read, data, bytes_transfered);
     }
 
-    if (data[0] == 0xB5 && data[1] == 0x62) {
-      handleUbx(data);
+    pthread_mutex_lock(&mutex_write_);
+    outputs_[link].uart_.receive(bytes_transfered);
+    pthread_mutex_unlock(&mutex_write_);
+
+    // Responses go back to the port the message came from
+    reply_link_ = link;
+    const Protocols & p = protocols_[linkPort(link)];
+
+    // Frames may be split across reads or several frames may arrive at once
+    input.parser_.feed(data, bytes_transfered);
+    const uint8_t * frame;
+    std::size_t size;
+    while (input.parser_.next(frame, size)) {
+      if (p.in_ubx_) handleUbx(frame);
+    }
+
+    // Corrections arrive on the same port, interleaved with UBX
+    input.rtcm3_parser_.feed(data, bytes_transfered);
+    while (input.rtcm3_parser_.next(frame, size)) {
+      if (p.in_rtcm3_) handleRtcm3(frame);
+    }
+    for (; input.crc_failures_ < input.rtcm3_parser_.crcFailures(); ++input.crc_failures_) {
+      if (p.in_rtcm3_) sendUbxRxmRTCM(0x01, 0, 0);
     }
-    // asynchronously read data
-    uint8_t next[MAX_SIZE] = "";
-    port_->async_read_some(
-      as::buffer(next), boost::bind(
-                          &FakeGNSSSimulator::onRead, this, as::placeholders::error,
-                          as::placeholders::bytes_transferred, next));
+
+    read(link);
   }
 }
 
+void FakeGNSSSimulator::read(Link link)
+{
+  // asynchronously read data
+  outputs_[link].port_->async_read_some(
+    as::buffer(inputs_[link].read_buf_),
+    boost::bind(
+      &FakeGNSSSimulator::onRead, this, as::placeholders::error,
+      as::placeholders::bytes_transferred, link));
+}
+
 void FakeGNSSSimulator::onWrite(
   const boost::system::error_code & error, std::size_t bytes_transfered,
-  const std::vector<uint8_t> & data)
+  const std::vector<as::const_buffer> & buffers)
 {
-  bool b;
-  pthread_mutex_lock(&mutex_dump_);
-  b = dump_;
-  pthread_mutex_unlock(&mutex_dump_);
-  if (b) {
-    dump(Write, &data[0], bytes_transfered);
+  if (error) {
+    if (error != as::error::operation_aborted) std::cout << error.message() << std::endl;
+    return;
+  }
+
+  if (state_.load().dump_) {
+    for (const auto & buffer : buffers) {
+      std::size_t size = std::min(buffer.size(), bytes_transfered);
+      dump(Write, static_cast<const uint8_t *>(buffer.data()), size);
+      bytes_transfered -= size;
+    }
   }
 }
 
 void FakeGNSSSimulator::handleUbx(const uint8_t * data)
 {
-  auto it = handle_map_.find(UBX_ID(data[2], data[3]));
-
-  if (it != handle_map_.end()) {
-    (this->*(it->second))(data);
+  MESSAGE_ENTRY * m = findMessage(data[2], data[3]);
+
+  uint16_t length = data[4] | (data[5] << 8);
+  if (m != nullptr && m->handle_ != nullptr) {
+    (this->*(m->handle_))(data);
+  } else if (m != nullptr && m->encode_ != nullptr && data[2] != 0xF0 && length == 0) {
+    // Messages replayed from log are not generated
+    if (!log_.contains(UBX_ID(data[2], data[3]).key())) handleUbxPoll(*m);
   } else {
     // UBX-CFG-???
     if (data[2] == 0x06) {
@@ -295,184 +1163,1054 @@ void FakeGNSSSimulator::handleUbx(const uint8_t * data)
   }
 }
 
+void FakeGNSSSimulator::handleUbxPoll(MESSAGE_ENTRY & m)
+{
+  // Frame already encoded in this epoch is sent as it is, otherwise it is encoded now and kept
+  // for further polls and the next periodic encoding to patch. Sensor samples are taken by the
+  // periodic batches, polls getting the last batch of the epoch, or else the samples since the
+  // last batch taken by a copy of the sensors.
+  pthread_mutex_lock(&mutex_frame_);
+  bool sampled = m.encode_ == &FakeGNSSSimulator::encodeUbxEsfMEAS;
+  std::size_t size = m.size_;
+  if (sampled && (m.epoch_ != encoded_epoch_ || m.size_ == 0)) {
+    GnssClock::Time time;
+    pthread_mutex_lock(&mutex_stop_);
+    clock_.get(TimerQueue::Clock::now(), meas_rate_ * nav_rate_, time);
+    pthread_mutex_unlock(&mutex_stop_);
+    ImuModel imu_model = imu_model_;
+    sensor_time_ = time.elapsed_;
+    size = encodeUbxEsfMEAS(&m.frame_[0], false);
+    imu_model_ = imu_model;
+  } else if (!sampled && (m.epoch_ != encoded_epoch_ || m.size_ == 0)) {
+    m.size_ = (this->*(m.encode_))(&m.frame_[0], m.size_ > 0);
+    m.epoch_ = encoded_epoch_;
+    size = m.size_;
+  }
+  if (size > 0) write(m.frame_.data(), size);
+  pthread_mutex_unlock(&mutex_frame_);
+}
+
+void FakeGNSSSimulator::handleRtcm3(const uint8_t * frame)
+{
+  uint16_t type = Rtcm3Parser::messageType(frame);
+  uint16_t station = Rtcm3Parser::stationId(frame);
+
+  pthread_mutex_lock(&mutex_stop_);
+  bool used = rtk_.receive(type, station, TimerQueue::Clock::now());
+  pthread_mutex_unlock(&mutex_stop_);
+
+  sendUbxRxmRTCM(used ? 0x04 : 0x02, station, type);
+}
+
 // UBX-MON-VER
 void FakeGNSSSimulator::handleUbxMonVER(const uint8_t * data)
 {
-  uint8_t d[] = {
-    0xB5, 0x62, 0x0A, 0x04, 0xDC, 0x00, 0x45, 0x58, 0x54, 0x20, 0x43, 0x4F, 0x52, 0x45, 0x20, 0x31,
-    0x2E, 0x30, 0x30, 0x20, 0x28, 0x36, 0x31, 0x62, 0x32, 0x64, 0x64, 0x29, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x31, 0x39, 0x30, 0x30, 0x30, 0x30, 0x00, 0x00, 0x52, 0x4F,
-    0x4D, 0x20, 0x42, 0x41, 0x53, 0x45, 0x20, 0x30, 0x78, 0x31, 0x31, 0x38, 0x42, 0x32, 0x30, 0x36,
-    0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46, 0x57, 0x56, 0x45,
-    0x52, 0x3D, 0x48, 0x50, 0x47, 0x20, 0x31, 0x2E, 0x31, 0x32, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x52, 0x4F, 0x54, 0x56, 0x45,
-    0x52, 0x3D, 0x32, 0x37, 0x2E, 0x31, 0x31, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4D, 0x4F, 0x44, 0x3D, 0x5A, 0x45, 0x44, 0x2D,
-    0x46, 0x39, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x47, 0x50, 0x53, 0x3B, 0x47, 0x4C, 0x4F, 0x3B, 0x47, 0x41,
-    0x4C, 0x3B, 0x42, 0x44, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x51, 0x5A, 0x53, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0xBD, 0x36};
-
-  send(d, sizeof(d));
+  typedef UbxMonVER M;
+  static const char * extensions[] = {
+    "ROM BASE 0x118B2060", "FWVER=HPG 1.12", "PROTVER=27.11", "MOD=ZED-F9P", "GPS;GLO;GAL;BDS",
+    "QZSS",
+  };
+  static constexpr std::size_t n = sizeof(extensions) / sizeof(extensions[0]);
+  static constexpr uint16_t length = M::LENGTH + M::EXTENSION_SIZE * n;
+  static uint8_t d[UbxFrame<M>::HEADER_SIZE + length + UbxFrame<M>::CHECKSUM_SIZE];
+
+  // Never changes, so encode only once
+  static const std::size_t size = [] {
+    UbxFrame<M> f(d, length);
+    f.setBytes(M::swVersion, "EXT CORE 1.00 (61b2dd)", strlen("EXT CORE 1.00 (61b2dd)"));
+    f.setBytes(M::hwVersion, "00190000", strlen("00190000"));
+    for (std::size_t i = 0; i < n; ++i) {
+      f.setBytes(M::extension + M::EXTENSION_SIZE * i, extensions[i], strlen(extensions[i]));
+    }
+    return f.finish();
+  }();
+
+  write(d, size);
 }
 
 void FakeGNSSSimulator::handleUbxCfgPRT(const uint8_t * data)
 {
-  uint8_t d[] = {0xB5, 0x62, 0x06, 0x00, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00,
-                 0xC0, 0x08, 0x00, 0x00, 0x00, 0xE1, 0x00, 0x00, 0x07, 0x00,
-                 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xCD, 0xC3};
+  typedef UbxCfgPRT M;
+  static const uint32_t baudrate_keys[] = {0, CFG_UART1_BAUDRATE, CFG_UART2_BAUDRATE, 0, 0};
+  uint16_t length = data[4] | (data[5] << 8);
+  const uint8_t * p = data + UbxFrame<M>::HEADER_SIZE;
+
+  // Poll without port ID is for the current port
+  uint8_t port = (length > 0) ? p[M::portID::offset] : linkPort(reply_link_);
+  if (port > PORT_ID_SPI || cfg_prot_keys[port][0] == 0) {
+    sendUbxAck(false, data[2], data[3]);
+    return;
+  }
 
-  send(d, sizeof(d));
+  // Poll request
+  if (length <= 1) {
+    uint8_t d[UbxFrame<M>::HEADER_SIZE + M::LENGTH + UbxFrame<M>::CHECKSUM_SIZE];
+    UbxFrame<M> f(d);
+    uint16_t in = 0;
+    uint16_t out = 0;
+    for (const auto & prot : cfg_protocols) {
+      if (cfg_.get(cfg_prot_keys[port][0] + prot.offset_)) in |= prot.mask_;
+      if (cfg_.get(cfg_prot_keys[port][1] + prot.offset_)) out |= prot.mask_;
+    }
+    f.set<M::portID>(port);
+    if (baudrate_keys[port] != 0) {
+      f.set<M::mode>(0x000008C0);
+      f.set<M::baudRate>(cfg_.get(baudrate_keys[port]));
+    }
+    f.set<M::inProtoMask>(in);
+    f.set<M::outProtoMask>(out);
+    write(d, f.finish());
+    return;
+  }
+
+  bool f = length == M::LENGTH;
+  uint32_t baudrate = 0;
+  uint16_t in = 0;
+  uint16_t out = 0;
+  if (f) {
+    memcpy(&baudrate, &p[M::baudRate::offset], sizeof(baudrate));
+    memcpy(&in, &p[M::inProtoMask::offset], sizeof(in));
+    memcpy(&out, &p[M::outProtoMask::offset], sizeof(out));
+  }
+  if (f && baudrate_keys[port] != 0) f = cfg_.set(baudrate_keys[port], baudrate, CfgDb::LAYER_RAM);
+  for (const auto & prot : cfg_protocols) {
+    uint32_t in_key = cfg_prot_keys[port][0] + prot.offset_;
+    uint32_t out_key = cfg_prot_keys[port][1] + prot.offset_;
+    f = f && cfg_.set(in_key, (in & prot.mask_) != 0, CfgDb::LAYER_RAM);
+    f = f && cfg_.set(out_key, (out & prot.mask_) != 0, CfgDb::LAYER_RAM);
+  }
+  endTransaction(f, 0);
+
+  sendUbxAck(f, data[2], data[3]);
 }
 
 void FakeGNSSSimulator::handleUbxCfgMSG(const uint8_t * data)
 {
-  auto it = periodic_map_.find(UBX_ID(data[6], data[7]));
-  bool f = false;
+  typedef UbxCfgMSG M;
+  uint16_t length = data[4] | (data[5] << 8);
+  const uint8_t * p = data + UbxFrame<M>::HEADER_SIZE;
+  uint8_t message_class = (length >= 2) ? p[M::msgClass::offset] : 0;
+  uint8_t message_id = (length >= 2) ? p[M::msgID::offset] : 0;
+  MESSAGE_ENTRY * m = (length >= 2) ? findMessage(message_class, message_id) : nullptr;
+  uint16_t key = UBX_ID(message_class, message_id).key();
+  bool f = m != nullptr && (m->encode_ != nullptr || m->cfg_key_ != 0 || log_.contains(key));
+
+  // Poll request is answered with rates of all ports
+  if (f && length == 2) {
+    uint8_t d[UbxFrame<M>::HEADER_SIZE + M::LENGTH + UbxFrame<M>::CHECKSUM_SIZE];
+    UbxFrame<M> r(d);
+    r.set<M::msgClass>(message_class);
+    r.set<M::msgID>(message_id);
+    pthread_mutex_lock(&mutex_stop_);
+    for (int port = PORT_ID_I2C; port < PORTS; ++port) r.set<M::rate>(m->rates_[port], port);
+    pthread_mutex_unlock(&mutex_stop_);
+    write(d, r.finish());
+    return;
+  }
 
-  if (it != periodic_map_.end()) {
-    it->second.rate_ = (SLEEP_CNT_1MS / data[8]) - ADJUST_COUNT;
-    it->second.cnt_ = it->second.rate_;
-    f = true;
+  // Rate of the current port, or rates of all ports
+  uint32_t current = linkPort(reply_link_);
+  f = f && (length == 3 || length == 8);
+  if (f && m->cfg_key_ != 0) {
+    for (uint32_t port = PORT_ID_I2C; port <= PORT_ID_SPI; ++port) {
+      if (length == 3 && port != current) continue;
+      f = f && cfg_.set(m->cfg_key_ + port, data[(length == 3) ? 8 : 8 + port], CfgDb::LAYER_RAM);
+    }
+    endTransaction(f, 0);
+  } else if (f) {
+    // Messages found only in log are not in configuration
+    pthread_mutex_lock(&mutex_stop_);
+    for (uint32_t port = PORT_ID_I2C; port <= PORT_ID_SPI; ++port) {
+      if (length == 3 && port != current) continue;
+      setRate(key, port, data[(length == 3) ? 8 : 8 + port]);
+    }
+    pthread_mutex_unlock(&mutex_stop_);
   }
 
   sendUbxAck(f, data[2], data[3]);
 }
 
+void FakeGNSSSimulator::handleUbxCfgRST(const uint8_t * data)
+{
+  // Any reset reloads configuration from BBR or flash, and is not acknowledged
+  cfg_.reset();
+  applyConfig();
+}
+
+void FakeGNSSSimulator::handleUbxCfgRATE(const uint8_t * data)
+{
+  typedef UbxCfgRATE M;
+  uint16_t length = data[4] | (data[5] << 8);
+
+  // Poll request
+  if (length == 0) {
+    uint8_t d[UbxFrame<M>::HEADER_SIZE + M::LENGTH + UbxFrame<M>::CHECKSUM_SIZE];
+    UbxFrame<M> f(d);
+    f.set<M::measRate>(meas_rate_);
+    f.set<M::navRate>(nav_rate_);
+    f.set<M::timeRef>(time_ref_);
+    write(d, f.finish());
+    return;
+  }
+
+  bool f = length == M::LENGTH;
+  uint16_t meas_rate = 0;
+  uint16_t nav_rate = 0;
+  uint16_t time_ref = 0;
+  if (f) {
+    memcpy(&meas_rate, &data[UbxFrame<M>::HEADER_SIZE + M::measRate::offset], sizeof(meas_rate));
+    memcpy(&nav_rate, &data[UbxFrame<M>::HEADER_SIZE + M::navRate::offset], sizeof(nav_rate));
+    memcpy(&time_ref, &data[UbxFrame<M>::HEADER_SIZE + M::timeRef::offset], sizeof(time_ref));
+  }
+  f = f && cfg_.set(CFG_RATE_MEAS, meas_rate, CfgDb::LAYER_RAM);
+  f = f && cfg_.set(CFG_RATE_NAV, nav_rate, CfgDb::LAYER_RAM);
+  f = f && cfg_.set(CFG_RATE_TIMEREF, time_ref, CfgDb::LAYER_RAM);
+  endTransaction(f, 0);
+
+  sendUbxAck(f, data[2], data[3]);
+}
+
+void FakeGNSSSimulator::handleUbxCfgVALSET(const uint8_t * data)
+{
+  typedef UbxCfgVALSET M;
+  uint16_t length = data[4] | (data[5] << 8);
+  const uint8_t * p = data + UbxFrame<M>::HEADER_SIZE;
+
+  bool f = length >= M::LENGTH && p[M::version::offset] <= 1;
+  uint8_t transaction = (f && p[M::version::offset] == 1) ? p[M::transaction::offset] & 0x03 : 0;
+  if (transaction <= 1) cfg_.rollback();
+
+  uint8_t layers = f ? p[M::layers::offset] : 0;
+  for (std::size_t i = M::cfgData; f && i < length;) {
+    uint32_t key;
+    uint64_t value = 0;
+    if (i + sizeof(key) > length) f = false;
+    if (f) memcpy(&key, &p[i], sizeof(key));
+    std::size_t size = f ? CfgDb::valueSize(key) : 0;
+    if (size == 0 || i + sizeof(key) + size > length) f = false;
+    if (f) memcpy(&value, &p[i + sizeof(key)], size);
+    f = f && cfg_.set(key, value, layers);
+    i += sizeof(key) + size;
+  }
+  endTransaction(f, transaction);
+
+  sendUbxAck(f, data[2], data[3]);
+}
+
+void FakeGNSSSimulator::handleUbxCfgVALGET(const uint8_t * data)
+{
+  typedef UbxCfgVALGET M;
+  uint16_t length = data[4] | (data[5] << 8);
+  const uint8_t * p = data + UbxFrame<M>::HEADER_SIZE;
+
+  std::size_t n = (length > M::LENGTH) ? (length - M::LENGTH) / sizeof(uint32_t) : 0;
+  bool f = n > 0 && n <= M::MAX_KEYS && length == M::LENGTH + n * sizeof(uint32_t);
+  uint8_t layer = f ? p[M::layer::offset] : 0;
+  f = f && p[M::version::offset] == 0;
+  f = f && (layer == CfgDb::RAM || layer == CfgDb::BBR || layer == CfgDb::FLASH ||
+            layer == CfgDb::DEFAULT);
+
+  // Wildcards may match more items than a response holds, position skips ones already returned
+  cfg_values_.clear();
+  for (std::size_t i = 0; f && i < n; ++i) {
+    uint32_t key;
+    memcpy(&key, &p[M::cfgData + i * sizeof(key)], sizeof(key));
+    f = cfg_.select(key, static_cast<CfgDb::Layer>(layer), cfg_values_);
+  }
+  uint16_t position = 0;
+  if (f) memcpy(&position, &p[M::position::offset], sizeof(position));
+  std::size_t begin = std::min<std::size_t>(position, cfg_values_.size());
+  std::size_t end = std::min(begin + M::MAX_KEYS, cfg_values_.size());
+  if (!f || begin == end) {
+    sendUbxAck(false, data[2], data[3]);
+    return;
+  }
+
+  std::size_t size = M::LENGTH;
+  for (std::size_t i = begin; i < end; ++i) {
+    size += sizeof(uint32_t) + CfgDb::valueSize(cfg_values_[i].first);
+  }
+  std::vector<uint8_t> d(UbxFrame<M>::HEADER_SIZE + size + UbxFrame<M>::CHECKSUM_SIZE);
+  UbxFrame<M> r(&d[0], size);
+  r.set<M::version>(0x01);
+  r.set<M::layer>(layer);
+  r.set<M::position>(position);
+  std::size_t offset = M::cfgData;
+  for (std::size_t i = begin; i < end; ++i) {
+    const CfgDb::Value & v = cfg_values_[i];
+    r.setBytes(offset, &v.first, sizeof(v.first));
+    offset += sizeof(v.first);
+    r.setBytes(offset, &v.second, CfgDb::valueSize(v.first));
+    offset += CfgDb::valueSize(v.first);
+  }
+  write(&d[0], r.finish());
+
+  sendUbxAck(true, data[2], data[3]);
+}
+
+void FakeGNSSSimulator::handleUbxCfgVALDEL(const uint8_t * data)
+{
+  typedef UbxCfgVALDEL M;
+  uint16_t length = data[4] | (data[5] << 8);
+  const uint8_t * p = data + UbxFrame<M>::HEADER_SIZE;
+
+  bool f = length >= M::LENGTH && (length - M::LENGTH) % sizeof(uint32_t) == 0;
+  f = f && p[M::version::offset] <= 1;
+  uint8_t transaction = (f && p[M::version::offset] == 1) ? p[M::transaction::offset] & 0x03 : 0;
+  if (transaction <= 1) cfg_.rollback();
+
+  uint8_t layers = f ? p[M::layers::offset] : 0;
+  for (std::size_t i = M::keys; f && i < length; i += sizeof(uint32_t)) {
+    uint32_t key;
+    memcpy(&key, &p[i], sizeof(key));
+    f = cfg_.del(key, layers);
+  }
+  endTransaction(f, transaction);
+
+  sendUbxAck(f, data[2], data[3]);
+}
+
 void FakeGNSSSimulator::sendUbxAck(bool ack, uint8_t message_class, uint8_t message_id)
 {
-  uint8_t data[] = {0xB5, 0x62, 0x05, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00};
-  data[3] = ack ? 0x01 : 0x00;
-  data[6] = message_class;
-  data[7] = message_id;
+  typedef UbxAckACK M;
+  uint8_t d[UbxFrame<M>::HEADER_SIZE + M::LENGTH + UbxFrame<M>::CHECKSUM_SIZE];
+
+  UbxFrame<M> f(d);
+  f.set<M::clsID>(message_class);
+  f.set<M::msgID>(message_id);
+  // UBX-ACK-NAK shares the layout with id 0x00
+  if (!ack) d[3] = 0x00;
+  write(d, f.finish());
+}
+
+void FakeGNSSSimulator::sendUbxRxmRTCM(uint8_t flags, uint16_t station, uint16_t type)
+{
+  typedef UbxRxmRTCM M;
+  uint8_t d[UbxFrame<M>::HEADER_SIZE + M::LENGTH + UbxFrame<M>::CHECKSUM_SIZE];
 
-  send(data, sizeof(data));
+  // Sent on every message received, by every port on which it is enabled at any rate
+  uint8_t links = 0;
+  const MESSAGE_ENTRY * m = findMessage(M::CLASS_ID, M::MESSAGE_ID);
+  pthread_mutex_lock(&mutex_stop_);
+  for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+    PortId port = linkPort(link);
+    if (outputs_[link].port_ && protocols_[port].out_ubx_ && m->rates_[port] > 0) {
+      links |= 1 << link;
+    }
+  }
+  pthread_mutex_unlock(&mutex_stop_);
+  if (links == 0) return;
+
+  UbxFrame<M> f(d);
+  f.set<M::version>(0x02);
+  f.set<M::flags>(flags);
+  f.set<M::refStation>(station);
+  f.set<M::msgType>(type);
+  std::vector<as::const_buffer> buffers(1, as::buffer(d, f.finish()));
+  for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+    if (links & (1 << link)) write(buffers, static_cast<Link>(link));
+  }
 }
 
-void FakeGNSSSimulator::sendUbxNavSTATUS(void)
+void FakeGNSSSimulator::getNavSolution(NavSolution & s)
 {
-  uint8_t d[] = {0xB5, 0x62, 0x01, 0x03, 0x10, 0x00, 0x38, 0x4A, 0x79, 0x17, 0x03, 0xDD,
-                 0x00, 0x00, 0xC4, 0x05, 0x00, 0x00, 0xE6, 0x1C, 0x09, 0x00, 0xDA, 0xF0};
+  // All messages of an epoch carry its time
+  const GnssClock::Time & t = epoch_time_;
+  s.iTOW_ = t.iTOW_;
+  s.year_ = t.year_;
+  s.month_ = t.month_;
+  s.day_ = t.day_;
+  s.hour_ = t.hour_;
+  s.min_ = t.min_;
+  s.sec_ = t.sec_;
+  s.valid_ = 0x37;
+  s.tAcc_ = 15;
+  s.nano_ = t.nano_;
+  s.flags2_ = 0xEA;
+  s.lon_ = 71585350;
+  s.lat_ = 512786942;
+  s.height_ = 236035;
+  s.hMSL_ = 189510;
+  s.velN_ = -119;
+  s.velE_ = -27;
+  s.velD_ = -132;
+  s.gSpeed_ = 122;
+  s.headMot_ = 13237603;
+  s.sAcc_ = 511;
+  s.headAcc_ = 4918556;
+
+  if (!trajectory_.empty()) {
+    double elapsed = t.elapsed_;
+    Trajectory::Point pt;
+    trajectory_.sample(&elapsed, 1, &pt);
+
+    // Height above mean sea level uses the geoid separation of the default position
+    double speed = std::hypot(pt.velN_, pt.velE_);
+    double heading = std::atan2(pt.velE_, pt.velN_) * 180.0 / M_PI;
+    if (heading < 0) heading += 360.0;
+    s.lat_ = std::lround(pt.lat_ * 1e7);
+    s.lon_ = std::lround(pt.lon_ * 1e7);
+    s.height_ = std::lround(pt.height_ * 1e3);
+    s.hMSL_ = s.height_ - GEOID_SEPARATION;
+    s.velN_ = std::lround(pt.velN_ * 1e3);
+    s.velE_ = std::lround(pt.velE_ * 1e3);
+    s.velD_ = std::lround(pt.velD_ * 1e3);
+    s.gSpeed_ = std::lround(speed * 1e3);
+    s.headMot_ = std::lround(heading * 1e5) % 36000000;
+
+    // Heading is as uncertain as the speed error relative to ground speed, at most 180 deg
+    double head_acc = 180.0;
+    if (s.gSpeed_ > 0) head_acc = std::min(head_acc, std::atan2(s.sAcc_, s.gSpeed_) * 180.0 / M_PI);
+    s.headAcc_ = std::lround(head_acc * 1e5);
+  }
 
-  SpoofDetState s;
-  pthread_mutex_lock(&mutex_send_);
-  s = spoofDetState_;
-  pthread_mutex_unlock(&mutex_send_);
-  d[13] = s << 3;
-  send(d, sizeof(d));
+  // Satellites in view and the fix follow the simulated sky
+  updateSky(s);
+  s.numSats_ = 0;
+  s.numSV_ = 0;
+  for (std::size_t i = 0; i < sky_.n_ && s.numSats_ < NavSolution::MAX_SATELLITES; ++i) {
+    if (sky_.quality_[i] == 0) continue;
+    SatInfo & sat = s.sats_[s.numSats_++];
+    sat.gnssId_ = constellation_.gnssId(i);
+    sat.svId_ = constellation_.svId(i);
+    sat.elev_ = std::lround(sky_.elev_[i]);
+    sat.azim_ = std::lround(sky_.azim_[i]) % 360;
+    sat.cno_ = sky_.visible_[i] ? std::lround(sky_.cno_[i]) : 0;
+    sat.used_ = sky_.used_[i];
+    s.numSV_ += sat.used_;
+  }
+  double pdop, hdop, vdop;
+  bool fix = Constellation::dop(sky_, pdop, hdop, vdop);
+  s.fixType_ = fix ? 0x03 : 0x00;
+  s.flags_ = fix ? 0x01 : 0x00;
+  s.pDOP_ = fix ? std::min<long>(std::lround(pdop * 100), NO_FIX_DOP) : NO_FIX_DOP;
+  s.hDOP_ = fix ? std::min<long>(std::lround(hdop * 100), NO_FIX_DOP) : NO_FIX_DOP;
+  s.vDOP_ = fix ? std::min<long>(std::lround(vdop * 100), NO_FIX_DOP) : NO_FIX_DOP;
+
+  // Corrections set diffSoln, and carrSoln once carrier phase converges
+  RtkState::Solution rtk = fix ? rtk_solution_ : RtkState::RTK_NONE;
+  if (rtk != RtkState::RTK_NONE) s.flags_ |= 0x02;
+  if (rtk >= RtkState::RTK_FLOAT) s.flags_ |= (rtk - RtkState::RTK_DGNSS) << 6;
+  s.hAcc_ = std::lround(s.hDOP_ * RTK_UERE[rtk] * 10);
+  s.vAcc_ = std::lround(s.vDOP_ * RTK_UERE[rtk] * 10);
+
+  // lastCorrectionAge is coded in ranges
+  uint8_t age = 0;
+  if (correction_age_ >= 0) {
+    age = 1 + (std::upper_bound(std::begin(CORRECTION_AGES), std::end(CORRECTION_AGES),
+                                correction_age_) - std::begin(CORRECTION_AGES));
+  }
+  s.flags3_ = age << 1;
 }
 
-void FakeGNSSSimulator::sendUbxNavPVT(void)
+std::size_t FakeGNSSSimulator::encodeUbxNavSTATUS(uint8_t * buf, bool update)
 {
-  uint8_t d[] = {0xB5, 0x62, 0x01, 0x07, 0x5C, 0x00, 0x50, 0x32, 0x20, 0x17, 0xE3, 0x07, 0x0A,
-                 0x11, 0x0B, 0x2E, 0x08, 0x37, 0x0F, 0x00, 0x00, 0x00, 0x2E, 0x3A, 0x01, 0x00,
-                 0x03, 0x01, 0xEA, 0x0F, 0x46, 0x4E, 0x44, 0x04, 0xFE, 0x81, 0x90, 0x1E, 0x03,
-                 0x9A, 0x03, 0x00, 0x46, 0xE4, 0x02, 0x00, 0xD3, 0x10, 0x00, 0x00, 0xB9, 0x1B,
-                 0x00, 0x00, 0x89, 0xFF, 0xFF, 0xFF, 0xE5, 0xFF, 0xFF, 0xFF, 0x7C, 0xFF, 0xFF,
-                 0xFF, 0x7A, 0x00, 0x00, 0x00, 0x63, 0xFD, 0xC9, 0x00, 0xFF, 0x01, 0x00, 0x00,
-                 0x1C, 0x0D, 0x4B, 0x00, 0x8D, 0x00, 0x00, 0x00, 0xB8, 0x41, 0x47, 0x3D, 0x00,
-                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x9D, 0x7C};
+  typedef UbxNavSTATUS M;
+
+  // Scripted state takes precedence over the one set by hand
+  uint8_t spoof = state_.load().spoofDetState_;
+  const Interference::Sample * j = interference_.at(scriptTime());
+  if (j != nullptr) spoof = j->spoofDetState_;
+  NavSolution s;
+  getNavSolution(s);
+
+  UbxFrame<M> f = update ? UbxFrame<M>::update(buf) : UbxFrame<M>(buf);
+  if (!update) f.set<M::ttff>(1476);
+  f.set<M::iTOW>(epoch_time_.iTOW_);
+  f.set<M::gpsFix>(s.fixType_);
+  f.set<M::flags>(0xDC | (s.flags_ & 0x01));
+  f.set<M::flags2>(spoof << 3);
+  f.set<M::msss>(std::lround(epoch_time_.elapsed_ * 1000));
+  return f.finish();
+}
 
-  time_t nowt = time(nullptr);
-  struct tm now;
-  gmtime_r(&nowt, &now);
-  uint16_t * year = reinterpret_cast<uint16_t *>(&d[10]);
-  *year = now.tm_year + 1900;
-  d[12] = now.tm_mon + 1;
-  d[13] = now.tm_mday;
-  d[14] = now.tm_hour;
-  d[15] = now.tm_min;
-  d[16] = now.tm_sec;
+std::size_t FakeGNSSSimulator::encodeUbxNavPVT(uint8_t * buf, bool update)
+{
+  NavSolution s;
+  getNavSolution(s);
+  return encodeUbxNavPVT(buf, update, s);
+}
 
-  send(d, sizeof(d));
+std::size_t FakeGNSSSimulator::encodeUbxNavPVT(uint8_t * buf, bool update, const NavSolution & s)
+{
+  typedef UbxNavPVT M;
+
+  UbxFrame<M> f = update ? UbxFrame<M>::update(buf) : UbxFrame<M>(buf);
+  f.set<M::iTOW>(s.iTOW_);
+  f.set<M::year>(s.year_);
+  f.set<M::month>(s.month_);
+  f.set<M::day>(s.day_);
+  f.set<M::hour>(s.hour_);
+  f.set<M::min>(s.min_);
+  f.set<M::sec>(s.sec_);
+  f.set<M::valid>(s.valid_);
+  f.set<M::tAcc>(s.tAcc_);
+  f.set<M::nano>(s.nano_);
+  f.set<M::fixType>(s.fixType_);
+  f.set<M::flags>(s.flags_);
+  f.set<M::flags2>(s.flags2_);
+  f.set<M::numSV>(s.numSV_);
+  f.set<M::lon>(s.lon_);
+  f.set<M::lat>(s.lat_);
+  f.set<M::height>(s.height_);
+  f.set<M::hMSL>(s.hMSL_);
+  f.set<M::hAcc>(s.hAcc_);
+  f.set<M::vAcc>(s.vAcc_);
+  f.set<M::velN>(s.velN_);
+  f.set<M::velE>(s.velE_);
+  f.set<M::velD>(s.velD_);
+  f.set<M::gSpeed>(s.gSpeed_);
+  f.set<M::headMot>(s.headMot_);
+  f.set<M::sAcc>(s.sAcc_);
+  f.set<M::headAcc>(s.headAcc_);
+  f.set<M::pDOP>(s.pDOP_);
+  f.set<M::flags3>(s.flags3_);
+  return f.finish();
 }
 
-void FakeGNSSSimulator::sendUbxNavRELPOSNED(void)
+void FakeGNSSSimulator::getBaseline(const NavSolution & s, double ned[3]) const
 {
-  uint8_t d[] = {0xB5, 0x62, 0x01, 0x3C, 0x40, 0x00, 0x01, 0x00, 0x00, 0x00, 0xB0, 0xAF,
-                 0x47, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x86};
+  // Vehicle heads in the direction of motion
+  double heading = s.headMot_ * 1e-5 * M_PI / 180.0;
+  double c = std::cos(heading);
+  double d = std::sin(heading);
+  ned[0] = lever_arm_[0] * c - lever_arm_[1] * d;
+  ned[1] = lever_arm_[0] * d + lever_arm_[1] * c;
+  ned[2] = lever_arm_[2];
+}
 
-  send(d, sizeof(d));
+void FakeGNSSSimulator::getRoverSolution(NavSolution & s) const
+{
+  double ned[3];
+  getBaseline(s, ned);
+
+  // Offset base position by the baseline in ECEF, velocity is shared
+  double lat = s.lat_ * 1e-7 * M_PI / 180.0;
+  double lon = s.lon_ * 1e-7 * M_PI / 180.0;
+  double h = s.height_ * 1e-3;
+  double x, y, z, dx, dy, dz;
+  geodeticToEcef(&lat, &lon, &h, 1, &x, &y, &z);
+  nedToEcef(&lat, &lon, &ned[0], &ned[1], &ned[2], 1, &dx, &dy, &dz);
+  x += dx;
+  y += dy;
+  z += dz;
+  ecefToGeodetic(&x, &y, &z, 1, &lat, &lon, &h);
+
+  int32_t height = std::lround(h * 1e3);
+  s.lat_ = std::lround(lat * 180.0 / M_PI * 1e7);
+  s.lon_ = std::lround(lon * 180.0 / M_PI * 1e7);
+  s.hMSL_ += height - s.height_;
+  s.height_ = height;
 }
 
-void FakeGNSSSimulator::sendUbxMonHW(void)
+std::size_t FakeGNSSSimulator::encodeUbxNavSAT(uint8_t * buf, bool update)
 {
-  uint8_t d[] = {0xB5, 0x62, 0x0A, 0x09, 0x3C, 0x00, 0x00, 0xC4, 0x01, 0x00, 0x00, 0x28, 0x00, 0x00,
-                 0x00, 0x00, 0x01, 0x00, 0xEF, 0xC7, 0x01, 0x00, 0x78, 0x00, 0x5C, 0x0A, 0x02, 0x01,
-                 0x00, 0x84, 0xFF, 0x7B, 0x01, 0x00, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x01, 0x00,
-                 0x02, 0x03, 0xFF, 0x05, 0x11, 0x04, 0x13, 0xFF, 0x35, 0x08, 0x0F, 0x5E, 0x00, 0x00,
-                 0x00, 0x00, 0x80, 0xEF, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6A, 0xEB};
+  typedef UbxNavSAT M;
+
+  // Satellites rise and set, so the frame is encoded from scratch
+  NavSolution s;
+  getNavSolution(s);
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < sky_.n_; ++i) n += sky_.quality_[i] > 0;
+
+  UbxFrame<M> f(buf, M::LENGTH + M::BLOCK_SIZE * n);
+  f.set<M::iTOW>(epoch_time_.iTOW_);
+  f.set<M::version>(0x01);
+  f.set<M::numSvs>(n);
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < sky_.n_; ++i) {
+    if (sky_.quality_[i] == 0) continue;
+    // Healthy, with orbits from ephemeris once tracked and from almanac otherwise
+    uint32_t flags = sky_.quality_[i] | (sky_.used_[i] << 3) | (1 << 4) | (1 << 12);
+    flags |= sky_.visible_[i] ? (1 << 8) | (1 << 11) : (2 << 8);
+    f.set<M::gnssId>(constellation_.gnssId(i), k);
+    f.set<M::svId>(constellation_.svId(i), k);
+    f.set<M::cno>(sky_.visible_[i] ? std::lround(sky_.cno_[i]) : 0, k);
+    f.set<M::elev>(std::lround(sky_.elev_[i]), k);
+    f.set<M::azim>(std::lround(sky_.azim_[i]) % 360, k);
+    f.set<M::flags>(flags, k);
+    ++k;
+  }
+  return f.finish();
+}
 
-  AStatus a;
-  JammingState j;
-  pthread_mutex_lock(&mutex_send_);
-  a = aStatus_;
-  j = jammingState_;
-  pthread_mutex_unlock(&mutex_send_);
+std::size_t FakeGNSSSimulator::encodeUbxNavSIG(uint8_t * buf, bool update)
+{
+  typedef UbxNavSIG M;
+
+  // One L1 signal of each satellite, whose sigId is 0 in every GNSS
+  NavSolution s;
+  getNavSolution(s);
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < sky_.n_; ++i) n += sky_.quality_[i] > 0;
+
+  UbxFrame<M> f(buf, M::LENGTH + M::BLOCK_SIZE * n);
+  f.set<M::iTOW>(epoch_time_.iTOW_);
+  f.set<M::version>(0x00);
+  f.set<M::numSigs>(n);
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < sky_.n_; ++i) {
+    if (sky_.quality_[i] == 0) continue;
+    // Healthy, with pseudorange, carrier range and Doppler used when in the solution
+    uint16_t sig_flags = 0x01 | (sky_.used_[i] ? 0x38 : 0x00);
+    f.set<M::gnssId>(constellation_.gnssId(i), k);
+    f.set<M::svId>(constellation_.svId(i), k);
+    f.set<M::freqId>(constellation_.freqId(i), k);
+    f.set<M::cno>(sky_.visible_[i] ? std::lround(sky_.cno_[i]) : 0, k);
+    f.set<M::qualityInd>(sky_.quality_[i], k);
+    f.set<M::ionoModel>(sky_.used_[i] ? 0x01 : 0x00, k);
+    f.set<M::sigFlags>(sig_flags, k);
+    ++k;
+  }
+  return f.finish();
+}
+
+std::size_t FakeGNSSSimulator::encodeUbxNavRELPOSNED(uint8_t * buf, bool update)
+{
+  // Baseline of moving base follows the corrections it receives
+  NavSolution s;
+  getNavSolution(s);
+  RtkState::Solution rtk = (s.fixType_ != 0x00) ? rtk_solution_ : RtkState::RTK_NONE;
+  return encodeUbxNavRELPOSNED(buf, update, s, rtk, reference_station_);
+}
+
+std::size_t FakeGNSSSimulator::encodeUbxNavRELPOSNED(
+  uint8_t * buf, bool update, const NavSolution & s, RtkState::Solution solution,
+  uint16_t station)
+{
+  typedef UbxNavRELPOSNED M;
+
+  double ned[3];
+  getBaseline(s, ned);
+  double length = std::sqrt(ned[0] * ned[0] + ned[1] * ned[1] + ned[2] * ned[2]);
+  double heading = std::atan2(ned[1], ned[0]) * 180.0 / M_PI;
+  if (heading < 0) heading += 360.0;
+
+  // Components are in cm, and the high precision parts add 0.1 mm of the same sign
+  auto split = [](double m, int32_t & cm, int8_t & hp) {
+    int64_t q = std::llround(m * 1e4);
+    cm = q / 100;
+    hp = q % 100;
+  };
+  int32_t cm[4];
+  int8_t hp[4];
+  split(ned[0], cm[0], hp[0]);
+  split(ned[1], cm[1], hp[1]);
+  split(ned[2], cm[2], hp[2]);
+  split(length, cm[3], hp[3]);
+
+  // Moving base, the baseline being valid with carrier phase solution, and its heading unless
+  // antennas coincide
+  uint32_t acc = BASELINE_ACC[solution];
+  uint32_t flags = 0x00000020 | (s.flags_ & 0x01);
+  uint32_t acc_heading = 0;
+  if (solution != RtkState::RTK_NONE) flags |= 0x00000002;
+  if (solution >= RtkState::RTK_FLOAT) {
+    flags |= 0x00000004 | ((solution - RtkState::RTK_DGNSS) << 3);
+    if (length > 0) {
+      flags |= 0x00000100;
+      acc_heading = std::lround(std::atan2(acc * 1e-4, length) * 180.0 / M_PI * 1e5);
+    }
+  }
+
+  UbxFrame<M> f = update ? UbxFrame<M>::update(buf) : UbxFrame<M>(buf);
+  if (!update) f.set<M::version>(0x01);
+  f.set<M::refStationId>(station);
+  f.set<M::iTOW>(s.iTOW_);
+  f.set<M::relPosN>(cm[0]);
+  f.set<M::relPosE>(cm[1]);
+  f.set<M::relPosD>(cm[2]);
+  f.set<M::relPosLength>(cm[3]);
+  f.set<M::relPosHeading>(std::lround(heading * 1e5) % 36000000);
+  f.set<M::relPosHPN>(hp[0]);
+  f.set<M::relPosHPE>(hp[1]);
+  f.set<M::relPosHPD>(hp[2]);
+  f.set<M::relPosHPLength>(hp[3]);
+  f.set<M::accN>(acc);
+  f.set<M::accE>(acc);
+  f.set<M::accD>(acc);
+  f.set<M::accLength>(acc);
+  f.set<M::accHeading>(acc_heading);
+  f.set<M::flags>(flags);
+  return f.finish();
+}
+
+uint64_t FakeGNSSSimulator::epochSeconds(void) const
+{
+  return static_cast<uint64_t>(epoch_time_.week_) * 604800 + epoch_time_.iTOW_ / 1000;
+}
+
+void FakeGNSSSimulator::updateSky(const NavSolution & s)
+{
+  double t = epoch_time_.week_ * Constellation::WEEK + epoch_time_.iTOW_ * 1e-3;
+  if (t == sky_time_) return;
+  sky_time_ = t;
+
+  // Receiver follows the navigation solution
+  double lat = s.lat_ * 1e-7 * M_PI / 180.0;
+  double lon = s.lon_ * 1e-7 * M_PI / 180.0;
+  double h = s.height_ * 1e-3;
+  double vn = s.velN_ * 1e-3;
+  double ve = s.velE_ * 1e-3;
+  double vd = s.velD_ * 1e-3;
+  double pos[3], vel[3];
+  geodeticToEcef(&lat, &lon, &h, 1, &pos[0], &pos[1], &pos[2]);
+  nedToEcef(&lat, &lon, &vn, &ve, &vd, 1, &vel[0], &vel[1], &vel[2]);
+  constellation_.observe(t, pos, vel, lat, lon, sky_);
+
+  // Satellites drop out of tracking and of the solution as their signals weaken
+  if (obstruction_.empty() && interference_.empty()) return;
+  double elapsed = scriptTime();
+  obstruction_.apply(elapsed, sky_);
+  interference_.apply(elapsed, sky_);
+  Constellation::track(sky_);
+}
 
-  d[26] = a;
-  d[28] = j << 2;
-  send(d, sizeof(d));
+double FakeGNSSSimulator::scriptTime(void) const
+{
+  // Scripts run in the time of trajectory, repeating with it
+  double elapsed = epoch_time_.elapsed_;
+  if (!trajectory_.empty()) elapsed = std::fmod(elapsed, trajectory_.duration());
+  return elapsed;
+}
+
+std::size_t FakeGNSSSimulator::encodeUbxRxmRAWX(uint8_t * buf, bool update)
+{
+  typedef UbxRxmRAWX M;
+
+  // Number of measurements changes, so the frame is encoded from scratch
+  NavSolution s;
+  getNavSolution(s);
+  raw_model_.measure(sky_time_, constellation_, sky_, raw_);
+  std::size_t n = std::min(raw_.n_, M::MAX_MEAS);
+
+  UbxFrame<M> f(buf, M::LENGTH + M::BLOCK_SIZE * n);
+  f.set<M::rcvTow>(epoch_time_.iTOW_ * 1e-3);
+  f.set<M::week>(epoch_time_.week_);
+  f.set<M::leapS>(epoch_time_.leapSeconds_);
+  f.set<M::numMeas>(n);
+  f.set<M::recStat>(0x01 | (raw_.clockReset_ << 1));
+  f.set<M::version>(0x01);
+  for (std::size_t k = 0; k < n; ++k) {
+    std::size_t i = raw_.index_[k];
+    f.set<M::prMes>(raw_.prMes_[k], k);
+    f.set<M::cpMes>(raw_.cpMes_[k], k);
+    f.set<M::doMes>(raw_.doMes_[k], k);
+    f.set<M::gnssId>(constellation_.gnssId(i), k);
+    f.set<M::svId>(constellation_.svId(i), k);
+    f.set<M::freqId>(constellation_.freqId(i), k);
+    f.set<M::locktime>(raw_.locktime_[k], k);
+    f.set<M::cno>(raw_.cno_[k], k);
+    f.set<M::prStdev>(raw_.prStdev_[k], k);
+    f.set<M::cpStdev>(raw_.cpStdev_[k], k);
+    f.set<M::doStdev>(raw_.doStdev_[k], k);
+    f.set<M::trkStat>(0x0F, k);
+  }
+  return f.finish();
+}
+
+std::size_t FakeGNSSSimulator::encodeUbxRxmSFRBX(uint8_t * buf, bool update)
+{
+  typedef UbxRxmSFRBX M;
+
+  // A subframe is sent once it is received completely, by each GPS satellite in view
+  uint64_t subframe = epochSeconds() / GPS_LNAV_SUBFRAME;
+  if (subframe == subframe_) return 0;
+  subframe_ = subframe;
+
+  uint64_t start = (subframe - 1) * GPS_LNAV_SUBFRAME;
+  uint16_t week = start / 604800;
+  uint32_t tow = start % 604800;
+  uint32_t toe = tow / EPHEMERIS_INTERVAL * EPHEMERIS_INTERVAL;
+  NavSolution s;
+  getNavSolution(s);
+
+  std::size_t size = 0;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < sky_.n_ && count < MAX_GPS_SATELLITES; ++i) {
+    if (constellation_.gnssId(i) != GNSS_ID_GPS || !sky_.visible_[i]) continue;
+    Constellation::Elements e;
+    uint32_t words[GPS_LNAV_WORDS];
+    constellation_.elements(i, week, toe, e);
+    gpsLnavSubframe(e, tow, words);
+
+    UbxFrame<M> f(buf + size, M::LENGTH + M::WORD_SIZE * GPS_LNAV_WORDS);
+    f.set<M::gnssId>(GNSS_ID_GPS);
+    f.set<M::svId>(constellation_.svId(i));
+    f.set<M::numWords>(GPS_LNAV_WORDS);
+    f.set<M::chn>(count);
+    f.set<M::version>(0x02);
+    for (int w = 0; w < GPS_LNAV_WORDS; ++w) f.set<M::dwrd>(words[w], w);
+    size += f.finish();
+    ++count;
+  }
+  return size;
+}
+
+std::size_t FakeGNSSSimulator::encodeUbxMonHW(uint8_t * buf, bool update)
+{
+  typedef UbxMonHW M;
+  static const uint8_t vp[M::VP_SIZE] = {0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x01, 0x00, 0x02,
+                                         0x03, 0xFF, 0x05, 0x11, 0x04, 0x13, 0xFF, 0x35};
+
+  // Scripted interference takes precedence over the states set by hand
+  STATE s = state_.load();
+  Interference::Sample j = {0, 2652, 120, 8, static_cast<uint8_t>(s.jammingState_), 0,
+                            static_cast<uint8_t>(s.aStatus_)};
+  const Interference::Sample * scripted = interference_.at(scriptTime());
+  if (scripted != nullptr) j = *scripted;
+
+  UbxFrame<M> f = update ? UbxFrame<M>::update(buf) : UbxFrame<M>(buf);
+  if (!update) {
+    f.set<M::pinSel>(0x0001C400);
+    f.set<M::pinBank>(0x00002800);
+    f.set<M::pinDir>(0x00010000);
+    f.set<M::pinVal>(0x0001C7EF);
+    f.set<M::aPower>(0x01);
+    f.set<M::usedMask>(0x00017BFF);
+    f.setBytes(M::VP, vp, sizeof(vp));
+    f.set<M::pullH>(0x0001EF80);
+  }
+  f.set<M::noisePerMS>(j.noisePerMS_);
+  f.set<M::agcCnt>(j.agcCnt_);
+  f.set<M::jamInd>(j.jamInd_);
+  f.set<M::aStatus>(j.aStatus_);
+  f.set<M::flags>(j.jammingState_ << 2);
+  return f.finish();
 }
 
-void FakeGNSSSimulator::sendUbxMonCOMMS(void)
+std::size_t FakeGNSSSimulator::encodeUbxMonCOMMS(uint8_t * buf, bool update)
 {
-  std::vector<uint8_t> d{0xB5, 0x62, 0x0A, 0x36, 0x00, 0x00, 0x00,
-                         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  typedef UbxMonCOMMS M;
 
-  for (const auto & p : port_blocks_) {
-    uint8_t b[40] = {};
-    if (p.second.port_enabled) {
-      // nPorts
-      ++d[7];
-      uint16_t * portId = reinterpret_cast<uint16_t *>(&b[0]);
-      *portId = p.first;
-      b[8] = p.second.tx_usage;
-      d.insert(d.end(), &b[0], &b[sizeof(b)]);
+  const STATE state = state_.load();
+  // Ports opened report themselves, whatever is set by hand
+  bool open[PORTS] = {};
+  for (int link = LINK_UART1; link < BASE_LINKS; ++link) {
+    open[linkPort(link)] = outputs_[link].port_ != nullptr;
+  }
+  uint8_t n = 0;
+  for (uint16_t port = PORT_ID_I2C; port <= PORT_ID_SPI; ++port) {
+    if (open[port] || state.port_blocks_[port].port_enabled) ++n;
+  }
+
+  // Number of ports determines the length, patch only if it is unchanged
+  uint16_t length = M::LENGTH + M::BLOCK_SIZE * n;
+  if (update && (buf[4] | (buf[5] << 8)) != length) update = false;
+  UbxFrame<M> f = update ? UbxFrame<M>::update(buf) : UbxFrame<M>(buf, length);
+  f.set<M::nPorts>(n);
+  std::size_t i = 0;
+  uint8_t tx_errors = 0;
+  for (uint16_t port = PORT_ID_I2C; port <= PORT_ID_SPI; ++port) {
+    const PortBlock & p = state.port_blocks_[port];
+    if (!open[port] && !p.port_enabled) continue;
+    f.set<M::portId>(port, i);
+    if (open[port]) {
+      // Serial port reports what its transmit buffer went through
+      UartModel::Statistics s;
+      pthread_mutex_lock(&mutex_write_);
+      outputs_[port - PORT_ID_UART1].uart_.report(s);
+      pthread_mutex_unlock(&mutex_write_);
+      f.set<M::txPending>(s.txPending_, i);
+      f.set<M::txBytes>(s.txBytes_, i);
+      f.set<M::txUsage>(s.txUsage_, i);
+      f.set<M::txPeakUsage>(s.txPeakUsage_, i);
+      f.set<M::rxBytes>(s.rxBytes_, i);
+      if (s.overflow_) tx_errors |= 0x02;
+    } else {
+      f.set<M::txUsage>(p.tx_usage, i);
     }
+    ++i;
   }
+  f.set<M::txErrors>(tx_errors);
 
-  uint16_t * length = reinterpret_cast<uint16_t *>(&d[4]);
-  *length = d.size() - 6;
-  d.resize(d.size() + 2);
-  send(&d[0], d.size());
+  return f.finish();
 }
 
-void FakeGNSSSimulator::send(uint8_t * data, int size)
+std::size_t FakeGNSSSimulator::encodeUbxEsfMEAS(uint8_t * buf, bool update)
 {
-  calculateChecksum(&data[2], size - 4, data[size - 2], data[size - 1]);
-  std::vector<uint8_t> frame(data, data + size);
+  typedef UbxEsfMEAS M;
+
+  // Samples since the previous encoding are sent in one batch, a frame each
+  imu_model_.measure(trajectory_, sensor_rate_, sensor_time_, imu_);
+  std::size_t size = 0;
+  for (std::size_t k = 0; k < imu_.n_; ++k) {
+    const float values[ESF_SENSORS] = {imu_.gyro_[k][0],  imu_.gyro_[k][1],  imu_.gyro_[k][2],
+                                       imu_.accel_[k][0], imu_.accel_[k][1], imu_.accel_[k][2],
+                                       imu_.speed_[k]};
+    UbxFrame<M> f(buf + size, M::LENGTH + M::WORD_SIZE * ESF_SENSORS);
+    f.set<M::timeTag>(imu_.timeTag_[k]);
+    f.set<M::flags>(ESF_SENSORS << 11);
+    for (std::size_t i = 0; i < ESF_SENSORS; ++i) {
+      // Signed 24 bit data field with data type above it
+      long v = std::lround(values[i] * esf_sensors[i].scale_);
+      v = std::min(std::max(v, -0x800000L), 0x7FFFFFL);
+      f.set<M::data>((static_cast<uint32_t>(v) & 0xFFFFFF) | (esf_sensors[i].type_ << 24), i);
+    }
+    size += f.finish();
+  }
+  return size;
+}
 
-  bool b;
-  pthread_mutex_lock(&mutex_send_);
-  b = checksum_error_;
-  pthread_mutex_unlock(&mutex_send_);
+std::size_t FakeGNSSSimulator::encodeUbxEsfSTATUS(uint8_t * buf, bool update)
+{
+  typedef UbxEsfSTATUS M;
+
+  // Sensors are used and calibrated once fusion is initialized, wheel ticks being off
+  uint8_t init = fusion_ ? 2 : 1;
+  UbxFrame<M> f =
+    update ? UbxFrame<M>::update(buf) : UbxFrame<M>(buf, M::LENGTH + M::BLOCK_SIZE * ESF_SENSORS);
+  f.set<M::iTOW>(epoch_time_.iTOW_);
+  f.set<M::version>(0x02);
+  f.set<M::initStatus1>((init << 2) | (init << 5));
+  f.set<M::initStatus2>(init);
+  f.set<M::fusionMode>(fusion_ ? 1 : 0);
+  f.set<M::numSens>(ESF_SENSORS);
+  for (std::size_t i = 0; i < ESF_SENSORS; ++i) {
+    f.set<M::sensStatus1>(esf_sensors[i].type_ | (fusion_ << 6) | 0x80, i);
+    f.set<M::sensStatus2>((fusion_ ? 0x03 : 0x01) | (0x03 << 2), i);
+    f.set<M::freq>(sensor_rate_, i);
+  }
+  return f.finish();
+}
 
+std::size_t FakeGNSSSimulator::encodeUbxEsfINS(uint8_t * buf, bool update)
+{
+  typedef UbxEsfINS M;
+
+  // Fusion estimates motion free of sensor errors and gravity, valid once initialized
+  ImuModel::Motion m;
+  ImuModel::motion(trajectory_, sensor_rate_, epoch_time_.elapsed_, m);
+
+  UbxFrame<M> f = update ? UbxFrame<M>::update(buf) : UbxFrame<M>(buf);
+  f.set<M::bitfield0>(0x01 | (fusion_ ? 0x3F00 : 0));
+  f.set<M::iTOW>(epoch_time_.iTOW_);
+  f.set<M::xAngRate>(std::lround(m.gyro_[0] * 1e3));
+  f.set<M::yAngRate>(std::lround(m.gyro_[1] * 1e3));
+  f.set<M::zAngRate>(std::lround(m.gyro_[2] * 1e3));
+  f.set<M::xAccel>(std::lround(m.accel_[0] * 1e2));
+  f.set<M::yAccel>(std::lround(m.accel_[1] * 1e2));
+  f.set<M::zAccel>(std::lround(m.accel_[2] * 1e2));
+  return f.finish();
+}
+
+void FakeGNSSSimulator::write(const uint8_t * data, std::size_t size)
+{
+  // Responses are UBX frames
+  if (!protocols_[linkPort(reply_link_)].out_ubx_) return;
+
+  std::vector<as::const_buffer> buffers(1, as::buffer(data, size));
+  write(buffers, reply_link_);
+}
+
+void FakeGNSSSimulator::write(
+  const std::vector<as::const_buffer> & buffers, Link link, TimerQueue::Clock::duration delay)
+{
+  bool b = state_.load().checksum_error_;
+
+  std::vector<uint8_t> corrupted;
+  std::vector<as::const_buffer> corrupted_buffers;
   if (b) {
-    frame[frame.size() - 1] = '?';
-    frame[frame.size() - 2] = '?';
+    // Corrupt a copy to keep the cached encodings. Only whole frames are corrupted, pieces cut
+    // or inserted by fault injection being sent as they are.
+    for (const auto & buffer : buffers) {
+      const uint8_t * data = static_cast<const uint8_t *>(buffer.data());
+      std::size_t size = buffer.size();
+      std::size_t start = corrupted.size();
+      corrupted.insert(corrupted.end(), data, data + size);
+      bool ubx = size >= FRAME_OVERHEAD && data[0] == 0xB5 && data[1] == 0x62 &&
+                 size == FRAME_OVERHEAD + (data[4] | (data[5] << 8));
+      bool nmea = size >= 6 && data[0] == '$' && data[size - 5] == '*' &&
+                  data[size - 2] == '\r' && data[size - 1] == '\n';
+      if (!ubx && !nmea) continue;
+
+      // Checksum of NMEA is followed by CR LF
+      std::size_t end = start + (nmea ? size - 2 : size);
+      corrupted[end - 1] = '?';
+      corrupted[end - 2] = '?';
+    }
+    std::size_t offset = 0;
+    for (const auto & buffer : buffers) {
+      corrupted_buffers.push_back(as::buffer(&corrupted[offset], buffer.size()));
+      offset += buffer.size();
+    }
   }
 
-  // asynchronously write data
-  port_->async_write_some(
-    as::buffer(frame), boost::bind(
-                         &FakeGNSSSimulator::onWrite, this, as::placeholders::error,
-                         as::placeholders::bytes_transferred, frame));
+  // Periodic transmission and responses are queued from different threads, and leave the
+  // transmit buffer at the baud rate
+  const std::vector<as::const_buffer> & frames = b ? corrupted_buffers : buffers;
+  TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+  Output & o = outputs_[link];
+  pthread_mutex_lock(&mutex_write_);
+  if (delay > TimerQueue::Clock::duration::zero()) o.uart_.stall(now + delay);
+  for (const auto & frame : frames) {
+    o.uart_.push(static_cast<const uint8_t *>(frame.data()), frame.size(), now);
+  }
+  if (!o.draining_ && o.uart_.pending()) {
+    o.draining_ = true;
+    io_.post(boost::bind(&FakeGNSSSimulator::drain, this, link));
+  }
+  pthread_mutex_unlock(&mutex_write_);
 }
 
-void FakeGNSSSimulator::calculateChecksum(
-  const uint8_t * data, int size, uint8_t & ck_a, uint8_t & ck_b)
+void FakeGNSSSimulator::drain(Link link)
 {
-  ck_a = 0;
-  ck_b = 0;
-  for (int i = 0; i < size; ++i) {
-    ck_a = ck_a + data[i];
-    ck_b = ck_b + ck_a;
+  Output & o = outputs_[link];
+  pthread_mutex_lock(&mutex_write_);
+
+  // Bytes due may wrap around the end of transmit buffer, and keep their space until written
+  o.chunk_.clear();
+  TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+  const uint8_t * data;
+  std::size_t n;
+  while (o.chunk_.size() < 2 && (n = o.uart_.pop(now, data)) > 0) {
+    o.chunk_.push_back(as::buffer(data, n));
+  }
+  if (o.chunk_.empty()) waitDrain(link);
+  pthread_mutex_unlock(&mutex_write_);
+
+  // A port whose reader stalls holds up only its own transmit buffer
+  if (!o.chunk_.empty()) {
+    as::async_write(
+      *o.port_, o.chunk_,
+      boost::bind(
+        &FakeGNSSSimulator::onDrainWrite, this, as::placeholders::error,
+        as::placeholders::bytes_transferred, link));
+  }
+}
+
+void FakeGNSSSimulator::onDrain(const boost::system::error_code & error, Link link)
+{
+  if (!error) drain(link);
+}
+
+void FakeGNSSSimulator::onDrainWrite(
+  const boost::system::error_code & error, std::size_t bytes_transfered, Link link)
+{
+  Output & o = outputs_[link];
+  onWrite(error, bytes_transfered, o.chunk_);
+
+  // Bytes not written on error are lost, and draining ends when the port is closed
+  pthread_mutex_lock(&mutex_write_);
+  o.uart_.release(as::buffer_size(o.chunk_));
+  o.chunk_.clear();
+  if (error == as::error::operation_aborted) {
+    o.draining_ = false;
+  } else {
+    waitDrain(link);
+  }
+  pthread_mutex_unlock(&mutex_write_);
+}
+
+void FakeGNSSSimulator::waitDrain(Link link)
+{
+  Output & o = outputs_[link];
+  if (o.uart_.pending()) {
+    TimerQueue::Clock::duration tick = o.uart_.duration(DRAIN_CHUNK);
+    o.drain_timer_.expires_after(std::max<TimerQueue::Clock::duration>(tick, MIN_DRAIN_TICK));
+    o.drain_timer_.async_wait(
+      boost::bind(&FakeGNSSSimulator::onDrain, this, as::placeholders::error, link));
+  } else {
+    o.draining_ = false;
   }
 }
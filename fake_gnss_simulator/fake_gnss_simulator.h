@@ -6,11 +6,28 @@
  * @brief Fake IMU simulator class
  */
 
+#include <cfg_db.h>
 #include <defines.h>
+#include <fault_injector.h>
+#include <gnss_clock.h>
+#include <imu_model.h>
+#include <interference.h>
 #include <linux/limits.h>
+#include <nav_solution.h>
+#include <nmea.h>
+#include <obstruction.h>
+#include <raw_model.h>
+#include <rtcm3_parser.h>
+#include <rtk_state.h>
+#include <seqlock.h>
+#include <timer_queue.h>
+#include <trajectory.h>
+#include <ubx_log.h>
+#include <ubx_messages.h>
+#include <uart_model.h>
+#include <ubx_parser.h>
 #include <boost/asio.hpp>
 #include <boost/filesystem.hpp>
-#include <map>
 #include <string>
 #include <vector>
 
@@ -26,13 +43,11 @@ struct UBX_ID
 
   UBX_ID(uint8_t classId, uint8_t messageId) : classId_(classId), messageId_(messageId) {}
 
-  bool operator<(const UBX_ID & value) const
-  {
-    if (classId_ == value.classId_) {
-      return messageId_ < value.messageId_;
-    }
-    return classId_ < value.classId_;
-  }
+  /**
+   * @brief Get index into dispatch table
+   * @return (class << 8) | id
+   */
+  uint16_t key(void) const { return (classId_ << 8) | messageId_; }
 };
 
 namespace as = boost::asio;
@@ -43,6 +58,12 @@ class FakeGNSSSimulator
 public:
   static FakeGNSSSimulator * get();
 
+  /**
+   * @brief Set path of ini file to use instead of the default one
+   * @param [in] ini_file path of ini file
+   */
+  void setIniFile(const char * ini_file);
+
   /**
    * @brief Load data from ini file
    */
@@ -66,6 +87,162 @@ public:
    */
   const char * getDeviceName(void) const;
 
+  /**
+   * @brief Set device name of UART2
+   * @param [in] uart2_device_name device name, empty to leave UART2 closed
+   */
+  void setUart2DeviceName(const char * uart2_device_name);
+
+  /**
+   * @brief Get device name of UART2
+   * @return device name of UART2
+   */
+  const char * getUart2DeviceName(void) const;
+
+  /**
+   * @brief Set device name of USB
+   * @param [in] usb_device_name device name, empty to leave USB closed
+   */
+  void setUsbDeviceName(const char * usb_device_name);
+
+  /**
+   * @brief Get device name of USB
+   * @return device name of USB
+   */
+  const char * getUsbDeviceName(void) const;
+
+  /**
+   * @brief Set path of UBX log file to replay
+   * @param [in] log_file path of log file, empty to transmit generated messages only
+   */
+  void setLogFile(const char * log_file);
+
+  /**
+   * @brief Get path of UBX log file
+   * @return path of log file
+   */
+  const char * getLogFile(void) const;
+
+  /**
+   * @brief Set path of trajectory file
+   * @param [in] trajectory_file path of CSV file, empty to stay at a fixed position
+   */
+  void setTrajectoryFile(const char * trajectory_file);
+
+  /**
+   * @brief Get path of trajectory file
+   * @return path of trajectory file
+   */
+  const char * getTrajectoryFile(void) const;
+
+  /**
+   * @brief Set UTC time at start
+   * @param [in] start_time "YYYY-MM-DDThh:mm:ss", empty to start at the current time
+   */
+  void setStartTime(const char * start_time);
+
+  /**
+   * @brief Get UTC time at start
+   * @return UTC time at start
+   */
+  const char * getStartTime(void) const;
+
+  /**
+   * @brief Set speed of simulated time
+   * @param [in] time_scale speed relative to real time
+   */
+  void setTimeScale(double time_scale);
+
+  /**
+   * @brief Get speed of simulated time
+   * @return speed relative to real time
+   */
+  double getTimeScale(void) const;
+
+  /**
+   * @brief Set path of almanac file
+   * @param [in] almanac_file path of CSV file, empty for nominal constellations
+   */
+  void setAlmanacFile(const char * almanac_file);
+
+  /**
+   * @brief Get path of almanac file
+   * @return path of almanac file
+   */
+  const char * getAlmanacFile(void) const;
+
+  /**
+   * @brief Set path of obstruction file
+   * @param [in] obstruction_file path of CSV file, empty for open sky
+   */
+  void setObstructionFile(const char * obstruction_file);
+
+  /**
+   * @brief Get path of obstruction file
+   * @return path of obstruction file
+   */
+  const char * getObstructionFile(void) const;
+
+  /**
+   * @brief Set path of interference file
+   * @param [in] interference_file path of CSV file, empty for states set by hand
+   */
+  void setInterferenceFile(const char * interference_file);
+
+  /**
+   * @brief Get path of interference file
+   * @return path of interference file
+   */
+  const char * getInterferenceFile(void) const;
+
+  /**
+   * @brief Set rate of sensor samples in UBX-ESF-MEAS
+   * @param [in] sensor_rate rate [Hz], up to 100
+   */
+  void setSensorRate(int sensor_rate);
+
+  /**
+   * @brief Get rate of sensor samples in UBX-ESF-MEAS
+   * @return rate [Hz]
+   */
+  int getSensorRate(void) const;
+
+  /**
+   * @brief Set path of fault file
+   * @param [in] fault_file path of CSV file of fault probabilities, empty to keep those set
+   */
+  void setFaultFile(const char * fault_file);
+
+  /**
+   * @brief Get path of fault file
+   * @return path of fault file
+   */
+  const char * getFaultFile(void) const;
+
+  /**
+   * @brief Set seed of faults, which restart on every run
+   * @param [in] fault_seed seed
+   */
+  void setFaultSeed(unsigned int fault_seed);
+
+  /**
+   * @brief Get seed of faults
+   * @return seed
+   */
+  unsigned int getFaultSeed(void) const;
+
+  /**
+   * @brief Set device name of rover
+   * @param [in] rover_device_name device name, empty to simulate a single receiver
+   */
+  void setRoverDeviceName(const char * rover_device_name);
+
+  /**
+   * @brief Get device name of rover
+   * @return device name of rover
+   */
+  const char * getRoverDeviceName(void) const;
+
   /**
    * @brief Start serial port communication
    * @return 0 on success, otherwise error
@@ -89,6 +266,22 @@ public:
    */
   void setDebugOutput(int is_debug);
 
+  /**
+   * @brief Set probability of fault per output frame, also while running
+   * @param [in] message_class message class, 0xF0 for NMEA, -1 for every class
+   * @param [in] fault fault
+   * @param [in] probability probability from 0 to 1
+   */
+  void setFaultRate(int message_class, FaultType fault, double probability);
+
+  /**
+   * @brief Get probability of fault per output frame
+   * @param [in] message_class message class, 0xF0 for NMEA
+   * @param [in] fault fault
+   * @return probability
+   */
+  double getFaultRate(int message_class, FaultType fault);
+
   // UBX-MON-HW
   /**
    * @brief Set aStatus
@@ -168,17 +361,108 @@ private:
   };
 
   typedef void (FakeGNSSSimulator::*HANDLE_FUNC)(const uint8_t * data);  //!< @brief message handler
-  typedef void (FakeGNSSSimulator::*TRANSMIT_FUNC)();  //!< @brief transmit function
+  typedef std::size_t (FakeGNSSSimulator::*ENCODE_FUNC)(
+    uint8_t * buf, bool update);  //!< @brief encoder
+
+  static constexpr std::size_t FRAME_OVERHEAD = 8;  //!< @brief header and checksum of UBX frame
+  static constexpr uint16_t EPOCH_TIMER = 0x0000;   //!< @brief timer key of navigation epoch
+  static constexpr uint16_t SENSOR_TIMER = 0x0001;  //!< @brief timer key of sensor batches
+  static constexpr int PORTS = PORT_ID_SPI + 1;     //!< @brief number of port IDs
 
   /**
-   * @brief Periodic transmission
+   * @brief Serial port written to, ports of moving base in the order of their port IDs
+   */
+  enum Link {
+    LINK_UART1 = 0,  //!< @brief UART1 of moving base, or of the only receiver
+    LINK_UART2,      //!< @brief UART2 of moving base
+    LINK_USB,        //!< @brief USB of moving base
+    LINK_ROVER,      //!< @brief rover reporting position relative to moving base
+    LINKS,           //!< @brief number of links
+  };
+  static constexpr int BASE_LINKS = LINK_ROVER;  //!< @brief number of links of moving base
+
+  /**
+   * @brief Protocols enabled on port by CFG-*INPROT/OUTPROT
+   */
+  struct Protocols
+  {
+    bool in_ubx_;    //!< @brief UBX input enabled
+    bool in_rtcm3_;  //!< @brief RTCM3 input enabled
+    bool out_ubx_;   //!< @brief UBX output enabled
+    bool out_nmea_;  //!< @brief NMEA output enabled
+  };
+
+  /**
+   * @brief Receiving side of port of moving base, used only by the io thread
+   */
+  struct Input
+  {
+    uint8_t read_buf_[1024];    //!< @brief buffer for asynchronous read
+    UbxParser parser_;          //!< @brief parser of received data
+    Rtcm3Parser rtcm3_parser_;  //!< @brief parser of received corrections
+    uint32_t crc_failures_;     //!< @brief RTCM3 frames rejected, reported so far
+  };
+
+  /**
+   * @brief Serial port of receiver with its transmit buffer, protected by mutex_write_
+   */
+  struct Output
+  {
+    /**
+     * @brief Constructor
+     * @param[in] io io service running the drain timer
+     * @param[in] size size of transmit buffer, power of two
+     */
+    explicit Output(as::io_service & io, std::size_t size = UartModel::TX_BUFFER_SIZE)
+    : uart_(size), drain_timer_(io), draining_(false)
+    {
+    }
+
+    boost::shared_ptr<as::serial_port> port_;  //!< @brief serial port, null if not opened
+    UartModel uart_;                           //!< @brief transmit buffer draining at baud rate
+    as::steady_timer drain_timer_;             //!< @brief timer to write the next chunk
+    bool draining_;                            //!< @brief drain is posted, writing or waiting
+    std::vector<as::const_buffer> chunk_;      //!< @brief bytes being written, reserved in uart_
+  };
+
+  /**
+   * @brief Receiver state tunable from GUI or scripts, published as a whole
    */
   typedef struct
   {
-    TRANSMIT_FUNC func_;
-    int rate_;
-    int cnt_;
-  } PERIODIC_TRANSMIT;
+    AStatus aStatus_;                         //!< @brief antenna supervisor state
+    JammingState jammingState_;               //!< @brief output from Jamming/Interference Monitor
+    SpoofDetState spoofDetState_;             //!< @brief Spoofing detection state
+    PortBlock port_blocks_[PORTS];            //!< @brief Port blocks by port ID
+    bool checksum_error_;                     //!< @brief flag to generate checksum error or not
+    bool dump_;                               //!< @brief flag to show debug output or not
+  } STATE;
+
+  /**
+   * @brief Message supported by simulator
+   */
+  typedef struct
+  {
+    UBX_ID id_;            //!< @brief message class and id
+    HANDLE_FUNC handle_;   //!< @brief handler of received message, nullptr if not handled
+    ENCODE_FUNC encode_;   //!< @brief encoder of periodic message, nullptr if not periodic
+    uint16_t max_length_;  //!< @brief largest payload or NMEA sentences produced by encoder
+    uint32_t cfg_key_;     //!< @brief CFG-MSGOUT key of I2C port, 0 if not configurable
+  } UBX_MESSAGE;
+
+  /**
+   * @brief Entry of dispatch table
+   */
+  typedef struct
+  {
+    HANDLE_FUNC handle_;          //!< @brief handler of received message
+    ENCODE_FUNC encode_;          //!< @brief encoder of periodic message
+    uint32_t cfg_key_;            //!< @brief CFG-MSGOUT key of I2C port, 0 if not configurable
+    int rates_[PORTS];            //!< @brief epochs between transmissions by port, 0 if disabled
+    std::vector<uint8_t> frame_;  //!< @brief frame buffer sized for the largest encoding
+    std::size_t size_;            //!< @brief size of the last encoded frame
+    uint32_t epoch_;              //!< @brief encoded_epoch_ of the last encoding
+  } MESSAGE_ENTRY;
 
   /**
    * @brief Constructor
@@ -201,9 +485,90 @@ private:
   void * thread(void);
 
   /**
-   * @brief Handle periodic transmission
+   * @brief Close all ports, aborting their pending reads and writes, on the io thread when it runs
+   */
+  void closePorts(void);
+
+  /**
+   * @brief Encode messages due in the current navigation epoch and send them at once
+   */
+  void handleEpoch(void);
+
+  /**
+   * @brief Encode sensor samples taken since the previous batch, and send them if due in the
+   * current navigation epoch
    */
-  void handlePeriodicTransmit(void);
+  void handleSensors(void);
+
+  /**
+   * @brief Queue frames of encoded message to buffers_ of links, mutex_frame_ must be held
+   * @param[in] m encoded message
+   * @param[in] links bits of links the message is due on
+   */
+  void queueFrames(const MESSAGE_ENTRY & m, uint8_t links);
+
+  /**
+   * @brief Inject faults into buffers_ and send them, mutex_frame_ must be held
+   * @param[in] period interval of the frames, the longest delay of faults
+   */
+  void sendFrames(TimerQueue::Clock::duration period);
+
+  /**
+   * @brief Transmit enabled messages recorded in the current epoch of log, and advance epoch
+   */
+  void handleReplay(void);
+
+  /**
+   * @brief Schedule epoch clock at the period of measRate * navRate, and sensor batches within it
+   */
+  void scheduleEpoch(void);
+
+  /**
+   * @brief Set rate of message on port, mutex_stop_ must be held
+   * @param[in] key (class << 8) | id
+   * @param[in] port port ID
+   * @param[in] rate number of epochs between transmissions, 0 to disable
+   */
+  void setRate(uint16_t key, uint32_t port, int rate);
+
+  /**
+   * @brief Get links of moving base on which message is due, mutex_stop_ must be held
+   * @param[in] key (class << 8) | id
+   * @param[in] count number of the epoch
+   * @return bit mask of links, 0 if due on none
+   */
+  uint8_t dueLinks(uint16_t key, uint32_t count) const;
+
+  /**
+   * @brief Get port ID of link of moving base
+   * @param[in] link link of moving base
+   * @return port ID
+   */
+  static PortId linkPort(int link) { return static_cast<PortId>(PORT_ID_UART1 + link); }
+
+  /**
+   * @brief Apply configuration in RAM to message rates, navigation rate and protocols
+   */
+  void applyConfig(void);
+
+  /**
+   * @brief Finish changes to configuration of UBX-CFG-VALSET or UBX-CFG-VALDEL
+   * @param[in] ok all items of message are valid
+   * @param[in] transaction 0 none, 1 begin, 2 continue, 3 end
+   */
+  void endTransaction(bool ok, uint8_t transaction);
+
+  /**
+   * @brief Find entry of dispatch table
+   * @param[in] message_class message class
+   * @param[in] message_id message id
+   * @return entry, nullptr if the message is not supported
+   */
+  MESSAGE_ENTRY * findMessage(uint8_t message_class, uint8_t message_id)
+  {
+    uint8_t i = index_[(message_class << 8) | message_id];
+    return (i > 0) ? &messages_[i - 1] : nullptr;
+  }
 
   /**
    * @brief Dump sent/received Data
@@ -217,20 +582,53 @@ private:
    * @brief Handler to be called when the read operation completes
    * @param[in] error error argument of a handler
    * @param[in] bytes_transfered bytes transferred argument of a handler
-   * @param[inout] data received data
+   * @param[in] link link of moving base which received data
    */
-  void onRead(
-    const boost::system::error_code & error, std::size_t bytes_transfered, const uint8_t * data);
+  void onRead(const boost::system::error_code & error, std::size_t bytes_transfered, Link link);
+
+  /**
+   * @brief Start asynchronous read on port of moving base
+   * @param[in] link link of moving base
+   */
+  void read(Link link);
 
   /**
    * @brief Handler to be called when the write operation completes
    * @param[in] error error argument of a handler
    * @param[in] bytes_transfered bytes transferred argument of a handler
-   * @param[inout] data sent data
+   * @param[in] buffers sent data
    */
   void onWrite(
     const boost::system::error_code & error, std::size_t bytes_transfered,
-    const std::vector<uint8_t> & data);
+    const std::vector<as::const_buffer> & buffers);
+
+  /**
+   * @brief Write bytes which have left transmit buffer by now, and wait for more while any remain
+   * @param[in] link link whose transmit buffer to drain
+   */
+  void drain(Link link);
+
+  /**
+   * @brief Handler to be called when drain timer expires
+   * @param[in] error error argument of a handler
+   * @param[in] link link whose transmit buffer to drain
+   */
+  void onDrain(const boost::system::error_code & error, Link link);
+
+  /**
+   * @brief Handler to be called when bytes taken by drain() are written to port
+   * @param[in] error error argument of a handler
+   * @param[in] bytes_transfered bytes transferred argument of a handler
+   * @param[in] link link whose transmit buffer is drained
+   */
+  void onDrainWrite(
+    const boost::system::error_code & error, std::size_t bytes_transfered, Link link);
+
+  /**
+   * @brief Wait for more bytes to leave transmit buffer while any remain, with mutex_write_ held
+   * @param[in] link link whose transmit buffer is drained
+   */
+  void waitDrain(Link link);
 
   /**
    * @brief Handle UBX data
@@ -238,6 +636,18 @@ private:
    */
   void handleUbx(const uint8_t * data);
 
+  /**
+   * @brief Answer poll of periodic message with its frame of the current epoch
+   * @param[inout] m entry of message
+   */
+  void handleUbxPoll(MESSAGE_ENTRY & m);
+
+  /**
+   * @brief Handle RTCM3 frame of corrections
+   * @param[in] frame received frame with valid CRC
+   */
+  void handleRtcm3(const uint8_t * frame);
+
   /**
    * @brief Handle UBX-MON-VER
    * @param[in] data received data
@@ -256,6 +666,36 @@ private:
    */
   void handleUbxCfgMSG(const uint8_t * data);
 
+  /**
+   * @brief Handle UBX-CFG-RST
+   * @param[in] data received data
+   */
+  void handleUbxCfgRST(const uint8_t * data);
+
+  /**
+   * @brief Handle UBX-CFG-RATE
+   * @param[in] data received data
+   */
+  void handleUbxCfgRATE(const uint8_t * data);
+
+  /**
+   * @brief Handle UBX-CFG-VALSET
+   * @param[in] data received data
+   */
+  void handleUbxCfgVALSET(const uint8_t * data);
+
+  /**
+   * @brief Handle UBX-CFG-VALGET
+   * @param[in] data received data
+   */
+  void handleUbxCfgVALGET(const uint8_t * data);
+
+  /**
+   * @brief Handle UBX-CFG-VALDEL
+   * @param[in] data received data
+   */
+  void handleUbxCfgVALDEL(const uint8_t * data);
+
   /**
    * @brief Send UBX-ACK-ACK
    * @param[in] ack true on UBX-ACK-ACK, false on UBX-ACK-NAK
@@ -265,73 +705,309 @@ private:
   void sendUbxAck(bool ack, uint8_t message_class, uint8_t message_id);
 
   /**
-   * @brief Send UBX-NAV-STATUS
+   * @brief Send UBX-RXM-RTCM if enabled
+   * @param[in] flags flags, crcFailed and msgUsed
+   * @param[in] station reference station ID
+   * @param[in] type message type
+   */
+  void sendUbxRxmRTCM(uint8_t flags, uint16_t station, uint16_t type);
+
+  /**
+   * @brief Get current navigation solution
+   * @param[out] s navigation solution
+   */
+  void getNavSolution(NavSolution & s);
+
+  /**
+   * @brief Encode NMEA sentences of a type
+   * @tparam F format function
+   * @param[out] buf frame buffer
+   * @param[in] update unused, sentences are always formatted from scratch
+   * @return number of characters
+   */
+  template <NMEA_FUNC F>
+  std::size_t encodeNmea(uint8_t * buf, bool update)
+  {
+    NavSolution s;
+    getNavSolution(s);
+    return F(s, reinterpret_cast<char *>(buf));
+  }
+
+  /**
+   * @brief Encode UBX-NAV-STATUS
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @return size of frame
+   */
+  std::size_t encodeUbxNavSTATUS(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-NAV-PVT
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @return size of frame
+   */
+  std::size_t encodeUbxNavPVT(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-NAV-PVT of navigation solution
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @param[in] s navigation solution
+   * @return size of frame
+   */
+  std::size_t encodeUbxNavPVT(uint8_t * buf, bool update, const NavSolution & s);
+
+  /**
+   * @brief Get rover antenna relative to moving base antenna
+   * @param[in] s navigation solution of moving base, whose motion gives vehicle heading
+   * @param[out] ned north, east and down [m]
+   */
+  void getBaseline(const NavSolution & s, double ned[3]) const;
+
+  /**
+   * @brief Get navigation solution of rover, moving base being at s
+   * @param[inout] s navigation solution
+   */
+  void getRoverSolution(NavSolution & s) const;
+
+  /**
+   * @brief Encode UBX-NAV-SAT of satellites above horizon
+   * @param[out] buf frame buffer
+   * @param[in] update unused, satellites are always encoded from scratch
+   * @return size of frame
    */
-  void sendUbxNavSTATUS(void);
+  std::size_t encodeUbxNavSAT(uint8_t * buf, bool update);
 
   /**
-   * @brief Send UBX-NAV-PVT
+   * @brief Encode UBX-NAV-SIG of L1 signals of satellites above horizon
+   * @param[out] buf frame buffer
+   * @param[in] update unused, signals are always encoded from scratch
+   * @return size of frame
    */
-  void sendUbxNavPVT(void);
+  std::size_t encodeUbxNavSIG(uint8_t * buf, bool update);
 
   /**
-   * @brief Send UBX-NAV-RELPOSNED
+   * @brief Encode UBX-NAV-RELPOSNED
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @return size of frame
    */
-  void sendUbxNavRELPOSNED(void);
+  std::size_t encodeUbxNavRELPOSNED(uint8_t * buf, bool update);
 
   /**
-   * @brief Send UBX-MON-HW
+   * @brief Encode UBX-NAV-RELPOSNED of navigation solution
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @param[in] s navigation solution
+   * @param[in] solution carrier phase solution of baseline
+   * @param[in] station reference station ID
+   * @return size of frame
    */
-  void sendUbxMonHW(void);
+  std::size_t encodeUbxNavRELPOSNED(
+    uint8_t * buf, bool update, const NavSolution & s, RtkState::Solution solution,
+    uint16_t station);
 
   /**
-   * @brief Send UBX-MON-COMMS
+   * @brief Get GPS time of the current navigation epoch
+   * @return seconds since 1980-01-06
    */
-  void sendUbxMonCOMMS(void);
+  uint64_t epochSeconds(void) const;
 
   /**
-   * @brief Send cdata
-   * @param data start of range
-   * @param size size of range
+   * @brief Get time of scripted obstructions and interference in the current navigation epoch
+   * @return time since the start of simulation, or of the trajectory repeating [s]
    */
-  void send(uint8_t * data, int size);
+  double scriptTime(void) const;
 
   /**
-   * @brief Calculate checksum
-   * @param data start of range
-   * @param size size of range
-   * @param ck_a checksum a
-   * @param ck_b checksum b
+   * @brief Compute geometry of satellites once per navigation epoch, behind obstructions and
+   *        under interference
+   * @param[in] s navigation solution giving the position of receiver
    */
-  void calculateChecksum(const uint8_t * data, int size, uint8_t & ck_a, uint8_t & ck_b);
+  void updateSky(const NavSolution & s);
+
+  /**
+   * @brief Encode UBX-RXM-RAWX
+   * @param[out] buf frame buffer
+   * @param[in] update unused, measurements are always encoded from scratch
+   * @return size of frame
+   */
+  std::size_t encodeUbxRxmRAWX(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-RXM-SFRBX of GPS satellites in view when a subframe is complete
+   * @param[out] buf frame buffer
+   * @param[in] update unused, subframes are always encoded from scratch
+   * @return size of frames, 0 if no subframe is complete
+   */
+  std::size_t encodeUbxRxmSFRBX(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-MON-HW
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @return size of frame
+   */
+  std::size_t encodeUbxMonHW(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-MON-COMMS
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @return size of frame
+   */
+  std::size_t encodeUbxMonCOMMS(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-ESF-MEAS of each sensor sample since the previous encoding
+   * @param[out] buf frame buffer
+   * @param[in] update unused, samples are always encoded from scratch
+   * @return size of frames, 0 if no sample was taken
+   */
+  std::size_t encodeUbxEsfMEAS(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-ESF-STATUS
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @return size of frame
+   */
+  std::size_t encodeUbxEsfSTATUS(uint8_t * buf, bool update);
+
+  /**
+   * @brief Encode UBX-ESF-INS
+   * @param[inout] buf frame buffer
+   * @param[in] update buf holds the previous encoding, which is patched in place
+   * @return size of frame
+   */
+  std::size_t encodeUbxEsfINS(uint8_t * buf, bool update);
+
+  /**
+   * @brief Queue response to transmit buffer of the port the message being handled came from
+   * @param[in] data start of frame
+   * @param[in] size size of frame
+   */
+  void write(const uint8_t * data, std::size_t size);
+
+  /**
+   * @brief Queue frames to transmit buffer, dropping ones which do not fit
+   * @param[in] buffers frames
+   * @param[in] link link sending frames
+   * @param[in] delay time for which the line stays silent before the frames
+   */
+  void write(
+    const std::vector<as::const_buffer> & buffers, Link link,
+    TimerQueue::Clock::duration delay = TimerQueue::Clock::duration::zero());
 
   static FakeGNSSSimulator * gnss_;          //!< @brief reference to itself
   std::string ini_path_;                     //!< @brief path to ini file
   as::io_service io_;                        //!< @brief facilities of custom asynchronous services
-  boost::shared_ptr<as::serial_port> port_;  //!< @brief wrapper over serial port functionality
-  pthread_mutex_t mutex_stop_;               //!< @brief mutex to protect access to stop_thread
-  pthread_mutex_t mutex_send_;  //!< @brief mutex to protect access to data regarding send data
-  pthread_mutex_t mutex_dump_;  //!< @brief mutex to protect access to dump flag
-  pthread_t th_;                //!< @brief thread handle
-  static std::map<UBX_ID, HANDLE_FUNC> handle_map_;          //!< @brief message handler map
-  static std::map<UBX_ID, PERIODIC_TRANSMIT> periodic_map_;  //!< @brief Periodic transmission map
+  pthread_mutex_t mutex_stop_;   //!< @brief mutex to protect access to stop_thread and timers
+  pthread_cond_t cond_timer_;    //!< @brief condition to wake up thread on stop or timer change
+  pthread_mutex_t mutex_send_;   //!< @brief mutex to serialize updates of state
+  pthread_mutex_t mutex_write_;  //!< @brief mutex to serialize writes to serial port
+  pthread_mutex_t mutex_frame_;  //!< @brief mutex to protect encoding into frames of messages_
+  pthread_t th_;                 //!< @brief thread handle
+  static const UBX_MESSAGE message_list_[];  //!< @brief supported messages
+  std::vector<MESSAGE_ENTRY> messages_;      //!< @brief dispatch table
+  uint8_t index_[0x10000];                   //!< @brief position in dispatch table + 1 by key
+  std::vector<uint16_t> enabled_;            //!< @brief keys of periodic messages enabled
+  TimerQueue timers_;                        //!< @brief deadlines of periodic transmission
+  std::vector<uint16_t> due_;                //!< @brief keys of messages due in epoch
+  std::vector<uint8_t> due_links_;           //!< @brief links each message of due_ is sent on
+  uint32_t encoded_epoch_;                   //!< @brief epochs encoded, protected by mutex_frame_
+
+  std::vector<as::const_buffer> buffers_[BASE_LINKS];  //!< @brief frames to send in epoch by link
+
+  // UBX-CFG-RATE
+  uint16_t meas_rate_;    //!< @brief measurement rate [ms]
+  uint16_t nav_rate_;     //!< @brief navigation rate [cycles]
+  uint16_t time_ref_;     //!< @brief time system to which measurements are aligned
+  uint32_t epoch_count_;  //!< @brief number of epochs since started
+
+  // Configuration
+  CfgDb cfg_;                             //!< @brief configuration database
+  Protocols protocols_[PORTS];            //!< @brief protocols enabled by port ID
+  std::vector<CfgDb::Value> cfg_values_;  //!< @brief values selected by UBX-CFG-VALGET
 
   // General
-  char device_name_[PATH_MAX];  //!< @brief Device name
-  bool stop_thread_;            //!< @brief flag to stop thread
-  bool checksum_error_;         //!< @brief flag to generate checksum error occur or not
-  bool dump_;                   //!< @brief flag to show debug output or not
-
-  // UBX-MON-HW
-  AStatus aStatus_;            //!< @brief Status of the antenna supervisor state machine
-  JammingState jammingState_;  //!< @brief output from Jamming/Interference Monitor
-
-  // UBX-MON-COMMS
-  PortId portId_;                                //!< @brief current portId
-  static std::map<int, PortBlock> port_blocks_;  //!< @brief Port blocks
-
-  // UBX-NAV-STATUS
-  SpoofDetState spoofDetState_;  //!< @brief Spoofing detection state
+  char device_name_[PATH_MAX];        //!< @brief Device name
+  char uart2_device_name_[PATH_MAX];  //!< @brief device name of UART2, empty if closed
+  char usb_device_name_[PATH_MAX];    //!< @brief device name of USB, empty if closed
+  char log_file_[PATH_MAX];           //!< @brief UBX log file
+  bool stop_thread_;                  //!< @brief flag to stop thread
+  Input inputs_[BASE_LINKS];          //!< @brief receiving side of ports by link
+  Link reply_link_;                   //!< @brief link of the message being handled
+
+  // Time
+  char start_time_[32];         //!< @brief UTC time at start, empty for the current time
+  double time_scale_;           //!< @brief speed of simulated time relative to real time
+  GnssClock clock_;             //!< @brief simulated GPS time
+  GnssClock::Time epoch_time_;  //!< @brief time of the current epoch, protected by mutex_frame_
+
+  // Trajectory
+  char trajectory_file_[PATH_MAX];  //!< @brief trajectory file
+  Trajectory trajectory_;           //!< @brief track to follow
+
+  // Sensor fusion
+  int sensor_rate_;     //!< @brief rate of sensor samples [Hz]
+  ImuModel imu_model_;  //!< @brief sensors of vehicle following the trajectory
+  ImuModel::Imu imu_;   //!< @brief samples since the previous UBX-ESF-MEAS
+  double sensor_time_;  //!< @brief simulated time of sensor batch [s], protected by mutex_frame_
+  bool fusion_;         //!< @brief sensor fusion is initialized, by the first fix
+
+  // Satellites and raw measurements
+  char almanac_file_[PATH_MAX];      //!< @brief almanac file, empty for nominal constellations
+  char obstruction_file_[PATH_MAX];  //!< @brief obstruction file, empty for open sky
+  Constellation constellation_;      //!< @brief satellites
+  Obstruction obstruction_;          //!< @brief sectors of sky obstructed
+  Constellation::Sky sky_;           //!< @brief geometry of satellites in the current epoch
+  double sky_time_;                  //!< @brief GPS time of sky_ [s], negative if not computed
+  RawModel raw_model_;               //!< @brief receiver clock and measurement noise
+  RawModel::Raw raw_;                //!< @brief measurements in the current epoch
+  uint64_t subframe_;                //!< @brief number of the last GPS subframe sent
+
+  // Moving base and rover
+  char rover_device_name_[PATH_MAX];             //!< @brief device name of rover, empty if none
+  double lever_arm_[3];                          //!< @brief rover from base: forward, right, down
+  std::vector<uint8_t> rover_pvt_;               //!< @brief frame of UBX-NAV-PVT of rover
+  std::vector<uint8_t> rover_relposned_;         //!< @brief frame of UBX-NAV-RELPOSNED of rover
+  bool rover_encoded_;                           //!< @brief rover frames hold an encoding
+  std::vector<as::const_buffer> rover_buffers_;  //!< @brief frames of rover to send in epoch
+
+  // RTK corrections
+  double rtk_float_time_;            //!< @brief time to float solution [s]
+  double rtk_fix_time_;              //!< @brief time to fixed solution [s]
+  double correction_timeout_;        //!< @brief age at which corrections are lost [s]
+  RtkState rtk_;                     //!< @brief corrections received, protected by mutex_stop_
+  RtkState::Solution rtk_solution_;  //!< @brief solution in the current epoch
+  double correction_age_;            //!< @brief age of corrections in the current epoch [s]
+  uint16_t reference_station_;       //!< @brief station of corrections in the current epoch
+
+  // Jamming and spoofing
+  char interference_file_[PATH_MAX];  //!< @brief interference file, empty for states set by hand
+  Interference interference_;         //!< @brief scripted states, indicators and C/N0 loss
+
+  // Fault injection
+  char fault_file_[PATH_MAX];  //!< @brief fault file, empty to keep probabilities set
+  unsigned int fault_seed_;    //!< @brief seed of faults
+  FaultInjector faults_;       //!< @brief faults of output, protected by mutex_stop_
+
+  // Log replay
+  UbxLog log_;                                     //!< @brief log to replay
+  std::size_t replay_epoch_;                       //!< @brief index of the next epoch to replay
+  uint32_t replay_count_;                          //!< @brief number of epochs replayed
+  TimerQueue::Clock::time_point replay_deadline_;  //!< @brief deadline of the next epoch
+
+  std::vector<as::const_buffer> replay_buffers_[BASE_LINKS];  //!< @brief frames to send by link
+
+  // Transmit buffers
+  Output outputs_[LINKS];  //!< @brief serial ports by link
+
+  // State read by transmission without locks, see STATE
+  PortId portId_;         //!< @brief port selected in GUI
+  SeqLock<STATE> state_;  //!< @brief tunable receiver state
 };
 
 #endif  // FAKE_GNSS_SIMULATOR_FAKE_GNSS_SIMULATOR_H_
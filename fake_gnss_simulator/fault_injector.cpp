@@ -0,0 +1,144 @@
+/**
+ * @file fault_injector.cpp
+ * @brief Seeded faults of output stream, applied to the buffers of encoded frames of an epoch
+ */
+
+#include <csv_reader.h>
+#include <fault_injector.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace as = boost::asio;
+
+static constexpr uint8_t NMEA_CLASS = 0xF0;  //!< @brief message class of NMEA sentences
+
+FaultInjector::FaultInjector()
+{
+  clear();
+  seed(1);
+
+  // Epochs hardly have more frames than this, so rearranging does not allocate
+  frames_.reserve(256);
+}
+
+int FaultInjector::load(const char * path)
+{
+  clear();
+
+  CsvReader csv;
+  int ret = csv.open(path);
+  if (ret != 0) return ret;
+
+  double v[1 + FAULT_TYPES];
+  int n;
+  while ((n = csv.next(v, 2, 1 + FAULT_TYPES)) > 0) {
+    if (v[0] < ALL_CLASSES || v[0] > 0xFF) {
+      csv.reject("invalid message class");
+      continue;
+    }
+    for (int k = 1; k < n; ++k) setRate(v[0], static_cast<FaultType>(k - 1), v[k]);
+  }
+  return 0;
+}
+
+void FaultInjector::clear(void)
+{
+  memset(rates_, 0, sizeof(rates_));
+  enabled_ = false;
+}
+
+void FaultInjector::seed(uint64_t seed)
+{
+  // xorshift never leaves zero state
+  state_ = seed ^ 0x9E3779B97F4A7C15ULL;
+  if (state_ == 0) state_ = 1;
+  for (auto & b : garbage_) b = next() >> 56;
+}
+
+void FaultInjector::setRate(int message_class, FaultType fault, double probability)
+{
+  if (fault < 0 || fault >= FAULT_TYPES) return;
+  uint64_t rate = std::llround(std::min(std::max(probability, 0.0), 1.0) * 4294967296.0);
+  if (message_class == ALL_CLASSES) {
+    for (auto & rates : rates_) rates[fault] = rate;
+  } else {
+    rates_[message_class & 0xFF][fault] = rate;
+  }
+
+  enabled_ = false;
+  for (const auto & rates : rates_) {
+    for (auto r : rates) enabled_ = enabled_ || r > 0;
+  }
+}
+
+double FaultInjector::getRate(uint8_t message_class, FaultType fault) const
+{
+  if (fault < 0 || fault >= FAULT_TYPES) return 0.0;
+  return rates_[message_class][fault] / 4294967296.0;
+}
+
+FaultInjector::Clock::duration FaultInjector::apply(
+  std::vector<as::const_buffer> & buffers, Clock::duration period)
+{
+  if (!enabled_) return Clock::duration::zero();
+
+  // Frames are rebuilt as pieces pointing into the cached encodings, headers_ and garbage_
+  frames_.clear();
+  std::size_t headers = 0;
+  bool delay = false;
+  for (const auto & buffer : buffers) {
+    const uint8_t * data = static_cast<const uint8_t *>(buffer.data());
+    std::size_t size = buffer.size();
+    bool nmea = data[0] == '$';
+    uint8_t message_class = nmea ? NMEA_CLASS : data[2];
+
+    if (draw(message_class, FAULT_GARBAGE)) {
+      std::size_t n = 1 + next() % MAX_GARBAGE;
+      frames_.push_back(as::buffer(&garbage_[next() % (GARBAGE_SIZE - n)], n));
+    }
+    delay = draw(message_class, FAULT_DELAY) || delay;
+    if (draw(message_class, FAULT_DROP)) continue;
+    if (draw(message_class, FAULT_TRUNCATE) && size > 1) size = 1 + next() % (size - 1);
+
+    // Frame is one piece, or a corrupted header followed by the rest
+    as::const_buffer pieces[2] = {as::buffer(data, size), as::const_buffer()};
+    std::size_t n = 1;
+    if (draw(message_class, FAULT_LENGTH) && !nmea && size > HEADER_SIZE && headers < MAX_HEADERS) {
+      uint8_t * header = headers_[headers++];
+      memcpy(header, data, HEADER_SIZE);
+      header[4] ^= 1 + next() % 0xFF;
+      header[5] ^= next() >> 56;
+      pieces[0] = as::buffer(header, HEADER_SIZE);
+      pieces[1] = as::buffer(data + HEADER_SIZE, size - HEADER_SIZE);
+      n = 2;
+    }
+
+    // Reordered frame is moved before one of those already queued
+    std::size_t at = frames_.size();
+    if (draw(message_class, FAULT_REORDER) && at > 0) at = next() % at;
+    frames_.insert(frames_.begin() + at, pieces, pieces + n);
+    if (draw(message_class, FAULT_DUPLICATE)) {
+      frames_.insert(frames_.begin() + at + n, pieces, pieces + n);
+    }
+  }
+  buffers.swap(frames_);
+
+  if (!delay) return Clock::duration::zero();
+  return period * static_cast<int64_t>(1 + next() % 1000) / 1000;
+}
+
+uint64_t FaultInjector::next(void)
+{
+  state_ ^= state_ >> 12;
+  state_ ^= state_ << 25;
+  state_ ^= state_ >> 27;
+  return state_ * 0x2545F4914F6CDD1DULL;
+}
+
+bool FaultInjector::draw(uint8_t message_class, FaultType fault)
+{
+  uint64_t rate = rates_[message_class][fault];
+  return rate > 0 && (next() >> 32) < rate;
+}
@@ -0,0 +1,102 @@
+#ifndef FAKE_GNSS_SIMULATOR_FAULT_INJECTOR_H_
+#define FAKE_GNSS_SIMULATOR_FAULT_INJECTOR_H_
+
+/**
+ * @file fault_injector.h
+ * @brief Seeded faults of output stream, applied to the buffers of encoded frames of an epoch
+ */
+
+#include <defines.h>
+#include <boost/asio/buffer.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class FaultInjector
+{
+public:
+  typedef std::chrono::steady_clock Clock;  //!< @brief monotonic clock
+
+  static constexpr int ALL_CLASSES = -1;  //!< @brief message class applying to every class
+
+  /**
+   * @brief Constructor
+   */
+  FaultInjector();
+
+  /**
+   * @brief Load probabilities from CSV file
+   * @param[in] path path of file with lines of message class, and probabilities of drop,
+   *                 duplicate, reorder, truncate, length, garbage and delay, -1 as class setting
+   *                 all classes
+   * @return 0 on success, otherwise error
+   * @note Rows are read by CsvReader::next(), which skips a header
+   */
+  int load(const char * path);
+
+  /**
+   * @brief Inject no fault
+   */
+  void clear(void);
+
+  /**
+   * @brief Restart sequence of faults
+   * @param[in] seed seed, same faults for the same seed and probabilities
+   */
+  void seed(uint64_t seed);
+
+  /**
+   * @brief Set probability of fault per frame
+   * @param[in] message_class message class, 0xF0 for NMEA, ALL_CLASSES for every class
+   * @param[in] fault fault
+   * @param[in] probability probability, clamped to 0 to 1
+   */
+  void setRate(int message_class, FaultType fault, double probability);
+
+  /**
+   * @brief Get probability of fault per frame
+   * @param[in] message_class message class, 0xF0 for NMEA
+   * @param[in] fault fault
+   * @return probability
+   */
+  double getRate(uint8_t message_class, FaultType fault) const;
+
+  /**
+   * @brief Apply faults to frames of an epoch
+   * @param[inout] buffers frames, rearranged in place and pointing into internal buffers for
+   *                       corrupted headers and garbage, valid until the next call
+   * @param[in] period navigation period, the longest delay
+   * @return time by which the epoch is delayed
+   */
+  Clock::duration apply(std::vector<boost::asio::const_buffer> & buffers, Clock::duration period);
+
+private:
+  static constexpr std::size_t HEADER_SIZE = 6;     //!< @brief UBX header up to length field
+  static constexpr std::size_t MAX_HEADERS = 64;    //!< @brief corrupted headers per epoch
+  static constexpr std::size_t GARBAGE_SIZE = 256;  //!< @brief pool of garbage bytes
+  static constexpr std::size_t MAX_GARBAGE = 32;    //!< @brief longest garbage between frames
+
+  /**
+   * @brief Get next random number, xorshift64*
+   * @return random number
+   */
+  uint64_t next(void);
+
+  /**
+   * @brief Draw fault
+   * @param[in] message_class message class
+   * @param[in] fault fault
+   * @return true if fault is injected
+   */
+  bool draw(uint8_t message_class, FaultType fault);
+
+  uint64_t rates_[256][FAULT_TYPES];               //!< @brief probabilities by class [2^-32]
+  bool enabled_;                                   //!< @brief some probability is not zero
+  uint64_t state_;                                 //!< @brief state of random numbers
+  uint8_t headers_[MAX_HEADERS][HEADER_SIZE];      //!< @brief headers with corrupted length
+  uint8_t garbage_[GARBAGE_SIZE];                  //!< @brief bytes inserted between frames
+  std::vector<boost::asio::const_buffer> frames_;  //!< @brief frames being rearranged
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_FAULT_INJECTOR_H_
@@ -0,0 +1,80 @@
+/**
+ * @file geodesy.cpp
+ * @brief WGS84 coordinate conversions over arrays
+ */
+
+#include <geodesy.h>
+#include <cmath>
+
+static constexpr double WGS84_A = 6378137.0;                      //!< @brief semi-major axis [m]
+static constexpr double WGS84_F = 1.0 / 298.257223563;            //!< @brief flattening
+static constexpr double WGS84_B = WGS84_A * (1.0 - WGS84_F);      //!< @brief semi-minor axis [m]
+static constexpr double WGS84_E2 = WGS84_F * (2.0 - WGS84_F);     //!< @brief first eccentricity^2
+static constexpr double WGS84_EP2 = WGS84_E2 / (1.0 - WGS84_E2);  //!< @brief second eccentricity^2
+
+void geodeticToEcef(
+  const double * lat, const double * lon, const double * h, std::size_t n, double * x, double * y,
+  double * z)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    double sin_lat = std::sin(lat[i]);
+    double cos_lat = std::cos(lat[i]);
+    double rn = WGS84_A / std::sqrt(1.0 - WGS84_E2 * sin_lat * sin_lat);
+    x[i] = (rn + h[i]) * cos_lat * std::cos(lon[i]);
+    y[i] = (rn + h[i]) * cos_lat * std::sin(lon[i]);
+    z[i] = (rn * (1.0 - WGS84_E2) + h[i]) * sin_lat;
+  }
+}
+
+void ecefToGeodetic(
+  const double * x, const double * y, const double * z, std::size_t n, double * lat, double * lon,
+  double * h)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    double p = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+    double theta = std::atan2(z[i] * WGS84_A, p * WGS84_B);
+    double sin_t = std::sin(theta);
+    double cos_t = std::cos(theta);
+    double phi = std::atan2(
+      z[i] + WGS84_EP2 * WGS84_B * sin_t * sin_t * sin_t,
+      p - WGS84_E2 * WGS84_A * cos_t * cos_t * cos_t);
+    double sin_phi = std::sin(phi);
+    double rn = WGS84_A / std::sqrt(1.0 - WGS84_E2 * sin_phi * sin_phi);
+
+    lat[i] = phi;
+    lon[i] = std::atan2(y[i], x[i]);
+    // Unlike p / cos(phi) - rn, this form of height stays accurate near the poles
+    h[i] = p * std::cos(phi) + z[i] * sin_phi - rn * (1.0 - WGS84_E2 * sin_phi * sin_phi);
+  }
+}
+
+void ecefToNed(
+  const double * lat, const double * lon, const double * x, const double * y, const double * z,
+  std::size_t n, double * north, double * east, double * down)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    double sin_lat = std::sin(lat[i]);
+    double cos_lat = std::cos(lat[i]);
+    double sin_lon = std::sin(lon[i]);
+    double cos_lon = std::cos(lon[i]);
+    north[i] = -sin_lat * cos_lon * x[i] - sin_lat * sin_lon * y[i] + cos_lat * z[i];
+    east[i] = -sin_lon * x[i] + cos_lon * y[i];
+    down[i] = -cos_lat * cos_lon * x[i] - cos_lat * sin_lon * y[i] - sin_lat * z[i];
+  }
+}
+
+void nedToEcef(
+  const double * lat, const double * lon, const double * north, const double * east,
+  const double * down, std::size_t n, double * x, double * y, double * z)
+{
+  // Transpose of the rotation in ecefToNed
+  for (std::size_t i = 0; i < n; ++i) {
+    double sin_lat = std::sin(lat[i]);
+    double cos_lat = std::cos(lat[i]);
+    double sin_lon = std::sin(lon[i]);
+    double cos_lon = std::cos(lon[i]);
+    x[i] = -sin_lat * cos_lon * north[i] - sin_lon * east[i] - cos_lat * cos_lon * down[i];
+    y[i] = -sin_lat * sin_lon * north[i] + cos_lon * east[i] - cos_lat * sin_lon * down[i];
+    z[i] = cos_lat * north[i] - sin_lat * down[i];
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef FAKE_GNSS_SIMULATOR_GEODESY_H_
+#define FAKE_GNSS_SIMULATOR_GEODESY_H_
+
+/**
+ * @file geodesy.h
+ * @brief WGS84 coordinate conversions over arrays
+ */
+
+#include <cstddef>
+
+/**
+ * @brief Convert geodetic coordinates to ECEF
+ * @param[in] lat latitude [rad]
+ * @param[in] lon longitude [rad]
+ * @param[in] h height above ellipsoid [m]
+ * @param[in] n number of elements
+ * @param[out] x ECEF x [m]
+ * @param[out] y ECEF y [m]
+ * @param[out] z ECEF z [m]
+ */
+void geodeticToEcef(
+  const double * lat, const double * lon, const double * h, std::size_t n, double * x, double * y,
+  double * z);
+
+/**
+ * @brief Convert ECEF coordinates to geodetic with Bowring's method
+ * @param[in] x ECEF x [m]
+ * @param[in] y ECEF y [m]
+ * @param[in] z ECEF z [m]
+ * @param[in] n number of elements
+ * @param[out] lat latitude [rad]
+ * @param[out] lon longitude [rad]
+ * @param[out] h height above ellipsoid [m]
+ */
+void ecefToGeodetic(
+  const double * x, const double * y, const double * z, std::size_t n, double * lat, double * lon,
+  double * h);
+
+/**
+ * @brief Rotate ECEF vectors into local NED frames
+ * @param[in] lat latitude of each frame [rad]
+ * @param[in] lon longitude of each frame [rad]
+ * @param[in] x ECEF x
+ * @param[in] y ECEF y
+ * @param[in] z ECEF z
+ * @param[in] n number of elements
+ * @param[out] north north component
+ * @param[out] east east component
+ * @param[out] down down component
+ */
+void ecefToNed(
+  const double * lat, const double * lon, const double * x, const double * y, const double * z,
+  std::size_t n, double * north, double * east, double * down);
+
+/**
+ * @brief Rotate local NED vectors into ECEF
+ * @param[in] lat latitude of each frame [rad]
+ * @param[in] lon longitude of each frame [rad]
+ * @param[in] north north component
+ * @param[in] east east component
+ * @param[in] down down component
+ * @param[in] n number of elements
+ * @param[out] x ECEF x
+ * @param[out] y ECEF y
+ * @param[out] z ECEF z
+ */
+void nedToEcef(
+  const double * lat, const double * lon, const double * north, const double * east,
+  const double * down, std::size_t n, double * x, double * y, double * z);
+
+#endif  // FAKE_GNSS_SIMULATOR_GEODESY_H_
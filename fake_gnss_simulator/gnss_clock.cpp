@@ -0,0 +1,81 @@
+/**
+ * @file gnss_clock.cpp
+ * @brief Simulated GPS time with UTC and leap seconds
+ */
+
+#include <gnss_clock.h>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+static constexpr int64_t GPS_EPOCH = 315964800;  //!< @brief 1980-01-06 since 1970-01-01 [s]
+static constexpr int64_t MS_PER_WEEK = 604800000;
+static constexpr int64_t NS_PER_MS = 1000000;
+
+//! @brief UTC since 1970-01-01 when GPS minus UTC became one second more, from 1 s in 1981
+static const int64_t leap_seconds[] = {
+  362793600,  394329600,  425865600,  489024000,  567993600,  631152000,
+  662688000,  709948800,  741484800,  773020800,  820454400,  867715200,
+  915148800,  1136073600, 1230768000, 1341100800, 1435708800, 1483228800,
+};
+
+GnssClock::GnssClock() : utc_(0), scale_(1.0) {}
+
+bool GnssClock::parse(const char * str, int64_t & utc)
+{
+  struct tm tm = {};
+  char sep;
+  int n = sscanf(
+    str, "%d-%d-%d%c%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &sep, &tm.tm_hour,
+    &tm.tm_min, &tm.tm_sec);
+  if (n != 7 || (sep != 'T' && sep != ' ')) return false;
+
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  utc = timegm(&tm);
+  return utc >= GPS_EPOCH;
+}
+
+int GnssClock::leapSeconds(int64_t utc)
+{
+  int n = 0;
+  for (auto t : leap_seconds) {
+    if (utc >= t) ++n;
+  }
+  return n;
+}
+
+void GnssClock::start(Clock::time_point now, int64_t utc, double scale)
+{
+  start_ = now;
+  utc_ = utc;
+  scale_ = scale;
+}
+
+void GnssClock::get(Clock::time_point t, uint32_t period, Time & time) const
+{
+  std::chrono::duration<double> elapsed = (t - start_) * scale_;
+  int64_t utc = utc_ + std::llround(elapsed.count() * 1e9);
+
+  // Epochs are aligned to GPS time, and UTC follows from it
+  int leap = leapSeconds(utc / 1000000000);
+  int64_t gps = (utc / NS_PER_MS) - GPS_EPOCH * 1000 + leap * 1000;
+  gps = (gps + period / 2) / period * period;
+  int64_t utc_ms = gps - leap * 1000 + GPS_EPOCH * 1000;
+
+  time_t sec = utc_ms / 1000;
+  struct tm tm;
+  gmtime_r(&sec, &tm);
+
+  time.week_ = gps / MS_PER_WEEK;
+  time.iTOW_ = gps % MS_PER_WEEK;
+  time.leapSeconds_ = leap;
+  time.year_ = tm.tm_year + 1900;
+  time.month_ = tm.tm_mon + 1;
+  time.day_ = tm.tm_mday;
+  time.hour_ = tm.tm_hour;
+  time.min_ = tm.tm_min;
+  time.sec_ = tm.tm_sec;
+  time.nano_ = (utc_ms % 1000) * NS_PER_MS;
+  time.elapsed_ = elapsed.count();
+}
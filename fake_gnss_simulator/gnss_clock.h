@@ -0,0 +1,77 @@
+#ifndef FAKE_GNSS_SIMULATOR_GNSS_CLOCK_H_
+#define FAKE_GNSS_SIMULATOR_GNSS_CLOCK_H_
+
+/**
+ * @file gnss_clock.h
+ * @brief Simulated GPS time with UTC and leap seconds
+ */
+
+#include <chrono>
+#include <cstdint>
+
+class GnssClock
+{
+public:
+  typedef std::chrono::steady_clock Clock;  //!< @brief monotonic clock
+
+  /**
+   * @brief Time of navigation epoch
+   */
+  struct Time
+  {
+    uint16_t week_;       //!< @brief GPS week number
+    uint32_t iTOW_;       //!< @brief GPS time of week [ms]
+    int8_t leapSeconds_;  //!< @brief GPS minus UTC [s]
+    uint16_t year_;       //!< @brief year (UTC)
+    uint8_t month_;       //!< @brief month (UTC)
+    uint8_t day_;         //!< @brief day of month (UTC)
+    uint8_t hour_;        //!< @brief hour (UTC)
+    uint8_t min_;         //!< @brief minute (UTC)
+    uint8_t sec_;         //!< @brief seconds (UTC)
+    int32_t nano_;        //!< @brief fraction of second [ns]
+    double elapsed_;      //!< @brief simulated time since clock started [s]
+  };
+
+  /**
+   * @brief Constructor
+   */
+  GnssClock();
+
+  /**
+   * @brief Parse UTC time
+   * @param[in] str "YYYY-MM-DDThh:mm:ss", or with a space instead of 'T'
+   * @param[out] utc seconds since 1970-01-01 (UTC)
+   * @return true on success
+   */
+  static bool parse(const char * str, int64_t & utc);
+
+  /**
+   * @brief Get GPS minus UTC
+   * @param[in] utc seconds since 1970-01-01 (UTC)
+   * @return leap seconds
+   */
+  static int leapSeconds(int64_t utc);
+
+  /**
+   * @brief Start clock
+   * @param[in] now current time
+   * @param[in] utc simulated UTC at now [ns since 1970-01-01]
+   * @param[in] scale speed of simulated time relative to real time
+   */
+  void start(Clock::time_point now, int64_t utc, double scale);
+
+  /**
+   * @brief Get time of navigation epoch
+   * @param[in] t current time
+   * @param[in] period navigation period, GPS time is rounded to a multiple of it [ms]
+   * @param[out] time time of epoch
+   */
+  void get(Clock::time_point t, uint32_t period, Time & time) const;
+
+private:
+  Clock::time_point start_;  //!< @brief time when clock started
+  int64_t utc_;              //!< @brief simulated UTC at start_ [ns since 1970-01-01]
+  double scale_;             //!< @brief speed of simulated time relative to real time
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_GNSS_CLOCK_H_
@@ -0,0 +1,131 @@
+/**
+ * @file gps_lnav.cpp
+ * @brief GPS L1 C/A navigation message
+ */
+
+#include <gps_lnav.h>
+#include <cmath>
+
+static constexpr uint32_t PREAMBLE = 0x8B;  //!< @brief first 8 bits of TLM word
+
+//! @brief Data bits d1-d24 of each parity bit D25-D30, d1 being the MSB
+static const uint32_t parity_masks[6] = {0xEC7CD2, 0x763E69, 0xBB1F34,
+                                         0x5D8F9A, 0xAEC7CD, 0x2DEA27};
+
+/**
+ * @brief Set bits of data word
+ * @param[inout] data 24 bit data words
+ * @param[in] word word number, from 1
+ * @param[in] bit first bit in word, from 1 at the MSB
+ * @param[in] length number of bits
+ * @param[in] value value, two's complement if signed
+ */
+static void setBits(uint32_t * data, int word, int bit, int length, uint32_t value)
+{
+  uint32_t mask = (1u << length) - 1;
+  int shift = 24 - (bit - 1) - length;
+  data[word - 1] |= (value & mask) << shift;
+}
+
+/**
+ * @brief Set value split into the last 8 bits of a word and all 24 bits of the next
+ * @param[inout] data 24 bit data words
+ * @param[in] word word holding the 8 MSBs
+ * @param[in] value 32 bit value
+ */
+static void setSplit(uint32_t * data, int word, uint32_t value)
+{
+  setBits(data, word, 17, 8, value >> 24);
+  setBits(data, word + 1, 1, 24, value);
+}
+
+/**
+ * @brief Scale value to integer
+ * @param[in] value value
+ * @param[in] scale_log2 binary exponent of LSB
+ * @return value in LSBs
+ */
+static uint32_t scaled(double value, int scale_log2)
+{
+  return static_cast<uint32_t>(std::llround(std::ldexp(value, -scale_log2)));
+}
+
+/**
+ * @brief Calculate parity bits
+ * @param[in] data 24 data bits
+ * @param[in] prev last two parity bits of the previous word, D29* and D30*
+ * @return 6 parity bits D25-D30
+ */
+static uint32_t parity(uint32_t data, uint32_t prev)
+{
+  uint32_t d29 = prev >> 1;
+  uint32_t d30 = prev & 1;
+  uint32_t p = 0;
+  for (int i = 0; i < 6; ++i) {
+    uint32_t star = (i == 0 || i == 2 || i == 5) ? d29 : d30;
+    p = (p << 1) | (__builtin_parity(data & parity_masks[i]) ^ star);
+  }
+  return p;
+}
+
+void gpsLnavSubframe(const Constellation::Elements & e, uint32_t tow, uint32_t * words)
+{
+  uint32_t data[GPS_LNAV_WORDS] = {};
+  uint32_t id = (tow / GPS_LNAV_SUBFRAME) % 5 + 1;
+  uint32_t toe = std::lround(e.toa_ / 16.0);
+  uint32_t iode = (static_cast<uint32_t>(e.toa_) / 7200) & 0xFF;
+
+  // TLM, and HOW with time of week of the next subframe
+  setBits(data, 1, 1, 8, PREAMBLE);
+  setBits(data, 2, 1, 17, (tow / GPS_LNAV_SUBFRAME + 1) % 100800);
+  setBits(data, 2, 20, 3, id);
+
+  // Angles are in semicircles, correction terms are zero
+  switch (id) {
+    case 1:
+      setBits(data, 3, 1, 10, e.week_ % 1024);
+      setBits(data, 3, 11, 2, 0x1);
+      setBits(data, 8, 1, 8, iode);
+      setBits(data, 8, 9, 16, toe);
+      setBits(data, 9, 9, 16, scaled(e.af1_, -43));
+      setBits(data, 10, 1, 22, scaled(e.af0_, -31));
+      break;
+    case 2:
+      setBits(data, 3, 1, 8, iode);
+      setSplit(data, 4, scaled(e.m0_ / M_PI, -31));
+      setSplit(data, 6, scaled(e.e_, -33));
+      setSplit(data, 8, scaled(e.sqrtA_, -19));
+      setBits(data, 10, 1, 16, toe);
+      break;
+    case 3:
+      setSplit(data, 3, scaled(e.omega0_ / M_PI, -31));
+      setSplit(data, 5, scaled(e.i0_ / M_PI, -31));
+      setSplit(data, 7, scaled(e.omega_ / M_PI, -31));
+      setBits(data, 9, 1, 24, scaled(e.omegaDot_ / M_PI, -43));
+      setBits(data, 10, 1, 8, iode);
+      break;
+    default:
+      // Data ID of pages, with dummy satellite
+      setBits(data, 3, 1, 2, 0x1);
+      break;
+  }
+
+  // Last two data bits of HOW and word 10 are chosen so that parity ends with zeros, which
+  // keeps the next word from being inverted. Parity is of the source bits, d1-d24 being sent
+  // complemented after a word ending with D30 set (IS-GPS-200 20.3.5)
+  uint32_t prev = 0;
+  for (int i = 0; i < GPS_LNAV_WORDS; ++i) {
+    if (i == 1 || i == GPS_LNAV_WORDS - 1) {
+      for (uint32_t t = 0; t < 4; ++t) {
+        if ((parity(data[i] | t, prev) & 0x3) == 0) {
+          data[i] |= t;
+          break;
+        }
+      }
+    }
+    uint32_t p = parity(data[i], prev);
+    if (prev & 1) data[i] ^= 0xFFFFFF;
+    words[i] = (data[i] << 6) | p;
+    prev = p & 0x3;
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef FAKE_GNSS_SIMULATOR_GPS_LNAV_H_
+#define FAKE_GNSS_SIMULATOR_GPS_LNAV_H_
+
+/**
+ * @file gps_lnav.h
+ * @brief GPS L1 C/A navigation message
+ */
+
+#include <constellation.h>
+#include <cstdint>
+
+static constexpr int GPS_LNAV_WORDS = 10;         //!< @brief words of subframe
+static constexpr uint32_t GPS_LNAV_SUBFRAME = 6;  //!< @brief duration of subframe [s]
+
+/**
+ * @brief Encode subframe, ephemeris in subframes 1 to 3 and empty pages in subframes 4 and 5
+ * @param[in] e orbit and clock referred to a time of week which is a multiple of 16 s
+ * @param[in] tow time of week at the start of subframe [s], a multiple of 6 s
+ * @param[out] words words of 24 data bits followed by 6 parity bits, right aligned as in
+ *                   UBX-RXM-SFRBX
+ */
+void gpsLnavSubframe(const Constellation::Elements & e, uint32_t tow, uint32_t * words);
+
+#endif  // FAKE_GNSS_SIMULATOR_GPS_LNAV_H_
@@ -0,0 +1,162 @@
+/**
+ * @file headless.c
+ * @brief Main program without GUI
+ */
+
+#include <getopt.h>
+#include <interface.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Show usage
+ * @param [in] name program name
+ */
+static void usage(const char * name)
+{
+  printf("Usage: %s [options]\n", name);
+  printf("  -c, --config FILE      load settings from FILE instead of the default ini file\n");
+  printf("  -d, --device NAME      device name\n");
+  printf("  -u, --uart2 NAME       device name of UART2\n");
+  printf("  -b, --usb NAME         device name of USB\n");
+  printf("  -r, --rover NAME       device name of rover, moving base being --device\n");
+  printf("  -l, --log FILE         replay UBX log FILE\n");
+  printf("  -t, --trajectory FILE  follow waypoints of CSV FILE\n");
+  printf("  -a, --almanac FILE     satellite orbits of CSV FILE\n");
+  printf("  -o, --obstruction FILE obstruct sectors of sky scripted in CSV FILE\n");
+  printf("  -i, --interference FILE\n");
+  printf("                         jam and spoof as scripted in CSV FILE\n");
+  printf("  -s, --start-time TIME  start at UTC TIME, YYYY-MM-DDThh:mm:ss\n");
+  printf("  -x, --time-scale X     run simulated time X times faster\n");
+  printf("  -m, --sensor-rate HZ   sample sensors of UBX-ESF-MEAS at HZ, up to 100\n");
+  printf("  -f, --faults FILE      inject faults with probabilities of CSV FILE\n");
+  printf("  -n, --fault-seed N     seed faults with N\n");
+  printf("  -e, --checksum-error   generate checksum error\n");
+  printf("  -v, --debug            show debug output\n");
+  printf("  -h, --help             show this help\n");
+}
+
+/**
+ * @brief Main function
+ * @param [in] argc the count of command line arguments
+ * @param [in] argv the command line arguments
+ */
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    {"config", required_argument, NULL, 'c'},
+    {"device", required_argument, NULL, 'd'},
+    {"uart2", required_argument, NULL, 'u'},
+    {"usb", required_argument, NULL, 'b'},
+    {"rover", required_argument, NULL, 'r'},
+    {"log", required_argument, NULL, 'l'},
+    {"trajectory", required_argument, NULL, 't'},
+    {"almanac", required_argument, NULL, 'a'},
+    {"obstruction", required_argument, NULL, 'o'},
+    {"interference", required_argument, NULL, 'i'},
+    {"start-time", required_argument, NULL, 's'},
+    {"time-scale", required_argument, NULL, 'x'},
+    {"sensor-rate", required_argument, NULL, 'm'},
+    {"faults", required_argument, NULL, 'f'},
+    {"fault-seed", required_argument, NULL, 'n'},
+    {"checksum-error", no_argument, NULL, 'e'},
+    {"debug", no_argument, NULL, 'v'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+  };
+  static const char optstring[] = "c:d:u:b:r:l:t:a:o:i:s:x:m:f:n:evh";
+  sigset_t set;
+  int sig;
+  int opt;
+
+  // Settings from the config file are loaded first, and flags override them
+  while ((opt = getopt_long(argc, argv, optstring, options, NULL)) != -1) {
+    if (opt == 'c') {
+      setIniFile(optarg);
+    } else if (opt == 'h') {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (opt == '?') {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Load data from ini file
+  loadIniFile();
+
+  optind = 1;
+  while ((opt = getopt_long(argc, argv, optstring, options, NULL)) != -1) {
+    switch (opt) {
+      case 'd':
+        setDeviceName(optarg);
+        break;
+      case 'u':
+        setUart2DeviceName(optarg);
+        break;
+      case 'b':
+        setUsbDeviceName(optarg);
+        break;
+      case 'r':
+        setRoverDeviceName(optarg);
+        break;
+      case 'l':
+        setLogFile(optarg);
+        break;
+      case 't':
+        setTrajectoryFile(optarg);
+        break;
+      case 'a':
+        setAlmanacFile(optarg);
+        break;
+      case 'o':
+        setObstructionFile(optarg);
+        break;
+      case 'i':
+        setInterferenceFile(optarg);
+        break;
+      case 's':
+        setStartTime(optarg);
+        break;
+      case 'x':
+        setTimeScale(atof(optarg));
+        break;
+      case 'm':
+        setSensorRate(atoi(optarg));
+        break;
+      case 'f':
+        setFaultFile(optarg);
+        break;
+      case 'n':
+        setFaultSeed(strtoul(optarg, NULL, 0));
+        break;
+      case 'e':
+        setChecksumError(1);
+        break;
+      case 'v':
+        setDebugOutput(1);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Block signals before starting threads so that only sigwait() receives them
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  sigaddset(&set, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+  // Start serial port communication
+  if (start() != 0) return EXIT_FAILURE;
+
+  // Run until interrupted
+  sigwait(&set, &sig);
+
+  // Stop serial port communication
+  stop();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file imu_model.cpp
+ * @brief Angular rate, specific force and speed of a level vehicle moving along the trajectory
+ */
+
+#include <imu_model.h>
+#include <algorithm>
+#include <cmath>
+
+static constexpr double GYRO_BIAS = 0.05;    //!< @brief standard deviation of gyro bias [deg/s]
+static constexpr double GYRO_NOISE = 0.01;   //!< @brief gyro noise per sample [deg/s]
+static constexpr double ACCEL_BIAS = 0.02;   //!< @brief standard deviation of accel bias [m/s^2]
+static constexpr double ACCEL_NOISE = 0.01;  //!< @brief accel noise per sample [m/s^2]
+static constexpr double STANDSTILL = 0.01;   //!< @brief speed below which heading is unknown [m/s]
+
+ImuModel::ImuModel() : normal_(0.0, 1.0) { reset(1); }
+
+void ImuModel::reset(uint32_t seed)
+{
+  rng_.seed(seed);
+  normal_.reset();
+  next_ = 0;
+  for (int i = 0; i < 3; ++i) {
+    gyro_bias_[i] = GYRO_BIAS * normal_(rng_);
+    accel_bias_[i] = ACCEL_BIAS * normal_(rng_);
+  }
+}
+
+void ImuModel::measure(const Trajectory & trajectory, int rate, double t, Imu & imu)
+{
+  // Samples fall on the grid of the rate, those older than one second being dropped
+  int64_t last = std::floor(t * rate);
+  next_ = std::max<int64_t>(next_, last - MAX_SAMPLES + 1);
+  imu.n_ = 0;
+  if (last < next_) return;
+  std::size_t n = last - next_ + 1;
+
+  double times[MAX_SAMPLES];
+  Motion m[MAX_SAMPLES];
+  for (std::size_t k = 0; k < n; ++k) times[k] = static_cast<double>(next_ + k) / rate;
+  motion(trajectory, rate, times, n, m);
+  next_ = last + 1;
+
+  // Accelerometers sense gravity as an acceleration upwards, towards -z
+  for (std::size_t k = 0; k < n; ++k) {
+    imu.timeTag_[k] = std::lround(times[k] * 1e3);
+    for (int i = 0; i < 3; ++i) {
+      imu.gyro_[k][i] = m[k].gyro_[i] + gyro_bias_[i] + GYRO_NOISE * normal_(rng_);
+      imu.accel_[k][i] = m[k].accel_[i] + accel_bias_[i] + ACCEL_NOISE * normal_(rng_);
+    }
+    imu.accel_[k][2] -= GRAVITY;
+    imu.speed_[k] = m[k].speed_;
+  }
+  imu.n_ = n;
+}
+
+void ImuModel::motion(const Trajectory & trajectory, int rate, double t, Motion & m)
+{
+  motion(trajectory, rate, &t, 1, &m);
+}
+
+void ImuModel::motion(
+  const Trajectory & trajectory, int rate, const double * t, std::size_t n, Motion * out)
+{
+  if (trajectory.empty()) {
+    std::fill(out, out + n, Motion{{0, 0, 0}, {0, 0, 0}, 0});
+    return;
+  }
+
+  // Rates are differences of velocity half a sample before and after each time, the track
+  // being straight between waypoints and not repeating before its start
+  double h = 0.5 / rate;
+  double times[2 * MAX_SAMPLES];
+  Trajectory::Point p[2 * MAX_SAMPLES];
+  for (std::size_t k = 0; k < n; ++k) {
+    times[2 * k] = std::max(t[k] - h, 0.0);
+    times[2 * k + 1] = t[k] + h;
+  }
+  trajectory.sample(times, 2 * n, p);
+
+  for (std::size_t k = 0; k < n; ++k) {
+    const Trajectory::Point & a = p[2 * k];
+    const Trajectory::Point & b = p[2 * k + 1];
+    double speed_a = std::hypot(a.velN_, a.velE_);
+    double speed_b = std::hypot(b.velN_, b.velE_);
+
+    // Vehicle stays level and heads where it moves, or where it moved before stopping
+    double heading_a = std::atan2(a.velE_, a.velN_);
+    double heading_b = std::atan2(b.velE_, b.velN_);
+    double heading = (speed_b >= STANDSTILL) ? heading_b : heading_a;
+    double yaw = 0;
+    if (speed_a >= STANDSTILL && speed_b >= STANDSTILL) {
+      yaw = std::remainder(heading_b - heading_a, 2 * M_PI) * rate;
+    }
+
+    double an = (b.velN_ - a.velN_) * rate;
+    double ae = (b.velE_ - a.velE_) * rate;
+    double ad = (b.velD_ - a.velD_) * rate;
+    Motion & m = out[k];
+    m.gyro_[0] = 0;
+    m.gyro_[1] = 0;
+    m.gyro_[2] = yaw * 180.0 / M_PI;
+    m.accel_[0] = an * std::cos(heading) + ae * std::sin(heading);
+    m.accel_[1] = -an * std::sin(heading) + ae * std::cos(heading);
+    m.accel_[2] = ad;
+    m.speed_ = 0.5 * (speed_a + speed_b);
+  }
+}
@@ -0,0 +1,91 @@
+#ifndef FAKE_GNSS_SIMULATOR_IMU_MODEL_H_
+#define FAKE_GNSS_SIMULATOR_IMU_MODEL_H_
+
+/**
+ * @file imu_model.h
+ * @brief Angular rate, specific force and speed of a level vehicle moving along the trajectory
+ */
+
+#include <trajectory.h>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+class ImuModel
+{
+public:
+  static constexpr int MAX_RATE = 100;                  //!< @brief highest sensor rate [Hz]
+  static constexpr std::size_t MAX_SAMPLES = MAX_RATE;  //!< @brief samples of one second
+  static constexpr double GRAVITY = 9.80665;            //!< @brief normal gravity [m/s^2]
+
+  /**
+   * @brief Motion in vehicle frame, x forward, y right and z down
+   */
+  struct Motion
+  {
+    double gyro_[3];   //!< @brief angular rate [deg/s]
+    double accel_[3];  //!< @brief acceleration without gravity [m/s^2]
+    double speed_;     //!< @brief speed along x [m/s]
+  };
+
+  /**
+   * @brief Sensor samples taken since the previous measurement, as in UBX-ESF-MEAS
+   */
+  struct Imu
+  {
+    std::size_t n_;                  //!< @brief number of samples
+    uint32_t timeTag_[MAX_SAMPLES];  //!< @brief simulated time of sample [ms]
+    float gyro_[MAX_SAMPLES][3];     //!< @brief angular rate with bias and noise [deg/s]
+    float accel_[MAX_SAMPLES][3];    //!< @brief specific force with bias and noise [m/s^2]
+    float speed_[MAX_SAMPLES];       //!< @brief speed [m/s]
+  };
+
+  /**
+   * @brief Constructor
+   */
+  ImuModel();
+
+  /**
+   * @brief Draw sensor biases and start sampling from time 0
+   * @param[in] seed seed of biases and noise, same samples for the same seed
+   */
+  void reset(uint32_t seed);
+
+  /**
+   * @brief Take samples on the grid of the sensor rate since the previous measurement
+   * @param[in] trajectory trajectory, standing still at heading 0 if empty
+   * @param[in] rate sensor rate [Hz], up to MAX_RATE
+   * @param[in] t simulated time since start [s]
+   * @param[out] imu samples up to t, the latest MAX_SAMPLES of them
+   */
+  void measure(const Trajectory & trajectory, int rate, double t, Imu & imu);
+
+  /**
+   * @brief Get motion without sensor errors, as estimated by sensor fusion
+   * @param[in] trajectory trajectory, standing still at heading 0 if empty
+   * @param[in] rate sensor rate [Hz], rates being differences over one sample
+   * @param[in] t simulated time since start [s]
+   * @param[out] m motion at t
+   */
+  static void motion(const Trajectory & trajectory, int rate, double t, Motion & m);
+
+private:
+  /**
+   * @brief Get motion at times
+   * @param[in] trajectory trajectory, standing still at heading 0 if empty
+   * @param[in] rate sensor rate [Hz]
+   * @param[in] t times [s]
+   * @param[in] n number of times, up to MAX_SAMPLES
+   * @param[out] out motion at each time
+   */
+  static void motion(
+    const Trajectory & trajectory, int rate, const double * t, std::size_t n, Motion * out);
+
+  std::mt19937 rng_;                         //!< @brief noise generator
+  std::normal_distribution<double> normal_;  //!< @brief standard normal distribution
+  int64_t next_;                             //!< @brief index of the next sample on the grid
+  double gyro_bias_[3];                      //!< @brief gyroscope bias [deg/s]
+  double accel_bias_[3];                     //!< @brief accelerometer bias [m/s^2]
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_IMU_MODEL_H_
@@ -10,6 +10,8 @@
 extern "C" {
 #endif
 
+void setIniFile(const char * ini_file) { FakeGNSSSimulator::get()->setIniFile(ini_file); }
+
 void loadIniFile(void) { FakeGNSSSimulator::get()->loadIniFile(); }
 
 void saveIniFile(void) { FakeGNSSSimulator::get()->saveIniFile(); }
@@ -22,6 +24,82 @@ void setDeviceName(const char * device_name)
 
 const char * getDeviceName(void) { return FakeGNSSSimulator::get()->getDeviceName(); }
 
+void setUart2DeviceName(const char * uart2_device_name)
+{
+  FakeGNSSSimulator::get()->setUart2DeviceName(uart2_device_name);
+}
+
+const char * getUart2DeviceName(void) { return FakeGNSSSimulator::get()->getUart2DeviceName(); }
+
+void setUsbDeviceName(const char * usb_device_name)
+{
+  FakeGNSSSimulator::get()->setUsbDeviceName(usb_device_name);
+}
+
+const char * getUsbDeviceName(void) { return FakeGNSSSimulator::get()->getUsbDeviceName(); }
+
+void setLogFile(const char * log_file) { FakeGNSSSimulator::get()->setLogFile(log_file); }
+
+const char * getLogFile(void) { return FakeGNSSSimulator::get()->getLogFile(); }
+
+void setTrajectoryFile(const char * trajectory_file)
+{
+  FakeGNSSSimulator::get()->setTrajectoryFile(trajectory_file);
+}
+
+const char * getTrajectoryFile(void) { return FakeGNSSSimulator::get()->getTrajectoryFile(); }
+
+void setStartTime(const char * start_time) { FakeGNSSSimulator::get()->setStartTime(start_time); }
+
+const char * getStartTime(void) { return FakeGNSSSimulator::get()->getStartTime(); }
+
+void setTimeScale(double time_scale) { FakeGNSSSimulator::get()->setTimeScale(time_scale); }
+
+double getTimeScale(void) { return FakeGNSSSimulator::get()->getTimeScale(); }
+
+void setAlmanacFile(const char * almanac_file)
+{
+  FakeGNSSSimulator::get()->setAlmanacFile(almanac_file);
+}
+
+const char * getAlmanacFile(void) { return FakeGNSSSimulator::get()->getAlmanacFile(); }
+
+void setObstructionFile(const char * obstruction_file)
+{
+  FakeGNSSSimulator::get()->setObstructionFile(obstruction_file);
+}
+
+const char * getObstructionFile(void) { return FakeGNSSSimulator::get()->getObstructionFile(); }
+
+void setInterferenceFile(const char * interference_file)
+{
+  FakeGNSSSimulator::get()->setInterferenceFile(interference_file);
+}
+
+const char * getInterferenceFile(void)
+{
+  return FakeGNSSSimulator::get()->getInterferenceFile();
+}
+
+void setSensorRate(int sensor_rate) { FakeGNSSSimulator::get()->setSensorRate(sensor_rate); }
+
+int getSensorRate(void) { return FakeGNSSSimulator::get()->getSensorRate(); }
+
+void setFaultFile(const char * fault_file) { FakeGNSSSimulator::get()->setFaultFile(fault_file); }
+
+const char * getFaultFile(void) { return FakeGNSSSimulator::get()->getFaultFile(); }
+
+void setFaultSeed(unsigned int fault_seed) { FakeGNSSSimulator::get()->setFaultSeed(fault_seed); }
+
+unsigned int getFaultSeed(void) { return FakeGNSSSimulator::get()->getFaultSeed(); }
+
+void setRoverDeviceName(const char * rover_device_name)
+{
+  FakeGNSSSimulator::get()->setRoverDeviceName(rover_device_name);
+}
+
+const char * getRoverDeviceName(void) { return FakeGNSSSimulator::get()->getRoverDeviceName(); }
+
 int start(void) { return FakeGNSSSimulator::get()->start(); }
 
 void stop(void) { FakeGNSSSimulator::get()->stop(); }
@@ -30,6 +108,16 @@ void setChecksumError(int is_error) { FakeGNSSSimulator::get()->setChecksumError
 
 void setDebugOutput(int is_debug) { FakeGNSSSimulator::get()->setDebugOutput(is_debug); }
 
+void setFaultRate(int message_class, FaultType fault, double probability)
+{
+  FakeGNSSSimulator::get()->setFaultRate(message_class, fault, probability);
+}
+
+double getFaultRate(int message_class, FaultType fault)
+{
+  return FakeGNSSSimulator::get()->getFaultRate(message_class, fault);
+}
+
 // UBX-MON-HW
 void setAStatus(AStatus aStatus) { FakeGNSSSimulator::get()->setAStatus(aStatus); }
 
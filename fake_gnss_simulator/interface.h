@@ -13,6 +13,12 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Set path of ini file to use instead of the default one
+ * @param [in] ini_file path of ini file
+ */
+void setIniFile(const char * ini_file);
+
 /**
  * @brief Load data from ini file
  */
@@ -36,6 +42,162 @@ void setDeviceName(const char * device_name);
  */
 const char * getDeviceName(void);
 
+/**
+ * @brief Set device name of UART2
+ * @param [in] uart2_device_name device name, empty to leave UART2 closed
+ */
+void setUart2DeviceName(const char * uart2_device_name);
+
+/**
+ * @brief Get device name of UART2
+ * @return device name of UART2
+ */
+const char * getUart2DeviceName(void);
+
+/**
+ * @brief Set device name of USB
+ * @param [in] usb_device_name device name, empty to leave USB closed
+ */
+void setUsbDeviceName(const char * usb_device_name);
+
+/**
+ * @brief Get device name of USB
+ * @return device name of USB
+ */
+const char * getUsbDeviceName(void);
+
+/**
+ * @brief Set path of UBX log file to replay
+ * @param [in] log_file path of log file, empty to transmit generated messages only
+ */
+void setLogFile(const char * log_file);
+
+/**
+ * @brief Get path of UBX log file
+ * @return path of log file
+ */
+const char * getLogFile(void);
+
+/**
+ * @brief Set path of trajectory file
+ * @param [in] trajectory_file path of CSV file, empty to stay at a fixed position
+ */
+void setTrajectoryFile(const char * trajectory_file);
+
+/**
+ * @brief Get path of trajectory file
+ * @return path of trajectory file
+ */
+const char * getTrajectoryFile(void);
+
+/**
+ * @brief Set UTC time at start
+ * @param [in] start_time "YYYY-MM-DDThh:mm:ss", empty to start at the current time
+ */
+void setStartTime(const char * start_time);
+
+/**
+ * @brief Get UTC time at start
+ * @return UTC time at start
+ */
+const char * getStartTime(void);
+
+/**
+ * @brief Set speed of simulated time
+ * @param [in] time_scale speed relative to real time
+ */
+void setTimeScale(double time_scale);
+
+/**
+ * @brief Get speed of simulated time
+ * @return speed relative to real time
+ */
+double getTimeScale(void);
+
+/**
+ * @brief Set path of almanac file
+ * @param [in] almanac_file path of CSV file, empty for nominal constellations
+ */
+void setAlmanacFile(const char * almanac_file);
+
+/**
+ * @brief Get path of almanac file
+ * @return path of almanac file
+ */
+const char * getAlmanacFile(void);
+
+/**
+ * @brief Set path of obstruction file
+ * @param [in] obstruction_file path of CSV file, empty for open sky
+ */
+void setObstructionFile(const char * obstruction_file);
+
+/**
+ * @brief Get path of obstruction file
+ * @return path of obstruction file
+ */
+const char * getObstructionFile(void);
+
+/**
+ * @brief Set path of interference file
+ * @param [in] interference_file path of CSV file, empty for states set by hand
+ */
+void setInterferenceFile(const char * interference_file);
+
+/**
+ * @brief Get path of interference file
+ * @return path of interference file
+ */
+const char * getInterferenceFile(void);
+
+/**
+ * @brief Set rate of sensor samples in UBX-ESF-MEAS
+ * @param [in] sensor_rate rate [Hz], up to 100
+ */
+void setSensorRate(int sensor_rate);
+
+/**
+ * @brief Get rate of sensor samples in UBX-ESF-MEAS
+ * @return rate [Hz]
+ */
+int getSensorRate(void);
+
+/**
+ * @brief Set path of fault file
+ * @param [in] fault_file path of CSV file of fault probabilities, empty to keep those set
+ */
+void setFaultFile(const char * fault_file);
+
+/**
+ * @brief Get path of fault file
+ * @return path of fault file
+ */
+const char * getFaultFile(void);
+
+/**
+ * @brief Set seed of faults, which restart on every run
+ * @param [in] fault_seed seed
+ */
+void setFaultSeed(unsigned int fault_seed);
+
+/**
+ * @brief Get seed of faults
+ * @return seed
+ */
+unsigned int getFaultSeed(void);
+
+/**
+ * @brief Set device name of rover
+ * @param [in] rover_device_name device name, empty to simulate a single receiver
+ */
+void setRoverDeviceName(const char * rover_device_name);
+
+/**
+ * @brief Get device name of rover
+ * @return device name of rover
+ */
+const char * getRoverDeviceName(void);
+
 /**
  * @brief Start serial port communication
  * @return 0 on success, otherwise error
@@ -59,6 +221,22 @@ void setChecksumError(int is_error);
  */
 void setDebugOutput(int is_debug);
 
+/**
+ * @brief Set probability of fault per output frame, also while running
+ * @param [in] message_class message class, 0xF0 for NMEA, -1 for every class
+ * @param [in] fault fault
+ * @param [in] probability probability from 0 to 1
+ */
+void setFaultRate(int message_class, FaultType fault, double probability);
+
+/**
+ * @brief Get probability of fault per output frame
+ * @param [in] message_class message class, 0xF0 for NMEA
+ * @param [in] fault fault
+ * @return probability
+ */
+double getFaultRate(int message_class, FaultType fault);
+
 // UBX-MON-HW
 /**
  * @brief Set aStatus
@@ -0,0 +1,85 @@
+/**
+ * @file interference.cpp
+ * @brief Scripted jamming and spoofing, tabulated once and looked up at navigation epochs
+ */
+
+#include <csv_reader.h>
+#include <interference.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+static constexpr int COLUMNS = 8;  //!< @brief time and values of a line
+
+//! @brief Largest value by column, states being held and the others interpolated
+static const double limits[COLUMNS] = {0, 255, 8191, 65535, 100, 3, 3, 4};
+
+int Interference::load(const char * path)
+{
+  clear();
+
+  CsvReader csv;
+  int ret = csv.open(path);
+  if (ret != 0) return ret;
+
+  std::vector<double> rows;
+  double v[COLUMNS];
+  while (csv.next(v, COLUMNS, COLUMNS) > 0) {
+    double last = rows.empty() ? -1.0 : rows[rows.size() - COLUMNS];
+    if (v[0] <= last || v[0] > MAX_DURATION) {
+      csv.reject("time must increase up to " + std::to_string(std::lround(MAX_DURATION)) + " s");
+      continue;
+    }
+    for (int k = 1; k < COLUMNS; ++k) v[k] = std::min(std::max(v[k], 0.0), limits[k]);
+    rows.insert(rows.end(), v, v + COLUMNS);
+  }
+
+  if (rows.empty()) {
+    std::cerr << path << ": no line found" << std::endl;
+    return EINVAL;
+  }
+
+  // Values before the first line are those of it, and epochs look up the nearest step
+  std::size_t n = rows.size() / COLUMNS;
+  table_.resize(static_cast<std::size_t>(rows[(n - 1) * COLUMNS] / STEP) + 1);
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < table_.size(); ++i) {
+    double t = i * STEP;
+    while (k + 1 < n && rows[(k + 1) * COLUMNS] <= t) ++k;
+    const double * a = &rows[k * COLUMNS];
+    const double * b = (k + 1 < n) ? a + COLUMNS : a;
+    double r = (b[0] > a[0]) ? std::min(std::max((t - a[0]) / (b[0] - a[0]), 0.0), 1.0) : 0.0;
+    auto lerp = [&](int c) { return a[c] + (b[c] - a[c]) * r; };
+    Sample & s = table_[i];
+    s.jamInd_ = std::lround(lerp(1));
+    s.agcCnt_ = std::lround(lerp(2));
+    s.noisePerMS_ = std::lround(lerp(3));
+    s.cn0Loss_ = lerp(4);
+    s.jammingState_ = a[5];
+    s.spoofDetState_ = a[6];
+    s.aStatus_ = a[7];
+  }
+  return 0;
+}
+
+void Interference::clear(void)
+{
+  table_.clear();
+  table_.shrink_to_fit();
+}
+
+const Interference::Sample * Interference::at(double t) const
+{
+  if (table_.empty()) return nullptr;
+  double i = std::max(std::round(t / STEP), 0.0);
+  return &table_[std::min(static_cast<std::size_t>(i), table_.size() - 1)];
+}
+
+void Interference::apply(double t, Constellation::Sky & sky) const
+{
+  const Sample * s = at(t);
+  if (s == nullptr) return;
+  for (std::size_t i = 0; i < sky.n_; ++i) sky.cno_[i] -= s->cn0Loss_;
+}
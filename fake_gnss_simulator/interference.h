@@ -0,0 +1,71 @@
+#ifndef FAKE_GNSS_SIMULATOR_INTERFERENCE_H_
+#define FAKE_GNSS_SIMULATOR_INTERFERENCE_H_
+
+/**
+ * @file interference.h
+ * @brief Scripted jamming and spoofing, tabulated once and looked up at navigation epochs
+ */
+
+#include <constellation.h>
+#include <cstdint>
+#include <vector>
+
+class Interference
+{
+public:
+  static constexpr double STEP = 0.025;          //!< @brief step of table, the fastest epoch [s]
+  static constexpr double MAX_DURATION = 86400;  //!< @brief longest scenario [s]
+
+  /**
+   * @brief Values of scenario at a time
+   */
+  struct Sample
+  {
+    float cn0Loss_;          //!< @brief C/N0 lost by all signals [dB]
+    uint16_t agcCnt_;        //!< @brief AGC monitor
+    uint16_t noisePerMS_;    //!< @brief noise level
+    uint8_t jamInd_;         //!< @brief CW jamming indicator
+    uint8_t jammingState_;   //!< @brief output of jamming monitor, JammingState
+    uint8_t spoofDetState_;  //!< @brief spoofing detection state, SpoofDetState
+    uint8_t aStatus_;        //!< @brief antenna supervisor state, AStatus
+  };
+
+  /**
+   * @brief Load scenario from CSV file and tabulate it
+   * @param[in] path path of file with lines of time [s], jamInd, agcCnt, noisePerMS, C/N0 loss
+   *                 [dB], jammingState, spoofDetState and aStatus, in order of time
+   * @return 0 on success, otherwise error
+   * @note Rows are read by CsvReader::next(), which skips a header
+   */
+  int load(const char * path);
+
+  /**
+   * @brief Remove scenario
+   */
+  void clear(void);
+
+  /**
+   * @brief Check if no scenario is loaded
+   * @return true if no scenario is loaded
+   */
+  bool empty(void) const { return table_.empty(); }
+
+  /**
+   * @brief Look up values at a time
+   * @param[in] t time since the start of simulation, or of the trajectory [s]
+   * @return values, those of the last line after it, nullptr if no scenario is loaded
+   */
+  const Sample * at(double t) const;
+
+  /**
+   * @brief Reduce C/N0 of all signals by the loss at a time
+   * @param[in] t time since the start of simulation, or of the trajectory [s]
+   * @param[inout] sky geometry, of which C/N0 is reduced
+   */
+  void apply(double t, Constellation::Sky & sky) const;
+
+private:
+  std::vector<Sample> table_;  //!< @brief values every STEP from time 0
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_INTERFERENCE_H_
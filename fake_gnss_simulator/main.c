@@ -24,6 +24,8 @@ typedef struct
   GtkWidget * sw_serial_port;     //!< @brief GtkSwitch
   GtkWidget * sw_checksum_error;  //!< @brief GtkSwitch
   GtkWidget * sw_debug_output;    //!< @brief GtkSwitch
+  GtkWidget * file_log_file;         //!< @brief GtkFileChooserButton
+  GtkWidget * file_trajectory_file;  //!< @brief GtkFileChooserButton
 
   GtkWidget * grd_ubx_mon_hw;     //!< @brief GtkGrid
   GtkWidget * cmb_a_status;       //!< @brief GtkComboBoxText
@@ -48,6 +50,8 @@ void initGeneral(GtkBuilder * b, Widgets * w)
   w->sw_serial_port = GTK_WIDGET(gtk_builder_get_object(b, "sw_serial_port"));
   w->sw_checksum_error = GTK_WIDGET(gtk_builder_get_object(b, "sw_checksum_error"));
   w->sw_debug_output = GTK_WIDGET(gtk_builder_get_object(b, "sw_debug_output"));
+  w->file_log_file = GTK_WIDGET(gtk_builder_get_object(b, "file_log_file"));
+  w->file_trajectory_file = GTK_WIDGET(gtk_builder_get_object(b, "file_trajectory_file"));
 
   // Adds a child to stack
   gtk_stack_add_named(GTK_STACK(w->stk_base), w->grd_general, "General");
@@ -56,6 +60,13 @@ void initGeneral(GtkBuilder * b, Widgets * w)
 
   // Set the text in the widget
   gtk_entry_set_text(GTK_ENTRY(w->txt_device_name), getDeviceName());
+  // Set filename as the current filename for the file chooser
+  const char * file = getLogFile();
+  if (strlen(file) > 0) gtk_file_chooser_set_filename(GTK_FILE_CHOOSER(w->file_log_file), file);
+  file = getTrajectoryFile();
+  if (strlen(file) > 0) {
+    gtk_file_chooser_set_filename(GTK_FILE_CHOOSER(w->file_trajectory_file), file);
+  }
 }
 
 void initUbxMonHW(GtkBuilder * b, Widgets * w)
@@ -282,6 +293,30 @@ gboolean on_sw_debug_output_state_set(GtkSwitch * widget, gboolean state, gpoint
   return FALSE;
 }
 
+/**
+ * @brief Emitted when there is a change in the set of selected files
+ * @param [in] chooser the object which received the signal
+ * @param [in] user data set when the signal handler was connected
+ */
+void on_file_log_file_selection_changed(GtkFileChooser * chooser, gpointer user_data)
+{
+  // Get the filename for the currently selected file in the file selector
+  // and set path of log file for saving it to ini file
+  setLogFile(gtk_file_chooser_get_filename(chooser));
+}
+
+/**
+ * @brief Emitted when there is a change in the set of selected files
+ * @param [in] chooser the object which received the signal
+ * @param [in] user data set when the signal handler was connected
+ */
+void on_file_trajectory_file_selection_changed(GtkFileChooser * chooser, gpointer user_data)
+{
+  // Get the filename for the currently selected file in the file selector
+  // and set path of trajectory file for saving it to ini file
+  setTrajectoryFile(gtk_file_chooser_get_filename(chooser));
+}
+
 // UBX-MON-HW
 /**
  * @brief Emitted when the active item is changed
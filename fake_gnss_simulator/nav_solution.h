@@ -0,0 +1,79 @@
+#ifndef FAKE_GNSS_SIMULATOR_NAV_SOLUTION_H_
+#define FAKE_GNSS_SIMULATOR_NAV_SOLUTION_H_
+
+/**
+ * @file nav_solution.h
+ * @brief Simulated navigation solution shared by UBX and NMEA output
+ */
+
+#include <cstdint>
+
+/**
+ * @brief GNSS identifier as in UBX
+ */
+enum GnssId {
+  GNSS_ID_GPS = 0,
+  GNSS_ID_SBAS = 1,
+  GNSS_ID_GALILEO = 2,
+  GNSS_ID_BEIDOU = 3,
+  GNSS_ID_QZSS = 5,
+  GNSS_ID_GLONASS = 6,
+};
+
+/**
+ * @brief Satellite in view
+ */
+struct SatInfo
+{
+  uint8_t gnssId_;  //!< @brief GNSS identifier
+  uint8_t svId_;    //!< @brief satellite identifier
+  int8_t elev_;     //!< @brief elevation [deg]
+  int16_t azim_;    //!< @brief azimuth [deg]
+  uint8_t cno_;     //!< @brief carrier to noise ratio [dBHz]
+  bool used_;       //!< @brief used in navigation solution
+};
+
+/**
+ * @brief Navigation solution in UBX units
+ */
+struct NavSolution
+{
+  static constexpr int MAX_SATELLITES = 64;  //!< @brief largest number of satellites in view
+
+  uint32_t iTOW_;     //!< @brief GPS time of week [ms]
+  uint16_t year_;     //!< @brief year (UTC)
+  uint8_t month_;     //!< @brief month (UTC)
+  uint8_t day_;       //!< @brief day of month (UTC)
+  uint8_t hour_;      //!< @brief hour (UTC)
+  uint8_t min_;       //!< @brief minute (UTC)
+  uint8_t sec_;       //!< @brief seconds (UTC)
+  uint8_t valid_;     //!< @brief validity flags of date and time
+  uint32_t tAcc_;     //!< @brief time accuracy estimate [ns]
+  int32_t nano_;      //!< @brief fraction of second [ns]
+  uint8_t fixType_;   //!< @brief GNSS fix type
+  uint8_t flags_;     //!< @brief fix status flags
+  uint8_t flags2_;    //!< @brief additional flags
+  uint8_t numSV_;     //!< @brief number of satellites used
+  int32_t lon_;       //!< @brief longitude [1e-7 deg]
+  int32_t lat_;       //!< @brief latitude [1e-7 deg]
+  int32_t height_;    //!< @brief height above ellipsoid [mm]
+  int32_t hMSL_;      //!< @brief height above mean sea level [mm]
+  uint32_t hAcc_;     //!< @brief horizontal accuracy estimate [mm]
+  uint32_t vAcc_;     //!< @brief vertical accuracy estimate [mm]
+  int32_t velN_;      //!< @brief NED north velocity [mm/s]
+  int32_t velE_;      //!< @brief NED east velocity [mm/s]
+  int32_t velD_;      //!< @brief NED down velocity [mm/s]
+  int32_t gSpeed_;    //!< @brief ground speed [mm/s]
+  int32_t headMot_;   //!< @brief heading of motion [1e-5 deg]
+  uint32_t sAcc_;     //!< @brief speed accuracy estimate [mm/s]
+  uint32_t headAcc_;  //!< @brief heading accuracy estimate [1e-5 deg]
+  uint16_t pDOP_;     //!< @brief position DOP [0.01]
+  uint16_t hDOP_;     //!< @brief horizontal DOP [0.01]
+  uint16_t vDOP_;     //!< @brief vertical DOP [0.01]
+  uint8_t flags3_;    //!< @brief additional flags, with age of corrections
+
+  int numSats_;                   //!< @brief number of satellites in view
+  SatInfo sats_[MAX_SATELLITES];  //!< @brief satellites in view
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_NAV_SOLUTION_H_
@@ -0,0 +1,334 @@
+/**
+ * @file nmea.cpp
+ * @brief NMEA 0183 sentence formatter
+ */
+
+#include <nmea.h>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Signal of each GNSS in NMEA 4.10
+ */
+struct NmeaSystem
+{
+  uint8_t gnssId_;    //!< @brief GNSS identifier as in UBX
+  const char * gsa_;  //!< @brief GSA prefix
+  const char * gsv_;  //!< @brief GSV prefix
+  char systemId_;     //!< @brief system id of GSA
+  uint8_t svOffset_;  //!< @brief added to svId to get NMEA satellite number
+};
+
+static const NmeaSystem systems[] = {
+  {GNSS_ID_GPS, "$GNGSA,A,", "$GPGSV,", '1', 0},
+  {GNSS_ID_GLONASS, "$GNGSA,A,", "$GLGSV,", '2', 64},
+  {GNSS_ID_GALILEO, "$GNGSA,A,", "$GAGSV,", '3', 0},
+  {GNSS_ID_BEIDOU, "$GNGSA,A,", "$GBGSV,", '4', 0},
+};
+
+static const char HEX[] = "0123456789ABCDEF";
+
+/**
+ * @brief Append string
+ * @param[in] p output position
+ * @param[in] s string
+ * @return next output position
+ */
+static char * put(char * p, const char * s)
+{
+  std::size_t n = strlen(s);
+  memcpy(p, s, n);
+  return p + n;
+}
+
+/**
+ * @brief Append unsigned integer padded with zeros
+ * @param[in] p output position
+ * @param[in] value value
+ * @param[in] width minimum number of digits
+ * @return next output position
+ */
+static char * putZeroPadded(char * p, uint32_t value, int width)
+{
+  for (int i = width - 1; i >= 0; --i) {
+    p[i] = '0' + value % 10;
+    value /= 10;
+  }
+  return p + width;
+}
+
+/**
+ * @brief Append fixed point number
+ * @param[in] p output position
+ * @param[in] value value scaled by 10^decimals
+ * @param[in] decimals number of decimal places
+ * @return next output position
+ */
+static char * putFixed(char * p, int64_t value, int decimals)
+{
+  if (value < 0) {
+    *p++ = '-';
+    value = -value;
+  }
+  int64_t scale = 1;
+  for (int i = 0; i < decimals; ++i) scale *= 10;
+
+  p = std::to_chars(p, p + 20, value / scale).ptr;
+  if (decimals > 0) {
+    *p++ = '.';
+    p = putZeroPadded(p, value % scale, decimals);
+  }
+  return p;
+}
+
+/**
+ * @brief Append UTC time hhmmss.ss
+ * @param[in] p output position
+ * @param[in] s navigation solution
+ * @return next output position
+ */
+static char * putTime(char * p, const NavSolution & s)
+{
+  p = putZeroPadded(p, s.hour_, 2);
+  p = putZeroPadded(p, s.min_, 2);
+  p = putZeroPadded(p, s.sec_, 2);
+  *p++ = '.';
+  return putZeroPadded(p, s.nano_ > 0 ? s.nano_ / 10000000 : 0, 2);
+}
+
+/**
+ * @brief Append degrees and minutes with hemisphere, ddmm.mmmmm,N
+ * @param[in] p output position
+ * @param[in] value angle [1e-7 deg]
+ * @param[in] degree_width number of digits of degrees
+ * @param[in] positive hemisphere of positive angle
+ * @param[in] negative hemisphere of negative angle
+ * @return next output position
+ */
+static char * putAngle(char * p, int32_t value, int degree_width, char positive, char negative)
+{
+  char hemisphere = (value < 0) ? negative : positive;
+  uint32_t v = (value < 0) ? -static_cast<int64_t>(value) : value;
+
+  // Fraction of degree in 1e-7 deg times 60 is minutes in 1e-7, and 3/5 of it is minutes in 1e-5
+  uint32_t minutes = static_cast<uint64_t>(v % 10000000) * 3 / 5;
+  p = putZeroPadded(p, v / 10000000, degree_width);
+  p = putZeroPadded(p, minutes / 100000, 2);
+  *p++ = '.';
+  p = putZeroPadded(p, minutes % 100000, 5);
+  *p++ = ',';
+  *p++ = hemisphere;
+  return p;
+}
+
+/**
+ * @brief Get mode indicator
+ * @param[in] s navigation solution
+ * @return A (autonomous), D (differential), F (RTK float), R (RTK fixed) or N (no fix)
+ */
+static char getMode(const NavSolution & s)
+{
+  if (s.fixType_ < 2 || s.fixType_ > 4 || !(s.flags_ & 0x01)) return 'N';
+  switch (s.flags_ >> 6) {
+    case 1:
+      return 'F';
+    case 2:
+      return 'R';
+    default:
+      return (s.flags_ & 0x02) ? 'D' : 'A';
+  }
+}
+
+/**
+ * @brief Append checksum and CR LF
+ * @param[in] start start of sentence
+ * @param[in] p output position
+ * @return next output position
+ */
+static char * finish(const char * start, char * p)
+{
+  uint8_t cs = 0;
+  for (const char * c = start + 1; c < p; ++c) cs ^= *c;
+  *p++ = '*';
+  *p++ = HEX[cs >> 4];
+  *p++ = HEX[cs & 0x0F];
+  *p++ = '\r';
+  *p++ = '\n';
+  return p;
+}
+
+std::size_t nmeaGGA(const NavSolution & s, char * buf)
+{
+  char mode = getMode(s);
+  char quality = '5';
+  if (mode == 'N') quality = '0';
+  if (mode == 'A') quality = '1';
+  if (mode == 'D') quality = '2';
+  if (mode == 'R') quality = '4';
+
+  char * p = put(buf, "$GNGGA,");
+  p = putTime(p, s);
+  *p++ = ',';
+  p = putAngle(p, s.lat_, 2, 'N', 'S');
+  *p++ = ',';
+  p = putAngle(p, s.lon_, 3, 'E', 'W');
+  *p++ = ',';
+  *p++ = quality;
+  *p++ = ',';
+  p = putZeroPadded(p, s.numSV_, 2);
+  *p++ = ',';
+  p = putFixed(p, s.hDOP_, 2);
+  *p++ = ',';
+  p = putFixed(p, s.hMSL_ / 100, 1);
+  p = put(p, ",M,");
+  p = putFixed(p, (s.height_ - s.hMSL_) / 100, 1);
+  p = put(p, ",M,,");
+  return finish(buf, p) - buf;
+}
+
+std::size_t nmeaGLL(const NavSolution & s, char * buf)
+{
+  char mode = getMode(s);
+
+  char * p = put(buf, "$GNGLL,");
+  p = putAngle(p, s.lat_, 2, 'N', 'S');
+  *p++ = ',';
+  p = putAngle(p, s.lon_, 3, 'E', 'W');
+  *p++ = ',';
+  p = putTime(p, s);
+  *p++ = ',';
+  *p++ = (mode == 'N') ? 'V' : 'A';
+  *p++ = ',';
+  *p++ = mode;
+  return finish(buf, p) - buf;
+}
+
+std::size_t nmeaGSA(const NavSolution & s, char * buf)
+{
+  char * q = buf;
+  char fix = (s.fixType_ == 2) ? '2' : (s.fixType_ == 3 || s.fixType_ == 4) ? '3' : '1';
+
+  for (const auto & system : systems) {
+    char * p = put(q, system.gsa_);
+    *p++ = fix;
+
+    // Up to 12 satellites used, empty fields for the rest
+    int n = 0;
+    for (int i = 0; i < s.numSats_ && n < 12; ++i) {
+      const SatInfo & sat = s.sats_[i];
+      if (sat.gnssId_ != system.gnssId_ || !sat.used_) continue;
+      *p++ = ',';
+      p = putZeroPadded(p, sat.svId_ + system.svOffset_, 2);
+      ++n;
+    }
+    if (n == 0 && q != buf) continue;
+    for (; n < 12; ++n) *p++ = ',';
+
+    *p++ = ',';
+    p = putFixed(p, s.pDOP_, 2);
+    *p++ = ',';
+    p = putFixed(p, s.hDOP_, 2);
+    *p++ = ',';
+    p = putFixed(p, s.vDOP_, 2);
+    *p++ = ',';
+    *p++ = system.systemId_;
+    q = finish(q, p);
+  }
+  return q - buf;
+}
+
+std::size_t nmeaGSV(const NavSolution & s, char * buf)
+{
+  char * q = buf;
+
+  for (const auto & system : systems) {
+    int total = 0;
+    for (int i = 0; i < s.numSats_; ++i) {
+      if (s.sats_[i].gnssId_ == system.gnssId_) ++total;
+    }
+    if (total == 0) continue;
+
+    int sentences = (total + 3) / 4;
+    int i = 0;
+    for (int k = 1; k <= sentences; ++k) {
+      char * p = put(q, system.gsv_);
+      *p++ = '0' + sentences;
+      *p++ = ',';
+      *p++ = '0' + k;
+      *p++ = ',';
+      p = putZeroPadded(p, total, 2);
+
+      for (int n = 0; n < 4 && i < s.numSats_; ++i) {
+        const SatInfo & sat = s.sats_[i];
+        if (sat.gnssId_ != system.gnssId_) continue;
+        *p++ = ',';
+        p = putZeroPadded(p, sat.svId_ + system.svOffset_, 2);
+        *p++ = ',';
+        p = putZeroPadded(p, sat.elev_ > 0 ? sat.elev_ : 0, 2);
+        *p++ = ',';
+        p = putZeroPadded(p, sat.azim_, 3);
+        *p++ = ',';
+        if (sat.cno_ > 0) p = putZeroPadded(p, sat.cno_, 2);
+        ++n;
+      }
+      q = finish(q, p);
+    }
+  }
+  return q - buf;
+}
+
+std::size_t nmeaRMC(const NavSolution & s, char * buf)
+{
+  char mode = getMode(s);
+
+  char * p = put(buf, "$GNRMC,");
+  p = putTime(p, s);
+  *p++ = ',';
+  *p++ = (mode == 'N') ? 'V' : 'A';
+  *p++ = ',';
+  p = putAngle(p, s.lat_, 2, 'N', 'S');
+  *p++ = ',';
+  p = putAngle(p, s.lon_, 3, 'E', 'W');
+  *p++ = ',';
+  // 1 mm/s is 0.001943844 knots
+  p = putFixed(p, static_cast<int64_t>(s.gSpeed_) * 1943844 / 1000000, 3);
+  *p++ = ',';
+  p = putFixed(p, s.headMot_ / 1000, 2);
+  *p++ = ',';
+  p = putZeroPadded(p, s.day_, 2);
+  p = putZeroPadded(p, s.month_, 2);
+  p = putZeroPadded(p, s.year_ % 100, 2);
+  p = put(p, ",,,");
+  *p++ = mode;
+  p = put(p, ",V");
+  return finish(buf, p) - buf;
+}
+
+std::size_t nmeaVTG(const NavSolution & s, char * buf)
+{
+  char * p = put(buf, "$GNVTG,");
+  p = putFixed(p, s.headMot_ / 1000, 2);
+  p = put(p, ",T,,M,");
+  p = putFixed(p, static_cast<int64_t>(s.gSpeed_) * 1943844 / 1000000, 3);
+  p = put(p, ",N,");
+  // 1 mm/s is 0.0036 km/h
+  p = putFixed(p, static_cast<int64_t>(s.gSpeed_) * 36 / 10, 3);
+  p = put(p, ",K,");
+  *p++ = getMode(s);
+  return finish(buf, p) - buf;
+}
+
+std::size_t nmeaZDA(const NavSolution & s, char * buf)
+{
+  char * p = put(buf, "$GNZDA,");
+  p = putTime(p, s);
+  *p++ = ',';
+  p = putZeroPadded(p, s.day_, 2);
+  *p++ = ',';
+  p = putZeroPadded(p, s.month_, 2);
+  *p++ = ',';
+  p = putZeroPadded(p, s.year_, 4);
+  p = put(p, ",00,00");
+  return finish(buf, p) - buf;
+}
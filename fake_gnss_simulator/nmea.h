@@ -0,0 +1,57 @@
+#ifndef FAKE_GNSS_SIMULATOR_NMEA_H_
+#define FAKE_GNSS_SIMULATOR_NMEA_H_
+
+/**
+ * @file nmea.h
+ * @brief NMEA 0183 sentence formatter
+ */
+
+#include <nav_solution.h>
+#include <cstddef>
+
+static constexpr std::size_t NMEA_MAX_SENTENCE = 82;  //!< @brief longest sentence with CR LF
+
+/**
+ * @brief Format function of a sentence type
+ * @param[in] s navigation solution
+ * @param[out] buf output buffer, large enough for all sentences of the type
+ * @return number of characters written
+ */
+typedef std::size_t (*NMEA_FUNC)(const NavSolution & s, char * buf);
+
+/**
+ * @brief Format GGA, global positioning system fix data
+ */
+std::size_t nmeaGGA(const NavSolution & s, char * buf);
+
+/**
+ * @brief Format GLL, latitude and longitude with time of position fix and status
+ */
+std::size_t nmeaGLL(const NavSolution & s, char * buf);
+
+/**
+ * @brief Format GSA, one sentence per GNSS with satellites used
+ */
+std::size_t nmeaGSA(const NavSolution & s, char * buf);
+
+/**
+ * @brief Format GSV, sentences per GNSS with up to four satellites in view each
+ */
+std::size_t nmeaGSV(const NavSolution & s, char * buf);
+
+/**
+ * @brief Format RMC, recommended minimum data
+ */
+std::size_t nmeaRMC(const NavSolution & s, char * buf);
+
+/**
+ * @brief Format VTG, course over ground and ground speed
+ */
+std::size_t nmeaVTG(const NavSolution & s, char * buf);
+
+/**
+ * @brief Format ZDA, time and date
+ */
+std::size_t nmeaZDA(const NavSolution & s, char * buf);
+
+#endif  // FAKE_GNSS_SIMULATOR_NMEA_H_
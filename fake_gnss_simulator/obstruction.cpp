@@ -0,0 +1,69 @@
+/**
+ * @file obstruction.cpp
+ * @brief Scripted sectors of sky attenuating or blocking signals, as urban canyons and tunnels do
+ */
+
+#include <csv_reader.h>
+#include <obstruction.h>
+#include <cerrno>
+#include <cmath>
+#include <iostream>
+
+static constexpr double BLOCKED = 100.0;  //!< @brief attenuation of sectors which block [dB]
+
+int Obstruction::load(const char * path)
+{
+  clear();
+
+  CsvReader csv;
+  int ret = csv.open(path);
+  if (ret != 0) return ret;
+
+  double v[6];
+  int n;
+  while ((n = csv.next(v, 5, 6)) > 0) {
+    if (v[1] <= v[0]) {
+      csv.reject("end time must be after start time");
+      continue;
+    }
+
+    // Sectors run clockwise and wrap through north, the same azimuths meaning all around
+    double width = std::fmod(v[3] - v[2], 360.0);
+    if (width <= 0) width += 360.0;
+    start_.push_back(v[0]);
+    end_.push_back(v[1]);
+    from_.push_back(std::fmod(v[2] + 360.0, 360.0));
+    width_.push_back(width);
+    elev_.push_back(v[4]);
+    loss_.push_back((n > 5) ? v[5] : BLOCKED);
+  }
+
+  if (empty()) {
+    std::cerr << path << ": no sector found" << std::endl;
+    return EINVAL;
+  }
+  return 0;
+}
+
+void Obstruction::clear(void)
+{
+  start_.clear();
+  end_.clear();
+  from_.clear();
+  width_.clear();
+  elev_.clear();
+  loss_.clear();
+}
+
+void Obstruction::apply(double t, Constellation::Sky & sky) const
+{
+  for (std::size_t k = 0; k < start_.size(); ++k) {
+    if (t < start_[k] || t >= end_[k]) continue;
+    for (std::size_t i = 0; i < sky.n_; ++i) {
+      double d = sky.azim_[i] - from_[k];
+      d += 360.0 * (d < 0);
+      double inside = (d < width_[k]) & (sky.elev_[i] < elev_[k]);
+      sky.cno_[i] -= loss_[k] * inside;
+    }
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef FAKE_GNSS_SIMULATOR_OBSTRUCTION_H_
+#define FAKE_GNSS_SIMULATOR_OBSTRUCTION_H_
+
+/**
+ * @file obstruction.h
+ * @brief Scripted sectors of sky attenuating or blocking signals, as urban canyons and tunnels do
+ */
+
+#include <constellation.h>
+#include <vector>
+
+class Obstruction
+{
+public:
+  /**
+   * @brief Load sectors from CSV file
+   * @param[in] path path of file with lines of start time [s], end time [s], azimuth from [deg],
+   *                 azimuth to [deg], elevation below which signals are obstructed [deg], and
+   *                 optionally attenuation [dB], signals being blocked without it
+   * @return 0 on success, otherwise error
+   * @note Rows are read by CsvReader::next(), which skips a header
+   */
+  int load(const char * path);
+
+  /**
+   * @brief Remove all sectors
+   */
+  void clear(void);
+
+  /**
+   * @brief Check if no sector is loaded
+   * @return true if no sector is loaded
+   */
+  bool empty(void) const { return start_.empty(); }
+
+  /**
+   * @brief Attenuate signals of satellites behind sectors active at a time
+   * @param[in] t time since the start of simulation, or of the trajectory [s]
+   * @param[inout] sky geometry, of which C/N0 is reduced
+   */
+  void apply(double t, Constellation::Sky & sky) const;
+
+private:
+  std::vector<double> start_;  //!< @brief start times [s]
+  std::vector<double> end_;    //!< @brief end times [s]
+  std::vector<double> from_;   //!< @brief azimuths where sectors start, clockwise [deg]
+  std::vector<double> width_;  //!< @brief widths of sectors in azimuth [deg]
+  std::vector<double> elev_;   //!< @brief elevations below which signals are obstructed [deg]
+  std::vector<double> loss_;   //!< @brief attenuations [dB]
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_OBSTRUCTION_H_
@@ -0,0 +1,95 @@
+/**
+ * @file raw_model.cpp
+ * @brief Pseudorange, carrier phase and Doppler measurements with receiver clock and noise
+ */
+
+#include <raw_model.h>
+#include <algorithm>
+#include <cmath>
+
+static constexpr double SPEED_OF_LIGHT = 299792458.0;  //!< @brief speed of light [m/s]
+static constexpr double L1 = 1575.42e6;                //!< @brief frequency of iono delay [Hz]
+static constexpr double IONO_ZENITH = 4.0;             //!< @brief iono delay at zenith on L1 [m]
+static constexpr double TROPO_ZENITH = 2.4;            //!< @brief tropo delay at zenith [m]
+static constexpr double CLOCK_DRIFT = 2e-7;            //!< @brief receiver clock drift [s/s]
+static constexpr double CLOCK_WANDER = 1e-10;          //!< @brief drift random walk [s/s/sqrt(s)]
+static constexpr double CLOCK_LIMIT = 0.5e-3;          //!< @brief bias limit, 1 ms jumps [s]
+static constexpr double CNO_REFERENCE = 45.0;          //!< @brief C/N0 of noise below [dBHz]
+static constexpr double PR_NOISE = 0.3;                //!< @brief pseudorange noise [m]
+static constexpr double CP_NOISE = 0.005;              //!< @brief carrier phase noise [cycles]
+static constexpr double DO_NOISE = 0.05;               //!< @brief Doppler noise [Hz]
+static constexpr uint16_t MAX_LOCKTIME = 64500;        //!< @brief locktime saturates [ms]
+
+/**
+ * @brief Encode standard deviation in steps of powers of two
+ * @param[in] sigma standard deviation
+ * @param[in] unit value of step 0
+ * @return step, up to 15
+ */
+static uint8_t stdevStep(double sigma, double unit)
+{
+  return std::min(std::max(std::ceil(std::log2(sigma / unit)), 0.0), 15.0);
+}
+
+RawModel::RawModel() : normal_(0.0, 1.0) { reset(1); }
+
+void RawModel::reset(uint32_t seed)
+{
+  rng_.seed(seed);
+  normal_.reset();
+  t_ = 0;
+  bias_ = 0;
+  drift_ = CLOCK_DRIFT;
+  std::fill(tracking_, tracking_ + Constellation::MAX_SATELLITES, false);
+}
+
+void RawModel::measure(
+  double t, const Constellation & c, const Constellation::Sky & sky, Raw & raw)
+{
+  // Free running clock is kept within 0.5 ms by jumps of 1 ms
+  double dt = (t_ > 0 && t > t_) ? t - t_ : 0;
+  t_ = t;
+  drift_ += CLOCK_WANDER * std::sqrt(dt) * normal_(rng_);
+  bias_ += drift_ * dt;
+  raw.clockReset_ = std::fabs(bias_) > CLOCK_LIMIT;
+  if (raw.clockReset_) bias_ -= std::copysign(1e-3, bias_);
+
+  raw.n_ = 0;
+  for (std::size_t i = 0; i < sky.n_; ++i) {
+    if (!sky.visible_[i]) {
+      tracking_[i] = false;
+      continue;
+    }
+    if (!tracking_[i]) {
+      // Carrier phase starts near pseudorange with an arbitrary number of cycles
+      tracking_[i] = true;
+      since_[i] = t;
+      ambiguity_[i] = std::round(normal_(rng_) * 100.0);
+    }
+
+    // Iono delays code and advances carrier, more at low elevation and low frequency
+    double f = c.frequency(i);
+    double lambda = SPEED_OF_LIGHT / f;
+    double el = sky.elev_[i] / 180.0;
+    double iono = IONO_ZENITH * (L1 / f) * (L1 / f) * (1.0 + 16.0 * std::pow(0.53 - el, 3));
+    double tropo = TROPO_ZENITH / std::sin(el * M_PI);
+    double range = sky.range_[i] + SPEED_OF_LIGHT * (bias_ - sky.clock_[i]) + tropo;
+
+    // Noise grows as C/N0 falls
+    double scale = std::pow(10.0, (CNO_REFERENCE - sky.cno_[i]) / 20.0);
+    double pr_sigma = PR_NOISE * scale;
+    double cp_sigma = CP_NOISE * scale;
+    double do_sigma = DO_NOISE * scale;
+
+    std::size_t k = raw.n_++;
+    raw.index_[k] = i;
+    raw.prMes_[k] = range + iono + pr_sigma * normal_(rng_);
+    raw.cpMes_[k] = (range - iono) / lambda + ambiguity_[i] + cp_sigma * normal_(rng_);
+    raw.doMes_[k] = -(sky.rate_[i] + SPEED_OF_LIGHT * drift_) / lambda + do_sigma * normal_(rng_);
+    raw.locktime_[k] = std::min<double>((t - since_[i]) * 1000.0, MAX_LOCKTIME);
+    raw.cno_[k] = std::lround(std::max(sky.cno_[i], 0.0));
+    raw.prStdev_[k] = stdevStep(pr_sigma, 0.01);
+    raw.cpStdev_[k] = std::min(std::lround(cp_sigma / 0.004), 15L);
+    raw.doStdev_[k] = stdevStep(do_sigma, 0.002);
+  }
+}
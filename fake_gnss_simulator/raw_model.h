@@ -0,0 +1,66 @@
+#ifndef FAKE_GNSS_SIMULATOR_RAW_MODEL_H_
+#define FAKE_GNSS_SIMULATOR_RAW_MODEL_H_
+
+/**
+ * @file raw_model.h
+ * @brief Pseudorange, carrier phase and Doppler measurements with receiver clock and noise
+ */
+
+#include <constellation.h>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+class RawModel
+{
+public:
+  /**
+   * @brief Measurements of satellites tracked at an epoch, as in UBX-RXM-RAWX
+   */
+  struct Raw
+  {
+    std::size_t n_;                                     //!< @brief number of measurements
+    uint8_t index_[Constellation::MAX_SATELLITES];      //!< @brief index of satellite
+    double prMes_[Constellation::MAX_SATELLITES];       //!< @brief pseudorange [m]
+    double cpMes_[Constellation::MAX_SATELLITES];       //!< @brief carrier phase [cycles]
+    float doMes_[Constellation::MAX_SATELLITES];        //!< @brief Doppler [Hz]
+    uint16_t locktime_[Constellation::MAX_SATELLITES];  //!< @brief carrier phase locktime [ms]
+    uint8_t cno_[Constellation::MAX_SATELLITES];        //!< @brief carrier to noise ratio [dBHz]
+    uint8_t prStdev_[Constellation::MAX_SATELLITES];    //!< @brief 0.01 m * 2^n
+    uint8_t cpStdev_[Constellation::MAX_SATELLITES];    //!< @brief 0.004 cycles * n
+    uint8_t doStdev_[Constellation::MAX_SATELLITES];    //!< @brief 0.002 Hz * 2^n
+    bool clockReset_;                                   //!< @brief clock jumped by 1 ms
+  };
+
+  /**
+   * @brief Constructor
+   */
+  RawModel();
+
+  /**
+   * @brief Start receiver clock and lose lock of all satellites
+   * @param[in] seed seed of noise, same measurements for the same seed
+   */
+  void reset(uint32_t seed);
+
+  /**
+   * @brief Measure satellites above elevation mask
+   * @param[in] t GPS time of reception [s since 1980-01-06]
+   * @param[in] c constellation
+   * @param[in] sky geometry of constellation at t
+   * @param[out] raw measurements
+   */
+  void measure(double t, const Constellation & c, const Constellation::Sky & sky, Raw & raw);
+
+private:
+  std::mt19937 rng_;                                 //!< @brief noise generator
+  std::normal_distribution<double> normal_;          //!< @brief standard normal distribution
+  double t_;                                         //!< @brief time of the last measurement [s]
+  double bias_;                                      //!< @brief receiver clock bias [s]
+  double drift_;                                     //!< @brief receiver clock drift [s/s]
+  bool tracking_[Constellation::MAX_SATELLITES];     //!< @brief satellite is tracked
+  double since_[Constellation::MAX_SATELLITES];      //!< @brief time when tracking started [s]
+  double ambiguity_[Constellation::MAX_SATELLITES];  //!< @brief integer ambiguity [cycles]
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_RAW_MODEL_H_
@@ -0,0 +1,33 @@
+/**
+ * @file rtcm3_crc.cpp
+ * @brief CRC-24Q of RTCM3 frames
+ */
+
+#include <rtcm3_crc.h>
+
+static constexpr uint32_t POLYNOMIAL = 0x864CFB;  //!< @brief generator of CRC-24Q
+
+/**
+ * @brief CRC of every byte value, one table lookup replacing eight shifts per byte
+ */
+static const struct Table
+{
+  uint32_t crc_[256];  //!< @brief CRC by byte value
+
+  constexpr Table() : crc_()
+  {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i << 16;
+      for (int j = 0; j < 8; ++j) c = (c << 1) ^ ((c & 0x800000) ? POLYNOMIAL : 0);
+      crc_[i] = c & 0xFFFFFF;
+    }
+  }
+} table;
+
+uint32_t rtcm3Crc(const uint8_t * data, std::size_t size, uint32_t crc)
+{
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = ((crc << 8) & 0xFFFFFF) ^ table.crc_[(crc >> 16) ^ data[i]];
+  }
+  return crc;
+}
@@ -0,0 +1,22 @@
+#ifndef FAKE_GNSS_SIMULATOR_RTCM3_CRC_H_
+#define FAKE_GNSS_SIMULATOR_RTCM3_CRC_H_
+
+/**
+ * @file rtcm3_crc.h
+ * @brief CRC-24Q of RTCM3 frames
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Accumulate CRC-24Q over a range
+ * @param[in] data start of range
+ * @param[in] size size of range
+ * @param[in] crc CRC of preceding data, 0 at the start of frame
+ * @return CRC in the lower 24 bits
+ * @note Ranges may be accumulated piecewise, e.g. across the end of a ring buffer
+ */
+uint32_t rtcm3Crc(const uint8_t * data, std::size_t size, uint32_t crc = 0);
+
+#endif  // FAKE_GNSS_SIMULATOR_RTCM3_CRC_H_
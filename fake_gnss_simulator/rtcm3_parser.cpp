@@ -0,0 +1,110 @@
+/**
+ * @file rtcm3_parser.cpp
+ * @brief Streaming RTCM3 frame parser
+ */
+
+#include <rtcm3_crc.h>
+#include <rtcm3_parser.h>
+#include <algorithm>
+#include <cstring>
+
+static constexpr uint8_t PREAMBLE = 0xD3;
+static constexpr std::size_t HEADER_SIZE = 3;
+static constexpr std::size_t CRC_SIZE = 3;
+
+Rtcm3Parser::Rtcm3Parser() { reset(); }
+
+void Rtcm3Parser::reset(void)
+{
+  head_ = 0;
+  tail_ = 0;
+  length_ = 0;
+  state_ = WaitPreamble;
+  synced_ = false;
+  crc_failures_ = 0;
+}
+
+void Rtcm3Parser::feed(const uint8_t * data, std::size_t size)
+{
+  for (std::size_t i = 0; i < size; ++i) {
+    if (available() == BUFFER_SIZE) {
+      // Overflow, the current frame is lost
+      ++tail_;
+      state_ = WaitPreamble;
+      synced_ = false;
+    }
+    buf_[head_ & (BUFFER_SIZE - 1)] = data[i];
+    ++head_;
+  }
+}
+
+bool Rtcm3Parser::next(const uint8_t *& frame, std::size_t & size)
+{
+  while (true) {
+    switch (state_) {
+      case WaitPreamble:
+        // Six reserved bits after the preamble are zero
+        while (available() >= 2 && (at(0) != PREAMBLE || (at(1) & 0xFC) != 0)) {
+          ++tail_;
+          synced_ = false;
+        }
+        if (available() < 2) return false;
+        state_ = WaitHeader;
+        break;
+
+      case WaitHeader:
+        if (available() < HEADER_SIZE) return false;
+        length_ = ((at(1) & 0x03) << 8) | at(2);
+        state_ = WaitFrame;
+        break;
+
+      case WaitFrame: {
+        std::size_t n = HEADER_SIZE + length_ + CRC_SIZE;
+        if (available() < n) return false;
+
+        // Copy frame out of the ring buffer in at most two pieces
+        std::size_t start = tail_ & (BUFFER_SIZE - 1);
+        std::size_t first = std::min(n, BUFFER_SIZE - start);
+        memcpy(frame_, &buf_[start], first);
+        memcpy(frame_ + first, &buf_[0], n - first);
+
+        // CRC over header and payload
+        uint32_t crc = (frame_[n - 3] << 16) | (frame_[n - 2] << 8) | frame_[n - 1];
+        if (rtcm3Crc(frame_, n - CRC_SIZE) != crc) {
+          // Preamble may have been found in other data, search again after it
+          crc_failures_ += synced_;
+          skip(1);
+          break;
+        }
+
+        tail_ += n;
+        state_ = WaitPreamble;
+        synced_ = true;
+        frame = frame_;
+        size = n;
+        return true;
+      }
+    }
+  }
+}
+
+uint16_t Rtcm3Parser::messageType(const uint8_t * frame)
+{
+  std::size_t length = ((frame[1] & 0x03) << 8) | frame[2];
+  if (length < 2) return 0;
+  return (frame[3] << 4) | (frame[4] >> 4);
+}
+
+uint16_t Rtcm3Parser::stationId(const uint8_t * frame)
+{
+  std::size_t length = ((frame[1] & 0x03) << 8) | frame[2];
+  if (length < 3) return 0;
+  return ((frame[4] & 0x0F) << 8) | frame[5];
+}
+
+void Rtcm3Parser::skip(std::size_t size)
+{
+  tail_ += size;
+  state_ = WaitPreamble;
+  synced_ = false;
+}
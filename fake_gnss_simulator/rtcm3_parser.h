@@ -0,0 +1,103 @@
+#ifndef FAKE_GNSS_SIMULATOR_RTCM3_PARSER_H_
+#define FAKE_GNSS_SIMULATOR_RTCM3_PARSER_H_
+
+/**
+ * @file rtcm3_parser.h
+ * @brief Streaming RTCM3 frame parser
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+class Rtcm3Parser
+{
+public:
+  static constexpr std::size_t BUFFER_SIZE = 4096;  //!< @brief ring buffer size, power of two
+  static constexpr std::size_t MAX_PAYLOAD = 1023;  //!< @brief largest payload of 10-bit length
+
+  /**
+   * @brief Constructor
+   */
+  Rtcm3Parser();
+
+  /**
+   * @brief Discard buffered data and clear statistics
+   */
+  void reset(void);
+
+  /**
+   * @brief Append received data
+   * @param[in] data received data
+   * @param[in] size size of data
+   * @note The oldest data is discarded if the ring buffer overflows
+   */
+  void feed(const uint8_t * data, std::size_t size);
+
+  /**
+   * @brief Take the next complete frame with valid CRC
+   * @param[out] frame start of frame, valid until the next call
+   * @param[out] size size of frame
+   * @return true if a frame is available
+   */
+  bool next(const uint8_t *& frame, std::size_t & size);
+
+  /**
+   * @brief Get number of frames rejected by CRC, not counting preambles found in other data
+   * @return number of frames rejected since reset
+   */
+  uint32_t crcFailures(void) const { return crc_failures_; }
+
+  /**
+   * @brief Get message type of frame
+   * @param[in] frame frame
+   * @return message type, 0 if the payload is too short to hold one
+   */
+  static uint16_t messageType(const uint8_t * frame);
+
+  /**
+   * @brief Get reference station ID following the message type, as most messages have
+   * @param[in] frame frame
+   * @return reference station ID, 0 if the payload is too short to hold one
+   */
+  static uint16_t stationId(const uint8_t * frame);
+
+private:
+  /**
+   * @brief Parser state
+   */
+  enum State {
+    WaitPreamble = 0,  //!< @brief waiting for 0xD3 and zero reserved bits
+    WaitHeader,        //!< @brief waiting for length
+    WaitFrame,         //!< @brief waiting for payload and CRC
+  };
+
+  /**
+   * @brief Get buffered byte
+   * @param[in] offset offset from the start of the current frame
+   * @return byte
+   */
+  uint8_t at(std::size_t offset) const { return buf_[(tail_ + offset) & (BUFFER_SIZE - 1)]; }
+
+  /**
+   * @brief Get number of buffered bytes
+   * @return number of buffered bytes
+   */
+  std::size_t available(void) const { return head_ - tail_; }
+
+  /**
+   * @brief Drop bytes from the start of the current frame and search for the next preamble
+   * @param[in] size number of bytes to drop
+   */
+  void skip(std::size_t size);
+
+  uint8_t buf_[BUFFER_SIZE];        //!< @brief ring buffer
+  uint8_t frame_[MAX_PAYLOAD + 6];  //!< @brief frame copied out of the ring buffer
+  std::size_t head_;                //!< @brief write position
+  std::size_t tail_;                //!< @brief start of the current frame
+  std::size_t length_;              //!< @brief payload length of the current frame
+  State state_;                     //!< @brief parser state
+  bool synced_;                     //!< @brief current frame starts where a valid one ended
+  uint32_t crc_failures_;           //!< @brief frames rejected by CRC while synced
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_RTCM3_PARSER_H_
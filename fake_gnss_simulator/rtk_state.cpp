@@ -0,0 +1,86 @@
+/**
+ * @file rtk_state.cpp
+ * @brief Carrier phase solution converging while RTCM3 corrections keep arriving
+ */
+
+#include <rtk_state.h>
+#include <cstring>
+
+RtkState::RtkState()
+{
+  setTimes(5.0, 20.0, 10.0);
+  reset();
+}
+
+void RtkState::setTimes(double float_time, double fix_time, double timeout)
+{
+  auto seconds = [](double s) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+  };
+  float_time_ = seconds(float_time);
+  fix_time_ = seconds(fix_time);
+  timeout_ = seconds(timeout);
+}
+
+void RtkState::reset(void)
+{
+  observed_ = false;
+  referenced_ = false;
+  converging_ = false;
+  station_ = 0;
+  memset(counts_, 0, sizeof(counts_));
+}
+
+bool RtkState::receive(uint16_t type, uint16_t station, Clock::time_point now)
+{
+  if (type < MAX_TYPES) ++counts_[type];
+
+  if (isReference(type)) {
+    referenced_ = true;
+    return true;
+  }
+  if (!isObservation(type)) return false;
+
+  // Observations of another station or after a gap are corrections starting over
+  if (observed_ && (station != station_ || now - observation_time_ > timeout_)) {
+    converging_ = false;
+  }
+  observed_ = true;
+  observation_time_ = now;
+  station_ = station;
+  return true;
+}
+
+RtkState::Solution RtkState::update(Clock::time_point now, bool fix)
+{
+  // Both observations and the reference point are needed, and observations must be recent
+  if (!fix || !observed_ || !referenced_ || now - observation_time_ > timeout_) {
+    converging_ = false;
+    return RTK_NONE;
+  }
+  if (!converging_) {
+    converging_ = true;
+    converge_time_ = now;
+  }
+
+  Clock::duration t = now - converge_time_;
+  if (t >= fix_time_) return RTK_FIXED;
+  if (t >= float_time_) return RTK_FLOAT;
+  return RTK_DGNSS;
+}
+
+double RtkState::age(Clock::time_point now) const
+{
+  if (!observed_) return -1.0;
+  return std::chrono::duration<double>(now - observation_time_).count();
+}
+
+bool RtkState::isObservation(uint16_t type)
+{
+  // Legacy GPS 1001-1004 and GLONASS 1009-1012, MSM1-7 of GPS, GLONASS, Galileo, SBAS, QZSS,
+  // BeiDou and NavIC in 1071-1137
+  if ((type >= 1001 && type <= 1004) || (type >= 1009 && type <= 1012)) return true;
+  return type >= 1071 && type <= 1137 && type % 10 >= 1 && type % 10 <= 7;
+}
+
+bool RtkState::isReference(uint16_t type) { return type == 1005 || type == 1006; }
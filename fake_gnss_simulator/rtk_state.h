@@ -0,0 +1,111 @@
+#ifndef FAKE_GNSS_SIMULATOR_RTK_STATE_H_
+#define FAKE_GNSS_SIMULATOR_RTK_STATE_H_
+
+/**
+ * @file rtk_state.h
+ * @brief Carrier phase solution converging while RTCM3 corrections keep arriving
+ */
+
+#include <chrono>
+#include <cstdint>
+
+class RtkState
+{
+public:
+  typedef std::chrono::steady_clock Clock;  //!< @brief monotonic clock
+
+  static constexpr uint16_t MAX_TYPES = 4096;  //!< @brief message types of 12 bits
+
+  /**
+   * @brief Solution, in order of accuracy
+   */
+  enum Solution {
+    RTK_NONE = 0,  //!< @brief no corrections
+    RTK_DGNSS,     //!< @brief code corrections, carrier phase converging
+    RTK_FLOAT,     //!< @brief carrier phase with float ambiguities
+    RTK_FIXED,     //!< @brief carrier phase with fixed ambiguities
+  };
+
+  /**
+   * @brief Constructor
+   */
+  RtkState();
+
+  /**
+   * @brief Set times of transitions
+   * @param[in] float_time time from the first corrections to float solution [s]
+   * @param[in] fix_time time from the first corrections to fixed solution [s]
+   * @param[in] timeout age of observations after which corrections are lost [s]
+   */
+  void setTimes(double float_time, double fix_time, double timeout);
+
+  /**
+   * @brief Forget corrections received and clear statistics
+   */
+  void reset(void);
+
+  /**
+   * @brief Record received message
+   * @param[in] type message type
+   * @param[in] station reference station ID
+   * @param[in] now time of reception
+   * @return true if the message is used in the solution
+   */
+  bool receive(uint16_t type, uint16_t station, Clock::time_point now);
+
+  /**
+   * @brief Update solution at a navigation epoch
+   * @param[in] now time of epoch
+   * @param[in] fix navigation solution has a fix, convergence restarting without it
+   * @return solution
+   */
+  Solution update(Clock::time_point now, bool fix);
+
+  /**
+   * @brief Get age of the last observations
+   * @param[in] now current time
+   * @return age [s], negative if none was received
+   */
+  double age(Clock::time_point now) const;
+
+  /**
+   * @brief Get reference station ID of the last observations
+   * @return reference station ID
+   */
+  uint16_t station(void) const { return station_; }
+
+  /**
+   * @brief Get number of messages received by type
+   * @param[in] type message type
+   * @return number of messages since reset
+   */
+  uint32_t count(uint16_t type) const { return (type < MAX_TYPES) ? counts_[type] : 0; }
+
+private:
+  /**
+   * @brief Check if message carries observations, legacy or MSM of any GNSS
+   * @param[in] type message type
+   * @return true if observations
+   */
+  static bool isObservation(uint16_t type);
+
+  /**
+   * @brief Check if message carries the antenna reference point of the station
+   * @param[in] type message type
+   * @return true if reference point
+   */
+  static bool isReference(uint16_t type);
+
+  Clock::duration float_time_;          //!< @brief time to float solution
+  Clock::duration fix_time_;            //!< @brief time to fixed solution
+  Clock::duration timeout_;             //!< @brief age at which corrections are lost
+  bool observed_;                       //!< @brief observations were received
+  bool referenced_;                     //!< @brief reference point was received
+  bool converging_;                     //!< @brief convergence started
+  Clock::time_point observation_time_;  //!< @brief time of the last observations
+  Clock::time_point converge_time_;     //!< @brief start of convergence
+  uint16_t station_;                    //!< @brief reference station of the last observations
+  uint32_t counts_[MAX_TYPES];          //!< @brief messages received by type
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_RTK_STATE_H_
@@ -0,0 +1,92 @@
+#ifndef FAKE_GNSS_SIMULATOR_SEQLOCK_H_
+#define FAKE_GNSS_SIMULATOR_SEQLOCK_H_
+
+/**
+ * @file seqlock.h
+ * @brief Sequence lock publishing a value to readers which never block
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Value readable without locks while a writer updates it
+ * @tparam T trivially copyable value
+ * @note Writers must be serialized by the caller
+ */
+template <typename T>
+class SeqLock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs trivially copyable value");
+
+public:
+  /**
+   * @brief Constructor
+   * @param[in] value initial value
+   */
+  explicit SeqLock(const T & value = T()) : seq_(0) { write(value); }
+
+  /**
+   * @brief Publish value
+   * @param[in] value value
+   */
+  void store(const T & value)
+  {
+    // Odd sequence tells readers that words are being replaced
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    write(value);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Read consistent value, retrying while a writer is in progress
+   * @return value
+   */
+  T load(void) const
+  {
+    uint64_t words[WORDS];
+    uint32_t seq;
+    do {
+      seq = seq_.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < WORDS; ++i) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != seq_.load(std::memory_order_relaxed));
+
+    T value;
+    memcpy(&value, words, sizeof(value));
+    return value;
+  }
+
+  /**
+   * @brief Get version, incremented on every store
+   * @return version
+   */
+  uint32_t version(void) const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+  static constexpr std::size_t WORDS = (sizeof(T) + 7) / 8;  //!< @brief words holding value
+
+  /**
+   * @brief Copy value into words
+   * @param[in] value value
+   */
+  void write(const T & value)
+  {
+    uint64_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(value));
+    for (std::size_t i = 0; i < WORDS; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<uint32_t> seq_;           //!< @brief even when stable, odd while storing
+  std::atomic<uint64_t> words_[WORDS];  //!< @brief value, each word read without tearing
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_SEQLOCK_H_
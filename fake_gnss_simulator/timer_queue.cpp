@@ -0,0 +1,64 @@
+/**
+ * @file timer_queue.cpp
+ * @brief Periodic timers on absolute deadlines
+ */
+
+#include <timer_queue.h>
+
+void TimerQueue::schedule(uint16_t key, Clock::duration period, Clock::time_point now)
+{
+  Timer & t = timers_[key];
+  t.period_ = period;
+  ++t.generation_;
+
+  if (period > Clock::duration::zero()) {
+    heap_.push({now + period, key, t.generation_});
+  }
+}
+
+void TimerQueue::clear(void)
+{
+  heap_ = decltype(heap_)();
+  timers_.clear();
+}
+
+bool TimerQueue::empty(void)
+{
+  purge();
+  return heap_.empty();
+}
+
+TimerQueue::Clock::time_point TimerQueue::next(void)
+{
+  purge();
+  return heap_.top().deadline_;
+}
+
+bool TimerQueue::pop(Clock::time_point now, uint16_t & key)
+{
+  purge();
+  if (heap_.empty() || heap_.top().deadline_ > now) return false;
+
+  Entry e = heap_.top();
+  heap_.pop();
+
+  // Next deadline is based on the previous one so that the rate does not drift,
+  // but missed periods are skipped instead of being sent in a burst
+  const Timer & t = timers_[e.key_];
+  e.deadline_ += t.period_;
+  if (e.deadline_ <= now) e.deadline_ = now + t.period_;
+  heap_.push(e);
+
+  key = e.key_;
+  return true;
+}
+
+void TimerQueue::purge(void)
+{
+  while (!heap_.empty()) {
+    const Entry & e = heap_.top();
+    auto it = timers_.find(e.key_);
+    if (it != timers_.end() && it->second.generation_ == e.generation_) break;
+    heap_.pop();
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef FAKE_GNSS_SIMULATOR_TIMER_QUEUE_H_
+#define FAKE_GNSS_SIMULATOR_TIMER_QUEUE_H_
+
+/**
+ * @file timer_queue.h
+ * @brief Periodic timers on absolute deadlines
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <queue>
+#include <vector>
+
+class TimerQueue
+{
+public:
+  typedef std::chrono::steady_clock Clock;  //!< @brief monotonic clock
+
+  /**
+   * @brief Schedule periodic timer, replacing the previous one with the same key
+   * @param[in] key timer key
+   * @param[in] period period, zero to cancel timer
+   * @param[in] now current time, the first deadline is one period later
+   */
+  void schedule(uint16_t key, Clock::duration period, Clock::time_point now);
+
+  /**
+   * @brief Cancel all timers
+   */
+  void clear(void);
+
+  /**
+   * @brief Check if no timer is scheduled
+   * @return true if no timer is scheduled
+   */
+  bool empty(void);
+
+  /**
+   * @brief Get the earliest deadline
+   * @return the earliest deadline, undefined if empty
+   */
+  Clock::time_point next(void);
+
+  /**
+   * @brief Take one expired timer and schedule its next deadline
+   * @param[in] now current time
+   * @param[out] key key of expired timer
+   * @return true if a timer expired
+   */
+  bool pop(Clock::time_point now, uint16_t & key);
+
+private:
+  /**
+   * @brief Deadline in heap
+   */
+  struct Entry
+  {
+    Clock::time_point deadline_;  //!< @brief absolute deadline
+    uint16_t key_;                //!< @brief timer key
+    uint32_t generation_;         //!< @brief generation of timer when the entry was pushed
+
+    bool operator>(const Entry & value) const { return deadline_ > value.deadline_; }
+  };
+
+  /**
+   * @brief Timer state
+   */
+  struct Timer
+  {
+    Clock::duration period_;  //!< @brief period
+    uint32_t generation_;     //!< @brief incremented whenever timer is rescheduled
+  };
+
+  /**
+   * @brief Drop heap entries of cancelled or rescheduled timers
+   */
+  void purge(void);
+
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;  //!< @brief min-heap
+  std::map<uint16_t, Timer> timers_;  //!< @brief timers by key
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_TIMER_QUEUE_H_
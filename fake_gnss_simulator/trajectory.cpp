@@ -0,0 +1,98 @@
+/**
+ * @file trajectory.cpp
+ * @brief Track of waypoints sampled at navigation epochs
+ */
+
+#include <csv_reader.h>
+#include <geodesy.h>
+#include <trajectory.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <iostream>
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+
+int Trajectory::load(const char * path)
+{
+  clear();
+
+  CsvReader csv;
+  int ret = csv.open(path);
+  if (ret != 0) return ret;
+
+  std::vector<double> lat;
+  std::vector<double> lon;
+  std::vector<double> h;
+  double v[4];
+  while (csv.next(v, 4, 4) > 0) {
+    if (!t_.empty() && v[0] <= t_.back()) {
+      csv.reject("time must increase");
+      continue;
+    }
+    t_.push_back(v[0]);
+    lat.push_back(v[1] * DEG_TO_RAD);
+    lon.push_back(v[2] * DEG_TO_RAD);
+    h.push_back(v[3]);
+  }
+
+  if (t_.size() < 2) {
+    std::cerr << path << ": at least two waypoints are needed" << std::endl;
+    clear();
+    return EINVAL;
+  }
+
+  // Interpolate in ECEF, which is converted once for all waypoints
+  double t0 = t_.front();
+  for (auto & t : t_) t -= t0;
+  x_.resize(t_.size());
+  y_.resize(t_.size());
+  z_.resize(t_.size());
+  geodeticToEcef(&lat[0], &lon[0], &h[0], t_.size(), &x_[0], &y_[0], &z_[0]);
+
+  return 0;
+}
+
+void Trajectory::clear(void)
+{
+  t_.clear();
+  x_.clear();
+  y_.clear();
+  z_.clear();
+}
+
+void Trajectory::sample(const double * t, std::size_t n, Point * out) const
+{
+  double x[BATCH], y[BATCH], z[BATCH];
+  double vx[BATCH], vy[BATCH], vz[BATCH];
+  double lat[BATCH], lon[BATCH], h[BATCH];
+  double vn[BATCH], ve[BATCH], vd[BATCH];
+  double duration = t_.back();
+
+  for (std::size_t base = 0; base < n; base += BATCH) {
+    std::size_t m = std::min(BATCH, n - base);
+
+    // Position and velocity of each sample on its segment
+    for (std::size_t i = 0; i < m; ++i) {
+      double tt = std::fmod(t[base + i], duration);
+      if (tt < 0) tt += duration;
+      std::size_t k = std::upper_bound(t_.begin(), t_.end(), tt) - t_.begin();
+      k = std::min(std::max<std::size_t>(k, 1), t_.size() - 1);
+      double dt = t_[k] - t_[k - 1];
+      double r = (tt - t_[k - 1]) / dt;
+      vx[i] = (x_[k] - x_[k - 1]) / dt;
+      vy[i] = (y_[k] - y_[k - 1]) / dt;
+      vz[i] = (z_[k] - z_[k - 1]) / dt;
+      x[i] = x_[k - 1] + vx[i] * dt * r;
+      y[i] = y_[k - 1] + vy[i] * dt * r;
+      z[i] = z_[k - 1] + vz[i] * dt * r;
+    }
+
+    ecefToGeodetic(x, y, z, m, lat, lon, h);
+    ecefToNed(lat, lon, vx, vy, vz, m, vn, ve, vd);
+
+    for (std::size_t i = 0; i < m; ++i) {
+      out[base + i] = {lat[i] / DEG_TO_RAD, lon[i] / DEG_TO_RAD, h[i], vn[i], ve[i], vd[i]};
+    }
+  }
+}
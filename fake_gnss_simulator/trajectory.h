@@ -0,0 +1,71 @@
+#ifndef FAKE_GNSS_SIMULATOR_TRAJECTORY_H_
+#define FAKE_GNSS_SIMULATOR_TRAJECTORY_H_
+
+/**
+ * @file trajectory.h
+ * @brief Track of waypoints sampled at navigation epochs
+ */
+
+#include <cstddef>
+#include <vector>
+
+class Trajectory
+{
+public:
+  /**
+   * @brief State on track
+   */
+  struct Point
+  {
+    double lat_;     //!< @brief latitude [deg]
+    double lon_;     //!< @brief longitude [deg]
+    double height_;  //!< @brief height above ellipsoid [m]
+    double velN_;    //!< @brief north velocity [m/s]
+    double velE_;    //!< @brief east velocity [m/s]
+    double velD_;    //!< @brief down velocity [m/s]
+  };
+
+  /**
+   * @brief Load waypoints from CSV file
+   * @param[in] path path of file with lines of time [s], latitude [deg], longitude [deg] and
+   *                 height above ellipsoid [m]
+   * @return 0 on success, otherwise error
+   * @note Rows are read by CsvReader::next(), which skips a header
+   */
+  int load(const char * path);
+
+  /**
+   * @brief Remove all waypoints
+   */
+  void clear(void);
+
+  /**
+   * @brief Check if no track is loaded
+   * @return true if no track is loaded
+   */
+  bool empty(void) const { return t_.empty(); }
+
+  /**
+   * @brief Get time after which the track repeats
+   * @return time of the last waypoint since the first one [s], 0 if no track is loaded
+   */
+  double duration(void) const { return t_.empty() ? 0.0 : t_.back(); }
+
+  /**
+   * @brief Sample track, moving linearly between waypoints and repeating from the start at the end
+   * @param[in] t time since the first waypoint [s] for each sample
+   * @param[in] n number of samples
+   * @param[out] out state for each sample
+   */
+  void sample(const double * t, std::size_t n, Point * out) const;
+
+private:
+  static constexpr std::size_t BATCH = 64;  //!< @brief samples converted at a time
+
+  std::vector<double> t_;  //!< @brief time of waypoints relative to the first one [s]
+  std::vector<double> x_;  //!< @brief ECEF x of waypoints [m]
+  std::vector<double> y_;  //!< @brief ECEF y of waypoints [m]
+  std::vector<double> z_;  //!< @brief ECEF z of waypoints [m]
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_TRAJECTORY_H_
@@ -0,0 +1,93 @@
+/**
+ * @file uart_model.cpp
+ * @brief Transmit buffer of UART draining at the configured baud rate
+ */
+
+#include <uart_model.h>
+#include <algorithm>
+#include <cstring>
+
+UartModel::UartModel(std::size_t size) : buf_(size), byte_time_(Clock::duration::zero())
+{
+  reset();
+}
+
+void UartModel::setBaudrate(uint32_t baudrate)
+{
+  // Start, 8 data and stop bits
+  if (baudrate == 0) {
+    byte_time_ = Clock::duration::zero();
+  } else {
+    byte_time_ = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(10)) / baudrate;
+  }
+}
+
+void UartModel::reset(void)
+{
+  head_ = 0;
+  tail_ = 0;
+  free_ = 0;
+  line_time_ = Clock::time_point();
+  tx_bytes_ = 0;
+  rx_bytes_ = 0;
+  usage_ = 0;
+  peak_usage_ = 0;
+  overflow_ = false;
+}
+
+bool UartModel::push(const uint8_t * data, std::size_t size, Clock::time_point now)
+{
+  // Receivers drop whole messages which do not fit, bytes being written to port taking space
+  std::size_t used = head_ - tail_;
+  std::size_t reserved = head_ - free_;
+  if (reserved + size > buf_.size()) {
+    overflow_ = true;
+    return false;
+  }
+
+  // Idle line starts sending at once
+  if (used == 0) line_time_ = std::max(line_time_, now);
+
+  std::size_t offset = head_ & (buf_.size() - 1);
+  std::size_t n = std::min(size, buf_.size() - offset);
+  memcpy(&buf_[offset], data, n);
+  memcpy(&buf_[0], data + n, size - n);
+  head_ += size;
+
+  uint8_t usage = (reserved + size) * 100 / buf_.size();
+  usage_ = std::max(usage_, usage);
+  peak_usage_ = std::max(peak_usage_, usage);
+  return true;
+}
+
+std::size_t UartModel::pop(Clock::time_point now, const uint8_t *& data)
+{
+  // Line is silent until a stall ends, even without baud rate limit
+  std::size_t n = head_ - tail_;
+  if (now < line_time_) return 0;
+  if (byte_time_ > Clock::duration::zero()) {
+    n = std::min<std::size_t>(n, (now - line_time_) / byte_time_);
+  }
+
+  std::size_t offset = tail_ & (buf_.size() - 1);
+  n = std::min(n, buf_.size() - offset);
+  data = &buf_[offset];
+  tail_ += n;
+  line_time_ += byte_time_ * n;
+  tx_bytes_ += n;
+  return n;
+}
+
+void UartModel::report(Statistics & s)
+{
+  s.txPending_ = head_ - tail_;
+  s.txBytes_ = tx_bytes_;
+  s.txUsage_ = usage_;
+  s.txPeakUsage_ = peak_usage_;
+  s.rxBytes_ = rx_bytes_;
+  s.overflow_ = overflow_;
+
+  // Usage of the next period starts from what is still buffered
+  usage_ = (head_ - tail_) * 100 / buf_.size();
+  overflow_ = false;
+}
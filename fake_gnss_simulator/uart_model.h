@@ -0,0 +1,120 @@
+#ifndef FAKE_GNSS_SIMULATOR_UART_MODEL_H_
+#define FAKE_GNSS_SIMULATOR_UART_MODEL_H_
+
+/**
+ * @file uart_model.h
+ * @brief Transmit buffer of UART draining at the configured baud rate
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class UartModel
+{
+public:
+  typedef std::chrono::steady_clock Clock;  //!< @brief monotonic clock
+
+  static constexpr std::size_t TX_BUFFER_SIZE = 4096;  //!< @brief transmit buffer of UART
+
+  /**
+   * @brief Statistics reported by UBX-MON-COMMS
+   */
+  struct Statistics
+  {
+    uint16_t txPending_;   //!< @brief bytes waiting in transmit buffer
+    uint32_t txBytes_;     //!< @brief bytes ever sent
+    uint8_t txUsage_;      //!< @brief peak usage of transmit buffer since the last report [%]
+    uint8_t txPeakUsage_;  //!< @brief peak usage of transmit buffer ever [%]
+    uint32_t rxBytes_;     //!< @brief bytes ever received
+    bool overflow_;        //!< @brief messages dropped since the last report
+  };
+
+  /**
+   * @brief Constructor
+   * @param[in] size size of transmit buffer, power of two
+   */
+  explicit UartModel(std::size_t size = TX_BUFFER_SIZE);
+
+  /**
+   * @brief Set baud rate, 8N1 taking 10 bits per byte
+   * @param[in] baudrate baud rate, 0 for no limit
+   */
+  void setBaudrate(uint32_t baudrate);
+
+  /**
+   * @brief Discard buffered data and clear statistics
+   */
+  void reset(void);
+
+  /**
+   * @brief Queue message as a whole
+   * @param[in] data message
+   * @param[in] size size of message
+   * @param[in] now current time
+   * @return false if the message did not fit into transmit buffer, and was dropped
+   */
+  bool push(const uint8_t * data, std::size_t size, Clock::time_point now);
+
+  /**
+   * @brief Keep line silent for a while, as a receiver late with its output is
+   * @param[in] until time when bytes start leaving again
+   */
+  void stall(Clock::time_point until) { line_time_ = std::max(line_time_, until); }
+
+  /**
+   * @brief Take bytes which have left the line by now, keeping their space until released
+   * @param[in] now current time
+   * @param[out] data start of bytes, valid until they are released
+   * @return number of bytes, which may be fewer than due if buffer wraps around
+   */
+  std::size_t pop(Clock::time_point now, const uint8_t *& data);
+
+  /**
+   * @brief Free space of bytes taken by pop(), once they are written to port
+   * @param[in] size number of bytes, in the order they were taken
+   */
+  void release(std::size_t size) { free_ += size; }
+
+  /**
+   * @brief Check if bytes remain to be sent
+   * @return true if transmit buffer is not empty
+   */
+  bool pending(void) const { return head_ != tail_; }
+
+  /**
+   * @brief Get time to send a number of bytes
+   * @param[in] size number of bytes
+   * @return time on line
+   */
+  Clock::duration duration(std::size_t size) const { return byte_time_ * size; }
+
+  /**
+   * @brief Count received bytes
+   * @param[in] size number of bytes
+   */
+  void receive(std::size_t size) { rx_bytes_ += size; }
+
+  /**
+   * @brief Get statistics, and start a new reporting period
+   * @param[out] s statistics
+   */
+  void report(Statistics & s);
+
+private:
+  std::vector<uint8_t> buf_;     //!< @brief ring buffer
+  std::size_t head_;             //!< @brief write position
+  std::size_t tail_;             //!< @brief position of the next byte on line
+  std::size_t free_;             //!< @brief position of the first byte not yet released
+  Clock::duration byte_time_;    //!< @brief time of a byte on line, zero for no limit
+  Clock::time_point line_time_;  //!< @brief time when the byte at tail_ started on line
+  uint32_t tx_bytes_;            //!< @brief bytes ever sent
+  uint32_t rx_bytes_;            //!< @brief bytes ever received
+  uint8_t usage_;                //!< @brief peak usage since the last report [%]
+  uint8_t peak_usage_;           //!< @brief peak usage ever [%]
+  bool overflow_;                //!< @brief messages dropped since the last report
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_UART_MODEL_H_
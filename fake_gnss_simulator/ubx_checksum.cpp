@@ -0,0 +1,35 @@
+/**
+ * @file ubx_checksum.cpp
+ * @brief 8-bit Fletcher checksum of UBX frames
+ */
+
+#include <ubx_checksum.h>
+
+void ubxChecksum(const uint8_t * data, std::size_t size, uint8_t & ck_a, uint8_t & ck_b)
+{
+  // Sums only matter modulo 256, so 32-bit accumulators may wrap freely.
+  // A block of 16 bytes adds 16 * a plus the bytes weighted 16..1 to b,
+  // which removes the serial dependency of the byte-wise loop.
+  uint32_t a = ck_a;
+  uint32_t b = ck_b;
+  std::size_t i = 0;
+
+  for (; i + 16 <= size; i += 16) {
+    const uint8_t * p = data + i;
+    uint32_t s = 0;
+    uint32_t w = 0;
+    for (int j = 0; j < 16; ++j) {
+      s += p[j];
+      w += (16 - j) * p[j];
+    }
+    b += 16 * a + w;
+    a += s;
+  }
+  for (; i < size; ++i) {
+    a += data[i];
+    b += a;
+  }
+
+  ck_a = a;
+  ck_b = b;
+}
@@ -0,0 +1,39 @@
+#ifndef FAKE_GNSS_SIMULATOR_UBX_CHECKSUM_H_
+#define FAKE_GNSS_SIMULATOR_UBX_CHECKSUM_H_
+
+/**
+ * @file ubx_checksum.h
+ * @brief 8-bit Fletcher checksum of UBX frames
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Accumulate checksum over a range
+ * @param[in] data start of range
+ * @param[in] size size of range
+ * @param[inout] ck_a checksum a, 0 at the start of frame
+ * @param[inout] ck_b checksum b, 0 at the start of frame
+ * @note Ranges may be accumulated piecewise, e.g. across the end of a ring buffer
+ */
+void ubxChecksum(const uint8_t * data, std::size_t size, uint8_t & ck_a, uint8_t & ck_b);
+
+/**
+ * @brief Patch checksum after one byte in a checksummed range has changed
+ * @param[in] weight number of bytes from the changed one to the end of range, inclusive
+ * @param[in] old_value previous value of byte
+ * @param[in] new_value new value of byte
+ * @param[inout] ck_a checksum a
+ * @param[inout] ck_b checksum b
+ */
+inline void ubxChecksumPatch(
+  std::size_t weight, uint8_t old_value, uint8_t new_value, uint8_t & ck_a, uint8_t & ck_b)
+{
+  // The byte is added once to ck_a, and to ck_b once for every byte up to the end of range
+  uint8_t d = new_value - old_value;
+  ck_a = ck_a + d;
+  ck_b = ck_b + weight * d;
+}
+
+#endif  // FAKE_GNSS_SIMULATOR_UBX_CHECKSUM_H_
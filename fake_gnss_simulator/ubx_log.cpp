@@ -0,0 +1,141 @@
+/**
+ * @file ubx_log.cpp
+ * @brief Memory mapped UBX log indexed by message and epoch
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ubx_checksum.h>
+#include <ubx_log.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+static constexpr std::size_t HEADER_SIZE = 6;
+static constexpr std::size_t CHECKSUM_SIZE = 2;
+static constexpr uint32_t MS_PER_WEEK = 604800000;
+static constexpr std::chrono::milliseconds DEFAULT_INTERVAL(1000);
+
+UbxLog::UbxLog() : map_(nullptr), map_size_(0) {}
+
+UbxLog::~UbxLog() { close(); }
+
+int UbxLog::open(const char * path)
+{
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    int ret = errno;
+    std::cerr << path << ": " << strerror(ret) << std::endl;
+    return ret;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    std::cerr << path << ": empty log file" << std::endl;
+    return EINVAL;
+  }
+
+  map_ = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map_ == MAP_FAILED) {
+    int ret = errno;
+    map_ = nullptr;
+    std::cerr << path << ": " << strerror(ret) << std::endl;
+    return ret;
+  }
+  map_size_ = st.st_size;
+  madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+  // Index valid frames, skipping anything else such as NMEA sentences
+  const uint8_t * data = static_cast<const uint8_t *>(map_);
+  bool timed = false;
+  std::size_t i = 0;
+  while (i + HEADER_SIZE + CHECKSUM_SIZE <= map_size_) {
+    if (data[i] != 0xB5 || data[i + 1] != 0x62) {
+      ++i;
+      continue;
+    }
+    std::size_t n = HEADER_SIZE + (data[i + 4] | (data[i + 5] << 8)) + CHECKSUM_SIZE;
+    if (i + n > map_size_) break;
+
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    ubxChecksum(&data[i + 2], n - 2 - CHECKSUM_SIZE, ck_a, ck_b);
+    if (ck_a != data[i + n - 2] || ck_b != data[i + n - 1]) {
+      ++i;
+      continue;
+    }
+
+    Frame f = {&data[i], static_cast<uint16_t>(n),
+               static_cast<uint16_t>((data[i + 2] << 8) | data[i + 3])};
+
+    // A navigation message with another iTOW starts a new epoch,
+    // frames before the first one belong to the first epoch
+    uint32_t iTOW;
+    if (getITOW(f.data_, f.size_, iTOW)) {
+      if (epochs_.empty() || (timed && epochs_.back().iTOW_ != iTOW)) {
+        epochs_.push_back({iTOW, frames_.size(), frames_.size()});
+      }
+      epochs_.back().iTOW_ = iTOW;
+      timed = true;
+    } else if (epochs_.empty()) {
+      epochs_.push_back({0, frames_.size(), frames_.size()});
+    }
+
+    frames_by_key_[f.key_].push_back(frames_.size());
+    frames_.push_back(f);
+    epochs_.back().end_ = frames_.size();
+    i += n;
+  }
+
+  if (frames_.empty()) {
+    std::cerr << path << ": no UBX frame found" << std::endl;
+    close();
+    return EINVAL;
+  }
+
+  return 0;
+}
+
+void UbxLog::close(void)
+{
+  if (map_ != nullptr) munmap(map_, map_size_);
+  map_ = nullptr;
+  map_size_ = 0;
+  frames_.clear();
+  epochs_.clear();
+  frames_by_key_.clear();
+}
+
+std::vector<uint16_t> UbxLog::keys(void) const
+{
+  std::vector<uint16_t> keys;
+  for (const auto & k : frames_by_key_) keys.push_back(k.first);
+  return keys;
+}
+
+std::chrono::milliseconds UbxLog::interval(std::size_t i) const
+{
+  if (epochs_.size() < 2) return DEFAULT_INTERVAL;
+  if (i + 1 >= epochs_.size()) i = epochs_.size() - 2;
+
+  // iTOW wraps at the end of the week
+  uint32_t d = (epochs_[i + 1].iTOW_ + MS_PER_WEEK - epochs_[i].iTOW_) % MS_PER_WEEK;
+  return d > 0 ? std::chrono::milliseconds(d) : DEFAULT_INTERVAL;
+}
+
+bool UbxLog::getITOW(const uint8_t * frame, std::size_t size, uint32_t & iTOW)
+{
+  // Only UBX-NAV carries iTOW, at the start of payload except a few messages
+  if (frame[2] != 0x01) return false;
+  std::size_t offset = (frame[3] == 0x3B || frame[3] == 0x3C) ? 4 : 0;
+  if (size < HEADER_SIZE + offset + 4 + CHECKSUM_SIZE) return false;
+
+  memcpy(&iTOW, &frame[HEADER_SIZE + offset], sizeof(iTOW));
+  return true;
+}
@@ -0,0 +1,123 @@
+#ifndef FAKE_GNSS_SIMULATOR_UBX_LOG_H_
+#define FAKE_GNSS_SIMULATOR_UBX_LOG_H_
+
+/**
+ * @file ubx_log.h
+ * @brief Memory mapped UBX log indexed by message and epoch
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class UbxLog
+{
+public:
+  /**
+   * @brief Frame in log
+   */
+  struct Frame
+  {
+    const uint8_t * data_;  //!< @brief start of frame in mapping
+    uint16_t size_;         //!< @brief size of frame
+    uint16_t key_;          //!< @brief (class << 8) | id
+  };
+
+  /**
+   * @brief Frames sharing the same iTOW
+   */
+  struct Epoch
+  {
+    uint32_t iTOW_;      //!< @brief GPS time of week [ms]
+    std::size_t begin_;  //!< @brief index of the first frame
+    std::size_t end_;    //!< @brief index past the last frame
+  };
+
+  /**
+   * @brief Constructor
+   */
+  UbxLog();
+
+  /**
+   * @brief Destructor
+   */
+  ~UbxLog();
+
+  /**
+   * @brief Map log file and build index
+   * @param[in] path path of log file
+   * @return 0 on success, otherwise error
+   */
+  int open(const char * path);
+
+  /**
+   * @brief Unmap log file
+   */
+  void close(void);
+
+  /**
+   * @brief Check if log file is mapped
+   * @return true if log file is mapped and has at least one epoch
+   */
+  bool isOpen(void) const { return !epochs_.empty(); }
+
+  /**
+   * @brief Check if log has a message
+   * @param[in] key (class << 8) | id
+   * @return true if at least one frame of the message is recorded
+   */
+  bool contains(uint16_t key) const { return frames_by_key_.count(key) > 0; }
+
+  /**
+   * @brief Get keys of recorded messages
+   * @return keys in ascending order
+   */
+  std::vector<uint16_t> keys(void) const;
+
+  /**
+   * @brief Get number of epochs
+   * @return number of epochs
+   */
+  std::size_t epochs(void) const { return epochs_.size(); }
+
+  /**
+   * @brief Get epoch
+   * @param[in] i index of epoch
+   * @return epoch
+   */
+  const Epoch & epoch(std::size_t i) const { return epochs_[i]; }
+
+  /**
+   * @brief Get frame
+   * @param[in] i index of frame
+   * @return frame
+   */
+  const Frame & frame(std::size_t i) const { return frames_[i]; }
+
+  /**
+   * @brief Get recorded spacing from an epoch to the next one
+   * @param[in] i index of epoch
+   * @return spacing, the last epoch is followed by the first one after the previous spacing
+   */
+  std::chrono::milliseconds interval(std::size_t i) const;
+
+private:
+  /**
+   * @brief Get iTOW of navigation solution
+   * @param[in] frame start of frame
+   * @param[in] size size of frame
+   * @param[out] iTOW GPS time of week [ms]
+   * @return true if the frame carries iTOW
+   */
+  static bool getITOW(const uint8_t * frame, std::size_t size, uint32_t & iTOW);
+
+  void * map_;                 //!< @brief start of mapping
+  std::size_t map_size_;       //!< @brief size of mapping
+  std::vector<Frame> frames_;  //!< @brief frames in file order
+  std::vector<Epoch> epochs_;  //!< @brief epochs in file order
+  std::map<uint16_t, std::vector<std::size_t>> frames_by_key_;  //!< @brief frame indices by key
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_UBX_LOG_H_
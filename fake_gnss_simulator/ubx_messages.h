@@ -0,0 +1,582 @@
+#ifndef FAKE_GNSS_SIMULATOR_UBX_MESSAGES_H_
+#define FAKE_GNSS_SIMULATOR_UBX_MESSAGES_H_
+
+/**
+ * @file ubx_messages.h
+ * @brief UBX message layouts and serializer
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ubx_checksum.h>
+
+// Fields are stored with memcpy, which matches UBX byte order only on little-endian hosts
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "UBX serializer needs little-endian host");
+
+/**
+ * @brief Field of UBX message payload
+ * @tparam T type of field
+ * @tparam OFFSET offset from the start of payload, or of the first repeated block
+ * @tparam STRIDE size of repeated block, 0 if not repeated
+ */
+template <typename T, std::size_t OFFSET, std::size_t STRIDE = 0>
+struct UbxField
+{
+  typedef T type;                                 //!< @brief type of field
+  static constexpr std::size_t offset = OFFSET;  //!< @brief offset from the start of payload
+  static constexpr std::size_t stride = STRIDE;  //!< @brief size of repeated block
+};
+
+/**
+ * @brief UBX-ACK-ACK / UBX-ACK-NAK
+ */
+struct UbxAckACK
+{
+  static constexpr uint8_t CLASS_ID = 0x05;
+  static constexpr uint8_t MESSAGE_ID = 0x01;
+  static constexpr uint16_t LENGTH = 2;
+  typedef UbxField<uint8_t, 0> clsID;
+  typedef UbxField<uint8_t, 1> msgID;
+};
+
+/**
+ * @brief UBX-CFG-PRT for UART
+ */
+struct UbxCfgPRT
+{
+  static constexpr uint8_t CLASS_ID = 0x06;
+  static constexpr uint8_t MESSAGE_ID = 0x00;
+  static constexpr uint16_t LENGTH = 20;
+  typedef UbxField<uint8_t, 0> portID;
+  typedef UbxField<uint16_t, 2> txReady;
+  typedef UbxField<uint32_t, 4> mode;
+  typedef UbxField<uint32_t, 8> baudRate;
+  typedef UbxField<uint16_t, 12> inProtoMask;
+  typedef UbxField<uint16_t, 14> outProtoMask;
+  typedef UbxField<uint16_t, 16> flags;
+};
+
+/**
+ * @brief UBX-CFG-MSG with rates of all ports
+ */
+struct UbxCfgMSG
+{
+  static constexpr uint8_t CLASS_ID = 0x06;
+  static constexpr uint8_t MESSAGE_ID = 0x01;
+  static constexpr uint16_t LENGTH = 8;
+  typedef UbxField<uint8_t, 0> msgClass;
+  typedef UbxField<uint8_t, 1> msgID;
+  typedef UbxField<uint8_t, 2, 1> rate;
+};
+
+/**
+ * @brief UBX-CFG-RATE
+ */
+struct UbxCfgRATE
+{
+  static constexpr uint8_t CLASS_ID = 0x06;
+  static constexpr uint8_t MESSAGE_ID = 0x08;
+  static constexpr uint16_t LENGTH = 6;
+  typedef UbxField<uint16_t, 0> measRate;
+  typedef UbxField<uint16_t, 2> navRate;
+  typedef UbxField<uint16_t, 4> timeRef;
+};
+
+/**
+ * @brief UBX-CFG-VALSET
+ */
+struct UbxCfgVALSET
+{
+  static constexpr uint8_t CLASS_ID = 0x06;
+  static constexpr uint8_t MESSAGE_ID = 0x8A;
+  static constexpr uint16_t LENGTH = 4;  //!< @brief without key and value pairs
+  typedef UbxField<uint8_t, 0> version;
+  typedef UbxField<uint8_t, 1> layers;
+  typedef UbxField<uint8_t, 2> transaction;  //!< @brief version 1 only
+  static constexpr std::size_t cfgData = 4;
+};
+
+/**
+ * @brief UBX-CFG-VALGET
+ */
+struct UbxCfgVALGET
+{
+  static constexpr uint8_t CLASS_ID = 0x06;
+  static constexpr uint8_t MESSAGE_ID = 0x8B;
+  static constexpr uint16_t LENGTH = 4;  //!< @brief without keys or key and value pairs
+  static constexpr std::size_t MAX_KEYS = 64;
+  typedef UbxField<uint8_t, 0> version;
+  typedef UbxField<uint8_t, 1> layer;
+  typedef UbxField<uint16_t, 2> position;
+  static constexpr std::size_t cfgData = 4;
+};
+
+/**
+ * @brief UBX-CFG-VALDEL
+ */
+struct UbxCfgVALDEL
+{
+  static constexpr uint8_t CLASS_ID = 0x06;
+  static constexpr uint8_t MESSAGE_ID = 0x8C;
+  static constexpr uint16_t LENGTH = 4;  //!< @brief without keys
+  typedef UbxField<uint8_t, 0> version;
+  typedef UbxField<uint8_t, 1> layers;
+  typedef UbxField<uint8_t, 2> transaction;  //!< @brief version 1 only
+  static constexpr std::size_t keys = 4;
+};
+
+// Configuration key IDs
+static constexpr uint32_t CFG_RATE_MEAS = 0x30210001;         //!< @brief measurement rate [ms]
+static constexpr uint32_t CFG_RATE_NAV = 0x30210002;          //!< @brief measurements per solution
+static constexpr uint32_t CFG_RATE_TIMEREF = 0x20210003;      //!< @brief time system of epochs
+static constexpr uint32_t CFG_UART1_BAUDRATE = 0x40520001;    //!< @brief UART1 baud rate
+static constexpr uint32_t CFG_UART2_BAUDRATE = 0x40530001;    //!< @brief UART2 baud rate
+static constexpr uint32_t CFG_UART1INPROT_UBX = 0x10730001;   //!< @brief UBX input on UART1
+static constexpr uint32_t CFG_UART1OUTPROT_UBX = 0x10740001;  //!< @brief UBX output on UART1
+static constexpr uint32_t CFG_UART2INPROT_UBX = 0x10750001;   //!< @brief UBX input on UART2
+static constexpr uint32_t CFG_UART2OUTPROT_UBX = 0x10760001;  //!< @brief UBX output on UART2
+static constexpr uint32_t CFG_USBINPROT_UBX = 0x10770001;     //!< @brief UBX input on USB
+static constexpr uint32_t CFG_USBOUTPROT_UBX = 0x10780001;    //!< @brief UBX output on USB
+static constexpr uint32_t CFG_PROT_NMEA_OFFSET = 1;           //!< @brief NMEA key minus UBX key
+static constexpr uint32_t CFG_PROT_RTCM3X_OFFSET = 3;         //!< @brief RTCM3 key minus UBX key
+
+/**
+ * @brief UBX-NAV-STATUS
+ */
+struct UbxNavSTATUS
+{
+  static constexpr uint8_t CLASS_ID = 0x01;
+  static constexpr uint8_t MESSAGE_ID = 0x03;
+  static constexpr uint16_t LENGTH = 16;
+  typedef UbxField<uint32_t, 0> iTOW;
+  typedef UbxField<uint8_t, 4> gpsFix;
+  typedef UbxField<uint8_t, 5> flags;
+  typedef UbxField<uint8_t, 6> fixStat;
+  typedef UbxField<uint8_t, 7> flags2;
+  typedef UbxField<uint32_t, 8> ttff;
+  typedef UbxField<uint32_t, 12> msss;
+};
+
+/**
+ * @brief UBX-NAV-PVT
+ */
+struct UbxNavPVT
+{
+  static constexpr uint8_t CLASS_ID = 0x01;
+  static constexpr uint8_t MESSAGE_ID = 0x07;
+  static constexpr uint16_t LENGTH = 92;
+  typedef UbxField<uint32_t, 0> iTOW;
+  typedef UbxField<uint16_t, 4> year;
+  typedef UbxField<uint8_t, 6> month;
+  typedef UbxField<uint8_t, 7> day;
+  typedef UbxField<uint8_t, 8> hour;
+  typedef UbxField<uint8_t, 9> min;
+  typedef UbxField<uint8_t, 10> sec;
+  typedef UbxField<uint8_t, 11> valid;
+  typedef UbxField<uint32_t, 12> tAcc;
+  typedef UbxField<int32_t, 16> nano;
+  typedef UbxField<uint8_t, 20> fixType;
+  typedef UbxField<uint8_t, 21> flags;
+  typedef UbxField<uint8_t, 22> flags2;
+  typedef UbxField<uint8_t, 23> numSV;
+  typedef UbxField<int32_t, 24> lon;
+  typedef UbxField<int32_t, 28> lat;
+  typedef UbxField<int32_t, 32> height;
+  typedef UbxField<int32_t, 36> hMSL;
+  typedef UbxField<uint32_t, 40> hAcc;
+  typedef UbxField<uint32_t, 44> vAcc;
+  typedef UbxField<int32_t, 48> velN;
+  typedef UbxField<int32_t, 52> velE;
+  typedef UbxField<int32_t, 56> velD;
+  typedef UbxField<int32_t, 60> gSpeed;
+  typedef UbxField<int32_t, 64> headMot;
+  typedef UbxField<uint32_t, 68> sAcc;
+  typedef UbxField<uint32_t, 72> headAcc;
+  typedef UbxField<uint16_t, 76> pDOP;
+  typedef UbxField<uint8_t, 78> flags3;
+  typedef UbxField<int32_t, 84> headVeh;
+  typedef UbxField<int16_t, 88> magDec;
+  typedef UbxField<uint16_t, 90> magAcc;
+};
+
+/**
+ * @brief UBX-NAV-SAT version 1
+ */
+struct UbxNavSAT
+{
+  static constexpr uint8_t CLASS_ID = 0x01;
+  static constexpr uint8_t MESSAGE_ID = 0x35;
+  static constexpr uint16_t LENGTH = 8;  //!< @brief without satellite blocks
+  static constexpr std::size_t BLOCK_SIZE = 12;
+  typedef UbxField<uint32_t, 0> iTOW;
+  typedef UbxField<uint8_t, 4> version;
+  typedef UbxField<uint8_t, 5> numSvs;
+  typedef UbxField<uint8_t, 8, BLOCK_SIZE> gnssId;
+  typedef UbxField<uint8_t, 9, BLOCK_SIZE> svId;
+  typedef UbxField<uint8_t, 10, BLOCK_SIZE> cno;
+  typedef UbxField<int8_t, 11, BLOCK_SIZE> elev;
+  typedef UbxField<int16_t, 12, BLOCK_SIZE> azim;
+  typedef UbxField<int16_t, 14, BLOCK_SIZE> prRes;
+  typedef UbxField<uint32_t, 16, BLOCK_SIZE> flags;
+};
+
+/**
+ * @brief UBX-NAV-RELPOSNED version 1
+ */
+struct UbxNavRELPOSNED
+{
+  static constexpr uint8_t CLASS_ID = 0x01;
+  static constexpr uint8_t MESSAGE_ID = 0x3C;
+  static constexpr uint16_t LENGTH = 64;
+  typedef UbxField<uint8_t, 0> version;
+  typedef UbxField<uint16_t, 2> refStationId;
+  typedef UbxField<uint32_t, 4> iTOW;
+  typedef UbxField<int32_t, 8> relPosN;
+  typedef UbxField<int32_t, 12> relPosE;
+  typedef UbxField<int32_t, 16> relPosD;
+  typedef UbxField<int32_t, 20> relPosLength;
+  typedef UbxField<int32_t, 24> relPosHeading;
+  typedef UbxField<int8_t, 32> relPosHPN;
+  typedef UbxField<int8_t, 33> relPosHPE;
+  typedef UbxField<int8_t, 34> relPosHPD;
+  typedef UbxField<int8_t, 35> relPosHPLength;
+  typedef UbxField<uint32_t, 36> accN;
+  typedef UbxField<uint32_t, 40> accE;
+  typedef UbxField<uint32_t, 44> accD;
+  typedef UbxField<uint32_t, 48> accLength;
+  typedef UbxField<uint32_t, 52> accHeading;
+  typedef UbxField<uint32_t, 60> flags;
+};
+
+/**
+ * @brief UBX-NAV-SIG version 0
+ */
+struct UbxNavSIG
+{
+  static constexpr uint8_t CLASS_ID = 0x01;
+  static constexpr uint8_t MESSAGE_ID = 0x43;
+  static constexpr uint16_t LENGTH = 8;  //!< @brief without signal blocks
+  static constexpr std::size_t BLOCK_SIZE = 16;
+  typedef UbxField<uint32_t, 0> iTOW;
+  typedef UbxField<uint8_t, 4> version;
+  typedef UbxField<uint8_t, 5> numSigs;
+  typedef UbxField<uint8_t, 8, BLOCK_SIZE> gnssId;
+  typedef UbxField<uint8_t, 9, BLOCK_SIZE> svId;
+  typedef UbxField<uint8_t, 10, BLOCK_SIZE> sigId;
+  typedef UbxField<uint8_t, 11, BLOCK_SIZE> freqId;
+  typedef UbxField<int16_t, 12, BLOCK_SIZE> prRes;
+  typedef UbxField<uint8_t, 14, BLOCK_SIZE> cno;
+  typedef UbxField<uint8_t, 15, BLOCK_SIZE> qualityInd;
+  typedef UbxField<uint8_t, 16, BLOCK_SIZE> corrSource;
+  typedef UbxField<uint8_t, 17, BLOCK_SIZE> ionoModel;
+  typedef UbxField<uint16_t, 18, BLOCK_SIZE> sigFlags;
+};
+
+/**
+ * @brief UBX-RXM-SFRBX version 2
+ */
+struct UbxRxmSFRBX
+{
+  static constexpr uint8_t CLASS_ID = 0x02;
+  static constexpr uint8_t MESSAGE_ID = 0x13;
+  static constexpr uint16_t LENGTH = 8;  //!< @brief without data words
+  static constexpr std::size_t WORD_SIZE = 4;
+  typedef UbxField<uint8_t, 0> gnssId;
+  typedef UbxField<uint8_t, 1> svId;
+  typedef UbxField<uint8_t, 2> sigId;
+  typedef UbxField<uint8_t, 3> freqId;
+  typedef UbxField<uint8_t, 4> numWords;
+  typedef UbxField<uint8_t, 5> chn;
+  typedef UbxField<uint8_t, 6> version;
+  typedef UbxField<uint32_t, 8, WORD_SIZE> dwrd;
+};
+
+/**
+ * @brief UBX-RXM-RAWX version 1
+ */
+struct UbxRxmRAWX
+{
+  static constexpr uint8_t CLASS_ID = 0x02;
+  static constexpr uint8_t MESSAGE_ID = 0x15;
+  static constexpr uint16_t LENGTH = 16;  //!< @brief without measurement blocks
+  static constexpr std::size_t BLOCK_SIZE = 32;
+  static constexpr std::size_t MAX_MEAS = 64;
+  typedef UbxField<double, 0> rcvTow;
+  typedef UbxField<uint16_t, 8> week;
+  typedef UbxField<int8_t, 10> leapS;
+  typedef UbxField<uint8_t, 11> numMeas;
+  typedef UbxField<uint8_t, 12> recStat;
+  typedef UbxField<uint8_t, 13> version;
+  typedef UbxField<double, 16, BLOCK_SIZE> prMes;
+  typedef UbxField<double, 24, BLOCK_SIZE> cpMes;
+  typedef UbxField<float, 32, BLOCK_SIZE> doMes;
+  typedef UbxField<uint8_t, 36, BLOCK_SIZE> gnssId;
+  typedef UbxField<uint8_t, 37, BLOCK_SIZE> svId;
+  typedef UbxField<uint8_t, 38, BLOCK_SIZE> sigId;
+  typedef UbxField<uint8_t, 39, BLOCK_SIZE> freqId;
+  typedef UbxField<uint16_t, 40, BLOCK_SIZE> locktime;
+  typedef UbxField<uint8_t, 42, BLOCK_SIZE> cno;
+  typedef UbxField<uint8_t, 43, BLOCK_SIZE> prStdev;
+  typedef UbxField<uint8_t, 44, BLOCK_SIZE> cpStdev;
+  typedef UbxField<uint8_t, 45, BLOCK_SIZE> doStdev;
+  typedef UbxField<uint8_t, 46, BLOCK_SIZE> trkStat;
+};
+
+/**
+ * @brief UBX-RXM-RTCM version 2
+ */
+struct UbxRxmRTCM
+{
+  static constexpr uint8_t CLASS_ID = 0x02;
+  static constexpr uint8_t MESSAGE_ID = 0x32;
+  static constexpr uint16_t LENGTH = 8;
+  typedef UbxField<uint8_t, 0> version;
+  typedef UbxField<uint8_t, 1> flags;
+  typedef UbxField<uint16_t, 2> subType;
+  typedef UbxField<uint16_t, 4> refStation;
+  typedef UbxField<uint16_t, 6> msgType;
+};
+
+/**
+ * @brief UBX-MON-VER
+ */
+struct UbxMonVER
+{
+  static constexpr uint8_t CLASS_ID = 0x0A;
+  static constexpr uint8_t MESSAGE_ID = 0x04;
+  static constexpr uint16_t LENGTH = 40;  //!< @brief without extensions
+  static constexpr std::size_t swVersion = 0;
+  static constexpr std::size_t hwVersion = 30;
+  static constexpr std::size_t extension = 40;
+  static constexpr std::size_t SW_VERSION_SIZE = 30;
+  static constexpr std::size_t HW_VERSION_SIZE = 10;
+  static constexpr std::size_t EXTENSION_SIZE = 30;
+};
+
+/**
+ * @brief UBX-MON-HW
+ */
+struct UbxMonHW
+{
+  static constexpr uint8_t CLASS_ID = 0x0A;
+  static constexpr uint8_t MESSAGE_ID = 0x09;
+  static constexpr uint16_t LENGTH = 60;
+  typedef UbxField<uint32_t, 0> pinSel;
+  typedef UbxField<uint32_t, 4> pinBank;
+  typedef UbxField<uint32_t, 8> pinDir;
+  typedef UbxField<uint32_t, 12> pinVal;
+  typedef UbxField<uint16_t, 16> noisePerMS;
+  typedef UbxField<uint16_t, 18> agcCnt;
+  typedef UbxField<uint8_t, 20> aStatus;
+  typedef UbxField<uint8_t, 21> aPower;
+  typedef UbxField<uint8_t, 22> flags;
+  typedef UbxField<uint32_t, 24> usedMask;
+  static constexpr std::size_t VP = 28;
+  static constexpr std::size_t VP_SIZE = 17;
+  typedef UbxField<uint8_t, 45> jamInd;
+  typedef UbxField<uint32_t, 48> pinIrq;
+  typedef UbxField<uint32_t, 52> pullH;
+  typedef UbxField<uint32_t, 56> pullL;
+};
+
+/**
+ * @brief UBX-MON-COMMS
+ */
+struct UbxMonCOMMS
+{
+  static constexpr uint8_t CLASS_ID = 0x0A;
+  static constexpr uint8_t MESSAGE_ID = 0x36;
+  static constexpr uint16_t LENGTH = 8;  //!< @brief without port blocks
+  static constexpr std::size_t BLOCK_SIZE = 40;
+  static constexpr std::size_t MAX_PORTS = 5;
+  typedef UbxField<uint8_t, 0> version;
+  typedef UbxField<uint8_t, 1> nPorts;
+  typedef UbxField<uint8_t, 2> txErrors;
+  typedef UbxField<uint8_t, 4, 1> protIds;
+  typedef UbxField<uint16_t, 8, BLOCK_SIZE> portId;
+  typedef UbxField<uint16_t, 10, BLOCK_SIZE> txPending;
+  typedef UbxField<uint32_t, 12, BLOCK_SIZE> txBytes;
+  typedef UbxField<uint8_t, 16, BLOCK_SIZE> txUsage;
+  typedef UbxField<uint8_t, 17, BLOCK_SIZE> txPeakUsage;
+  typedef UbxField<uint16_t, 18, BLOCK_SIZE> rxPending;
+  typedef UbxField<uint32_t, 20, BLOCK_SIZE> rxBytes;
+  typedef UbxField<uint8_t, 24, BLOCK_SIZE> rxUsage;
+  typedef UbxField<uint8_t, 25, BLOCK_SIZE> rxPeakUsage;
+  typedef UbxField<uint16_t, 26, BLOCK_SIZE> overrunErrs;
+  typedef UbxField<uint32_t, 44, BLOCK_SIZE> skipped;
+};
+
+/**
+ * @brief UBX-ESF-MEAS
+ */
+struct UbxEsfMEAS
+{
+  static constexpr uint8_t CLASS_ID = 0x10;
+  static constexpr uint8_t MESSAGE_ID = 0x02;
+  static constexpr uint16_t LENGTH = 8;  //!< @brief without data words
+  static constexpr std::size_t WORD_SIZE = 4;
+  typedef UbxField<uint32_t, 0> timeTag;
+  typedef UbxField<uint16_t, 4> flags;
+  typedef UbxField<uint16_t, 6> id;
+  typedef UbxField<uint32_t, 8, WORD_SIZE> data;
+};
+
+/**
+ * @brief UBX-ESF-STATUS version 2
+ */
+struct UbxEsfSTATUS
+{
+  static constexpr uint8_t CLASS_ID = 0x10;
+  static constexpr uint8_t MESSAGE_ID = 0x10;
+  static constexpr uint16_t LENGTH = 16;  //!< @brief without sensor blocks
+  static constexpr std::size_t BLOCK_SIZE = 4;
+  typedef UbxField<uint32_t, 0> iTOW;
+  typedef UbxField<uint8_t, 4> version;
+  typedef UbxField<uint8_t, 5> initStatus1;
+  typedef UbxField<uint8_t, 6> initStatus2;
+  typedef UbxField<uint8_t, 12> fusionMode;
+  typedef UbxField<uint8_t, 15> numSens;
+  typedef UbxField<uint8_t, 16, BLOCK_SIZE> sensStatus1;
+  typedef UbxField<uint8_t, 17, BLOCK_SIZE> sensStatus2;
+  typedef UbxField<uint8_t, 18, BLOCK_SIZE> freq;
+  typedef UbxField<uint8_t, 19, BLOCK_SIZE> faults;
+};
+
+/**
+ * @brief UBX-ESF-INS version 1
+ */
+struct UbxEsfINS
+{
+  static constexpr uint8_t CLASS_ID = 0x10;
+  static constexpr uint8_t MESSAGE_ID = 0x15;
+  static constexpr uint16_t LENGTH = 36;
+  typedef UbxField<uint32_t, 0> bitfield0;
+  typedef UbxField<uint32_t, 8> iTOW;
+  typedef UbxField<int32_t, 12> xAngRate;
+  typedef UbxField<int32_t, 16> yAngRate;
+  typedef UbxField<int32_t, 20> zAngRate;
+  typedef UbxField<int32_t, 24> xAccel;
+  typedef UbxField<int32_t, 28> yAccel;
+  typedef UbxField<int32_t, 32> zAccel;
+};
+
+/**
+ * @brief Serializer writing a UBX frame straight into a buffer
+ * @tparam M message layout
+ */
+template <typename M>
+class UbxFrame
+{
+public:
+  static constexpr std::size_t HEADER_SIZE = 6;    //!< @brief sync characters, class, id, length
+  static constexpr std::size_t CHECKSUM_SIZE = 2;  //!< @brief CK_A and CK_B
+
+  /**
+   * @brief Write header and clear payload
+   * @param[out] buf buffer of at least HEADER_SIZE + length + CHECKSUM_SIZE bytes
+   * @param[in] length payload length
+   */
+  explicit UbxFrame(uint8_t * buf, uint16_t length = M::LENGTH)
+  : buf_(buf), length_(length), patch_(false)
+  {
+    buf_[0] = 0xB5;
+    buf_[1] = 0x62;
+    buf_[2] = M::CLASS_ID;
+    buf_[3] = M::MESSAGE_ID;
+    buf_[4] = length_ & 0xFF;
+    buf_[5] = length_ >> 8;
+    memset(payload(), 0, length_);
+  }
+
+  /**
+   * @brief Update a previously finished frame in place
+   * @param[inout] buf frame returned by finish()
+   * @return serializer which keeps checksum up to date on every set()
+   */
+  static UbxFrame update(uint8_t * buf) { return UbxFrame(buf, buf[4] | (buf[5] << 8), true); }
+
+  /**
+   * @brief Set field
+   * @tparam F field
+   * @param[in] value value of field
+   * @param[in] index index of repeated block
+   */
+  template <typename F>
+  void set(typename F::type value, std::size_t index = 0)
+  {
+    static_assert(F::stride > 0 || F::offset + sizeof(value) <= M::LENGTH, "field out of range");
+    setBytes(F::offset + index * F::stride, &value, sizeof(value));
+  }
+
+  /**
+   * @brief Set bytes such as fixed size strings
+   * @param[in] offset offset from the start of payload
+   * @param[in] data bytes
+   * @param[in] size number of bytes
+   */
+  void setBytes(std::size_t offset, const void * data, std::size_t size)
+  {
+    uint8_t * p = payload() + offset;
+    if (patch_) {
+      // Patch checksum only for bytes which actually changed
+      const uint8_t * v = static_cast<const uint8_t *>(data);
+      for (std::size_t i = 0; i < size; ++i) {
+        if (p[i] == v[i]) continue;
+        ubxChecksumPatch(length_ - offset - i, p[i], v[i], ck_a(), ck_b());
+        p[i] = v[i];
+      }
+    } else {
+      memcpy(p, data, size);
+    }
+  }
+
+  /**
+   * @brief Calculate checksum
+   * @return size of frame
+   */
+  std::size_t finish(void)
+  {
+    if (!patch_) {
+      ck_a() = 0;
+      ck_b() = 0;
+      ubxChecksum(buf_ + 2, HEADER_SIZE - 2 + length_, ck_a(), ck_b());
+    }
+    return HEADER_SIZE + length_ + CHECKSUM_SIZE;
+  }
+
+private:
+  /**
+   * @brief Attach to frame without touching it
+   * @param[inout] buf frame buffer
+   * @param[in] length payload length
+   * @param[in] patch update checksum on every set()
+   */
+  UbxFrame(uint8_t * buf, uint16_t length, bool patch) : buf_(buf), length_(length), patch_(patch)
+  {
+  }
+
+  /**
+   * @brief Get start of payload
+   * @return start of payload
+   */
+  uint8_t * payload(void) { return buf_ + HEADER_SIZE; }
+
+  /**
+   * @brief Get checksum a
+   * @return reference to checksum a in frame
+   */
+  uint8_t & ck_a(void) { return buf_[HEADER_SIZE + length_]; }
+
+  /**
+   * @brief Get checksum b
+   * @return reference to checksum b in frame
+   */
+  uint8_t & ck_b(void) { return buf_[HEADER_SIZE + length_ + 1]; }
+
+  uint8_t * buf_;    //!< @brief frame buffer
+  uint16_t length_;  //!< @brief payload length
+  bool patch_;       //!< @brief checksum is valid and patched on every set()
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_UBX_MESSAGES_H_
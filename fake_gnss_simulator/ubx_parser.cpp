@@ -0,0 +1,93 @@
+/**
+ * @file ubx_parser.cpp
+ * @brief Streaming UBX frame parser
+ */
+
+#include <ubx_checksum.h>
+#include <ubx_parser.h>
+#include <algorithm>
+#include <cstring>
+
+static constexpr uint8_t SYNC_CHAR_1 = 0xB5;
+static constexpr uint8_t SYNC_CHAR_2 = 0x62;
+static constexpr std::size_t HEADER_SIZE = 6;
+static constexpr std::size_t CHECKSUM_SIZE = 2;
+
+UbxParser::UbxParser() { reset(); }
+
+void UbxParser::reset(void)
+{
+  head_ = 0;
+  tail_ = 0;
+  length_ = 0;
+  state_ = WaitSync;
+}
+
+void UbxParser::feed(const uint8_t * data, std::size_t size)
+{
+  for (std::size_t i = 0; i < size; ++i) {
+    if (available() == BUFFER_SIZE) {
+      // Overflow, the current frame is lost
+      ++tail_;
+      state_ = WaitSync;
+    }
+    buf_[head_ & (BUFFER_SIZE - 1)] = data[i];
+    ++head_;
+  }
+}
+
+bool UbxParser::next(const uint8_t *& frame, std::size_t & size)
+{
+  while (true) {
+    switch (state_) {
+      case WaitSync:
+        while (available() >= 2 && (at(0) != SYNC_CHAR_1 || at(1) != SYNC_CHAR_2)) ++tail_;
+        if (available() < 2) return false;
+        state_ = WaitHeader;
+        break;
+
+      case WaitHeader:
+        if (available() < HEADER_SIZE) return false;
+        length_ = at(4) | (at(5) << 8);
+        if (length_ > MAX_PAYLOAD) {
+          skip(1);
+          break;
+        }
+        state_ = WaitFrame;
+        break;
+
+      case WaitFrame: {
+        std::size_t n = HEADER_SIZE + length_ + CHECKSUM_SIZE;
+        if (available() < n) return false;
+
+        // Copy frame out of the ring buffer in at most two pieces
+        std::size_t start = tail_ & (BUFFER_SIZE - 1);
+        std::size_t first = std::min(n, BUFFER_SIZE - start);
+        memcpy(frame_, &buf_[start], first);
+        memcpy(frame_ + first, &buf_[0], n - first);
+
+        // Checksum over class to payload
+        uint8_t ck_a = 0;
+        uint8_t ck_b = 0;
+        ubxChecksum(&frame_[2], n - 2 - CHECKSUM_SIZE, ck_a, ck_b);
+        if (ck_a != frame_[n - 2] || ck_b != frame_[n - 1]) {
+          // Sync characters may have been found in other data, search again after them
+          skip(1);
+          break;
+        }
+
+        tail_ += n;
+        state_ = WaitSync;
+        frame = frame_;
+        size = n;
+        return true;
+      }
+    }
+  }
+}
+
+void UbxParser::skip(std::size_t size)
+{
+  tail_ += size;
+  state_ = WaitSync;
+}
@@ -0,0 +1,81 @@
+#ifndef FAKE_GNSS_SIMULATOR_UBX_PARSER_H_
+#define FAKE_GNSS_SIMULATOR_UBX_PARSER_H_
+
+/**
+ * @file ubx_parser.h
+ * @brief Streaming UBX frame parser
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+class UbxParser
+{
+public:
+  static constexpr std::size_t BUFFER_SIZE = 8192;  //!< @brief ring buffer size, power of two
+  static constexpr std::size_t MAX_PAYLOAD = 2048;  //!< @brief largest payload accepted
+
+  /**
+   * @brief Constructor
+   */
+  UbxParser();
+
+  /**
+   * @brief Discard buffered data
+   */
+  void reset(void);
+
+  /**
+   * @brief Append received data
+   * @param[in] data received data
+   * @param[in] size size of data
+   * @note The oldest data is discarded if the ring buffer overflows
+   */
+  void feed(const uint8_t * data, std::size_t size);
+
+  /**
+   * @brief Take the next complete frame with valid checksum
+   * @param[out] frame start of frame, valid until the next call
+   * @param[out] size size of frame
+   * @return true if a frame is available
+   */
+  bool next(const uint8_t *& frame, std::size_t & size);
+
+private:
+  /**
+   * @brief Parser state
+   */
+  enum State {
+    WaitSync = 0,  //!< @brief waiting for 0xB5 0x62
+    WaitHeader,    //!< @brief waiting for class, id and length
+    WaitFrame,     //!< @brief waiting for payload and checksum
+  };
+
+  /**
+   * @brief Get buffered byte
+   * @param[in] offset offset from the start of the current frame
+   * @return byte
+   */
+  uint8_t at(std::size_t offset) const { return buf_[(tail_ + offset) & (BUFFER_SIZE - 1)]; }
+
+  /**
+   * @brief Get number of buffered bytes
+   * @return number of buffered bytes
+   */
+  std::size_t available(void) const { return head_ - tail_; }
+
+  /**
+   * @brief Drop bytes from the start of the current frame and search for the next sync
+   * @param[in] size number of bytes to drop
+   */
+  void skip(std::size_t size);
+
+  uint8_t buf_[BUFFER_SIZE];        //!< @brief ring buffer
+  uint8_t frame_[MAX_PAYLOAD + 8];  //!< @brief frame copied out of the ring buffer
+  std::size_t head_;                //!< @brief write position
+  std::size_t tail_;                //!< @brief start of the current frame
+  std::size_t length_;              //!< @brief payload length of the current frame
+  State state_;                     //!< @brief parser state
+};
+
+#endif  // FAKE_GNSS_SIMULATOR_UBX_PARSER_H_
@@ -0,0 +1,147 @@
+/**
+ * @file command_table.cpp
+ * @brief Table of Tamagawa commands and responses
+ */
+
+#include <command_table.h>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace fs = boost::filesystem;
+namespace pt = boost::property_tree;
+
+static constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static constexpr uint32_t FNV_PRIME = 16777619u;
+static constexpr int MAX_PREFIXES = 8;
+
+/**
+ * @brief Calculate FNV-1a hash
+ * @param[in] data start of range
+ * @param[in] size size of range
+ * @return hash value
+ */
+static uint32_t hash(const char * data, std::size_t size)
+{
+  uint32_t h = FNV_OFFSET_BASIS;
+  for (std::size_t i = 0; i < size; ++i) {
+    h = (h ^ static_cast<uint8_t>(data[i])) * FNV_PRIME;
+  }
+  return h;
+}
+
+CommandTable::CommandTable() { reset(); }
+
+int CommandTable::load(const std::string & path)
+{
+  if (path.empty()) {
+    reset();
+    return 0;
+  }
+
+  if (!fs::exists(path)) {
+    std::cerr << strerror(ENOENT) << ": " << path << std::endl;
+    return ENOENT;
+  }
+
+  pt::ptree pt;
+  try {
+    read_ini(path, pt);
+  } catch (const pt::ini_parser_error & e) {
+    std::cerr << e.what() << std::endl;
+    return EINVAL;
+  }
+
+  // Commands are parsed aside, the table being left as it is on error
+  CommandTable loaded;
+  loaded.table_.clear();
+  for (const auto & section : pt) {
+    Command c;
+    c.command_ = section.second.get<std::string>("command", "");
+    c.response_ = section.second.get<std::string>("response", "");
+    c.rate_ = section.second.get<int>("rate", 0);
+    c.delay_ = section.second.get<int>("delay", 0);
+
+    std::string action = section.second.get<std::string>("action", "none");
+    if (action == "none") {
+      c.action_ = COMMAND_ACTION_NONE;
+    } else if (action == "start") {
+      c.action_ = COMMAND_ACTION_START;
+    } else if (action == "stop") {
+      c.action_ = COMMAND_ACTION_STOP;
+    } else if (action == "rate") {
+      c.action_ = COMMAND_ACTION_RATE;
+    } else {
+      std::cerr << "[" << section.first << "] unknown action: " << action << std::endl;
+      return EINVAL;
+    }
+
+    if (c.command_.empty()) {
+      std::cerr << "[" << section.first << "] command is not specified" << std::endl;
+      return EINVAL;
+    }
+    if (!loaded.add(c)) {
+      std::cerr << "[" << section.first << "] duplicated command: " << c.command_ << std::endl;
+      return EINVAL;
+    }
+  }
+
+  // Default commands stay unless the file defines them
+  for (const auto & entry : CommandTable().table_) loaded.add(entry.second);
+  table_.swap(loaded.table_);
+  return 0;
+}
+
+const Command * CommandTable::find(const char * line, std::size_t size, std::string & arg) const
+{
+  // Hash the whole line once, remembering the hash of every comma separated prefix
+  std::size_t pos[MAX_PREFIXES];
+  uint32_t prefix[MAX_PREFIXES];
+  int n = 0;
+  uint32_t h = FNV_OFFSET_BASIS;
+  for (std::size_t i = 0; i < size; ++i) {
+    if (line[i] == ',' && n < MAX_PREFIXES) {
+      pos[n] = i;
+      prefix[n] = h;
+      ++n;
+    }
+    h = (h ^ static_cast<uint8_t>(line[i])) * FNV_PRIME;
+  }
+
+  // Try the whole line first, then the prefixes from the longest one
+  for (int i = n; i >= 0; --i) {
+    // Commands whose hashes collide share a bucket, and are told apart by their strings
+    std::size_t len = (i == n) ? size : pos[i];
+    auto range = table_.equal_range((i == n) ? h : prefix[i]);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.command_.compare(0, std::string::npos, line, len) != 0) continue;
+
+      arg = (i == n) ? "" : std::string(line + len + 1, size - len - 1);
+      return &it->second;
+    }
+  }
+
+  return nullptr;
+}
+
+void CommandTable::reset(void)
+{
+  table_.clear();
+  // Start BIN output at the rate given as argument, e.g. $TSC,BIN,30
+  add({"$TSC,BIN", "", COMMAND_ACTION_START, 0, 0});
+}
+
+bool CommandTable::add(const Command & command)
+{
+  uint32_t h = hash(command.command_.c_str(), command.command_.size());
+  auto range = table_.equal_range(h);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.command_ == command.command_) return false;
+  }
+  table_.emplace(h, command);
+  return true;
+}
@@ -0,0 +1,75 @@
+#ifndef FAKE_IMU_SIMULATOR_COMMAND_TABLE_H_
+#define FAKE_IMU_SIMULATOR_COMMAND_TABLE_H_
+
+/**
+ * @file command_table.h
+ * @brief Table of Tamagawa commands and responses
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief State change caused by a command
+ */
+enum CommandAction {
+  COMMAND_ACTION_NONE = 0,  //!< @brief send response only
+  COMMAND_ACTION_START,     //!< @brief start BIN output
+  COMMAND_ACTION_STOP,      //!< @brief stop BIN output
+  COMMAND_ACTION_RATE,      //!< @brief change BIN output rate only
+};
+
+/**
+ * @brief Command entry
+ */
+struct Command
+{
+  std::string command_;   //!< @brief command prefix such as $TSC,BIN
+  std::string response_;  //!< @brief response without CR/LF, empty for no response
+  CommandAction action_;  //!< @brief state change
+  int rate_;              //!< @brief output rate [Hz], 0 to take it from the command argument
+  int delay_;             //!< @brief response delay [ms]
+};
+
+class CommandTable
+{
+public:
+  /**
+   * @brief Constructor, the table contains the default commands
+   */
+  CommandTable();
+
+  /**
+   * @brief Load commands from ini file, in addition to the default commands
+   * @param[in] path path to command file, empty for the default commands only
+   * @return 0 on success, otherwise error leaving the table unchanged
+   */
+  int load(const std::string & path);
+
+  /**
+   * @brief Find the command which matches the longest prefix of a line
+   * @param[in] line received line without CR/LF
+   * @param[in] size size of line
+   * @param[out] arg command argument following the matched prefix
+   * @return matched command, nullptr if not found
+   */
+  const Command * find(const char * line, std::size_t size, std::string & arg) const;
+
+private:
+  /**
+   * @brief Clear the table and add the default commands
+   */
+  void reset(void);
+
+  /**
+   * @brief Add command to the table
+   * @param[in] command command entry
+   * @return true on success, false if the command is already in the table
+   */
+  bool add(const Command & command);
+
+  std::unordered_multimap<uint32_t, Command> table_;  //!< @brief commands by hash of their prefix
+};
+
+#endif  // FAKE_IMU_SIMULATOR_COMMAND_TABLE_H_
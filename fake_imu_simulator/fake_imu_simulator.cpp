@@ -1,11 +1,9 @@
 #include <fake_imu_simulator.h>
-#include <boost/algorithm/string/classification.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
 #include <boost/process.hpp>
 #include <boost/property_tree/ini_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
-#include <boost/range/algorithm_ext/erase.hpp>
 #include <boost/thread.hpp>
 #include <iostream>
 #include <string>
@@ -14,12 +12,15 @@
 namespace fs = boost::filesystem;
 namespace pt = boost::property_tree;
 
-static constexpr int MAX_SIZE = 1024;
 static constexpr int MAX_BIN_SIZE = 58;
+static constexpr int DEFAULT_RATE = 30;
 
 FakeIMUSimulator * FakeIMUSimulator::imu_ = nullptr;
 
-FakeIMUSimulator::FakeIMUSimulator() : bin_req_(false) {}
+FakeIMUSimulator::FakeIMUSimulator()
+: bin_req_(false), rate_(DEFAULT_RATE), default_rate_(DEFAULT_RATE)
+{
+}
 
 FakeIMUSimulator * FakeIMUSimulator::get(void)
 {
@@ -31,10 +32,14 @@ FakeIMUSimulator * FakeIMUSimulator::get(void)
   return imu_;
 }
 
+void FakeIMUSimulator::setIniFile(const char * ini_file) { ini_path_ = ini_file; }
+
 void FakeIMUSimulator::loadIniFile(void)
 {
-  auto env = boost::this_process::environment();
-  ini_path_ = env["HOME"].to_string() + "/.config/fake_imu_simulator.ini";
+  if (ini_path_.empty()) {
+    auto env = boost::this_process::environment();
+    ini_path_ = env["HOME"].to_string() + "/.config/fake_imu_simulator.ini";
+  }
 
   if (!fs::exists(ini_path_)) return;
 
@@ -43,12 +48,21 @@ void FakeIMUSimulator::loadIniFile(void)
 
   if (boost::optional<std::string> v = pt.get_optional<std::string>("device_name")) {
     const char * str = v.get().c_str();
-    strncpy(device_name_, str, strlen(str));
+    strncpy(device_name_, str, sizeof(device_name_) - 1);
   }
 
   if (boost::optional<std::string> v = pt.get_optional<std::string>("log_file")) {
     const char * str = v.get().c_str();
-    strncpy(log_file_, str, strlen(str));
+    strncpy(log_file_, str, sizeof(log_file_) - 1);
+  }
+
+  if (boost::optional<int> v = pt.get_optional<int>("rate")) {
+    if (v.get() > 0) default_rate_ = v.get();
+  }
+
+  if (boost::optional<std::string> v = pt.get_optional<std::string>("command_file")) {
+    const char * str = v.get().c_str();
+    strncpy(command_file_, str, sizeof(command_file_) - 1);
   }
 }
 
@@ -58,6 +72,8 @@ void FakeIMUSimulator::saveIniFile(void)
 
   pt.put("device_name", device_name_);
   pt.put("log_file", log_file_);
+  pt.put("rate", default_rate_);
+  pt.put("command_file", command_file_);
 
   write_ini(ini_path_, pt);
 }
@@ -65,7 +81,7 @@ void FakeIMUSimulator::saveIniFile(void)
 // General
 void FakeIMUSimulator::setDeviceName(const char * device_name)
 {
-  strncpy(device_name_, device_name, strlen(device_name));
+  strncpy(device_name_, device_name, sizeof(device_name_) - 1);
 }
 
 const char * FakeIMUSimulator::getDeviceName(void) const { return device_name_; }
@@ -80,6 +96,10 @@ int FakeIMUSimulator::start(void)
     return ret;
   }
 
+  // Load command table
+  ret = commands_.load(command_file_);
+  if (ret != 0) return ret;
+
   // Preparation for a subsequent run() invocation
   io_.reset();
   port_ = boost::shared_ptr<as::serial_port>(new as::serial_port(io_));
@@ -94,6 +114,8 @@ int FakeIMUSimulator::start(void)
   }
 
   bin_req_ = false;
+  rate_ = default_rate_;
+  line_.clear();
   stop_thread_ = false;
   pthread_create(&th_, nullptr, &FakeIMUSimulator::threadHelper, this);
   return ret;
@@ -125,21 +147,34 @@ void FakeIMUSimulator::setDebugOutput(int is_debug)
 
 void FakeIMUSimulator::setLogFile(const char * log_file)
 {
-  strncpy(log_file_, log_file, strlen(log_file));
+  strncpy(log_file_, log_file, sizeof(log_file_) - 1);
 }
 
 const char * FakeIMUSimulator::getLogFile(void) const { return log_file_; }
 
+void FakeIMUSimulator::setRate(int rate)
+{
+  if (rate > 0) default_rate_ = rate;
+}
+
+int FakeIMUSimulator::getRate(void) const { return default_rate_; }
+
+void FakeIMUSimulator::setCommandFile(const char * command_file)
+{
+  strncpy(command_file_, command_file, sizeof(command_file_) - 1);
+}
+
+const char * FakeIMUSimulator::getCommandFile(void) const { return command_file_; }
+
 void * FakeIMUSimulator::thread(void)
 {
   boost::thread thr_io(boost::bind(&as::io_service::run, &io_));
 
   // asynchronously read data
-  uint8_t data[MAX_SIZE] = "";
   port_->async_read_some(
-    as::buffer(data), boost::bind(
-                        &FakeIMUSimulator::onRead, this, as::placeholders::error,
-                        as::placeholders::bytes_transferred, data));
+    as::buffer(read_buf_), boost::bind(
+                             &FakeIMUSimulator::onRead, this, as::placeholders::error,
+                             as::placeholders::bytes_transferred, read_buf_));
 
   fs::ifstream ifs(log_file_, std::ios::in | std::ios::binary);
   if (!ifs) {
@@ -153,7 +188,14 @@ void * FakeIMUSimulator::thread(void)
     pthread_mutex_unlock(&mutex_stop_);
     if (b) break;
 
-    if (bin_req_) {
+    bool req;
+    int rate;
+    pthread_mutex_lock(&mutex_bin_);
+    req = bin_req_;
+    rate = rate_;
+    pthread_mutex_unlock(&mutex_bin_);
+
+    if (req) {
       uint8_t data[MAX_BIN_SIZE] = {};
       int len = sizeof(data);
       ifs.read(reinterpret_cast<char *>(data), len);
@@ -180,8 +222,7 @@ void * FakeIMUSimulator::thread(void)
                              as::placeholders::bytes_transferred, frame));
     }
 
-    // 30Hz
-    usleep(1000000 / 30);
+    usleep(1000000 / rate);
   }
 
   ifs.close();
@@ -234,19 +275,21 @@ void FakeIMUSimulator::onRead(
       dump(Read, data, bytes_transfered);
     }
 
-    std::string str(data, data + bytes_transfered);
-    boost::remove_erase_if(str, boost::is_any_of("\r\n"));
-
-    if (str == "$TSC,BIN,30") {
-      bin_req_ = true;
+    // Split received data into lines, a command may span several reads
+    for (std::size_t i = 0; i < bytes_transfered; ++i) {
+      if (data[i] == '\r' || data[i] == '\n') {
+        if (!line_.empty()) handleCommand(line_);
+        line_.clear();
+      } else {
+        line_ += data[i];
+      }
     }
 
     // asynchronously read data
-    uint8_t next[MAX_SIZE] = "";
     port_->async_read_some(
-      as::buffer(next), boost::bind(
-                          &FakeIMUSimulator::onRead, this, as::placeholders::error,
-                          as::placeholders::bytes_transferred, next));
+      as::buffer(read_buf_), boost::bind(
+                               &FakeIMUSimulator::onRead, this, as::placeholders::error,
+                               as::placeholders::bytes_transferred, read_buf_));
   }
 }
 
@@ -262,3 +305,76 @@ void FakeIMUSimulator::onWrite(
     dumpBIN(&data[0]);
   }
 }
+
+void FakeIMUSimulator::handleCommand(const std::string & line)
+{
+  std::string arg;
+  const Command * c = commands_.find(line.c_str(), line.size(), arg);
+  if (c == nullptr) return;
+
+  int rate = c->rate_;
+  if (rate == 0) rate = atoi(arg.c_str());
+
+  pthread_mutex_lock(&mutex_bin_);
+  switch (c->action_) {
+    case COMMAND_ACTION_START:
+      // Rate 0 stops output as the real sensor does
+      bin_req_ = (rate > 0);
+      if (rate > 0) rate_ = rate;
+      break;
+    case COMMAND_ACTION_STOP:
+      bin_req_ = false;
+      break;
+    case COMMAND_ACTION_RATE:
+      if (rate > 0) rate_ = rate;
+      break;
+    default:
+      break;
+  }
+  pthread_mutex_unlock(&mutex_bin_);
+
+  if (c->response_.empty()) return;
+
+  if (c->delay_ > 0) {
+    // Send response after the delay without blocking the io service
+    boost::shared_ptr<as::deadline_timer> timer(
+      new as::deadline_timer(io_, boost::posix_time::milliseconds(c->delay_)));
+    timer->async_wait(boost::bind(
+      &FakeIMUSimulator::onResponseDelay, this, as::placeholders::error, timer, c->response_));
+  } else {
+    sendResponse(c->response_);
+  }
+}
+
+void FakeIMUSimulator::onResponseDelay(
+  const boost::system::error_code & error, boost::shared_ptr<as::deadline_timer> timer,
+  const std::string & response)
+{
+  if (!error) sendResponse(response);
+}
+
+void FakeIMUSimulator::sendResponse(const std::string & response)
+{
+  std::vector<uint8_t> frame(response.begin(), response.end());
+  frame.push_back('\r');
+  frame.push_back('\n');
+
+  // asynchronously write data
+  port_->async_write_some(
+    as::buffer(frame), boost::bind(
+                         &FakeIMUSimulator::onWriteResponse, this, as::placeholders::error,
+                         as::placeholders::bytes_transferred, frame));
+}
+
+void FakeIMUSimulator::onWriteResponse(
+  const boost::system::error_code & error, std::size_t bytes_transfered,
+  const std::vector<uint8_t> & data)
+{
+  bool b;
+  pthread_mutex_lock(&mutex_dump_);
+  b = dump_;
+  pthread_mutex_unlock(&mutex_dump_);
+  if (b) {
+    dump(Write, &data[0], bytes_transfered);
+  }
+}
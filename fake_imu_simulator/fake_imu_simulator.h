@@ -6,6 +6,7 @@
  * @brief Fake IMU simulator definitions
  */
 
+#include <command_table.h>
 #include <linux/limits.h>
 #include <boost/asio.hpp>
 #include <string>
@@ -18,6 +19,12 @@ class FakeIMUSimulator
 public:
   static FakeIMUSimulator * get();
 
+  /**
+   * @brief Set path of ini file to use instead of the default one
+   * @param [in] ini_file path of ini file
+   */
+  void setIniFile(const char * ini_file);
+
   /**
    * @brief Load data from ini file
    */
@@ -77,6 +84,30 @@ public:
    */
   const char * getLogFile(void) const;
 
+  /**
+   * @brief Set BIN output rate used until a command changes it
+   * @param [in] rate BIN output rate [Hz]
+   */
+  void setRate(int rate);
+
+  /**
+   * @brief Get BIN output rate used until a command changes it
+   * @return BIN output rate [Hz]
+   */
+  int getRate(void) const;
+
+  /**
+   * @brief Set path of command file for saving it to ini file
+   * @param [in] command_file path of command file
+   */
+  void setCommandFile(const char * command_file);
+
+  /**
+   * @brief Get path of command file stored in ini file
+   * @return path of command file
+   */
+  const char * getCommandFile(void) const;
+
 private:
   /**
    * @brief io direction
@@ -139,6 +170,38 @@ private:
     const boost::system::error_code & error, std::size_t bytes_transfered,
     const std::vector<uint8_t> & data);
 
+  /**
+   * @brief Handle a received command line
+   * @param[in] line received line without CR/LF
+   */
+  void handleCommand(const std::string & line);
+
+  /**
+   * @brief Handler to be called when the response delay expires
+   * @param[in] error error argument of a handler
+   * @param[in] timer timer kept alive until the handler is called
+   * @param[in] response response without CR/LF
+   */
+  void onResponseDelay(
+    const boost::system::error_code & error, boost::shared_ptr<as::deadline_timer> timer,
+    const std::string & response);
+
+  /**
+   * @brief Send response to a command
+   * @param[in] response response without CR/LF
+   */
+  void sendResponse(const std::string & response);
+
+  /**
+   * @brief Handler to be called when the response write operation completes
+   * @param[in] error error argument of a handler
+   * @param[in] bytes_transfered bytes transferred argument of a handler
+   * @param[inout] data sent data
+   */
+  void onWriteResponse(
+    const boost::system::error_code & error, std::size_t bytes_transfered,
+    const std::vector<uint8_t> & data);
+
   static FakeIMUSimulator * imu_;            //!< @brief reference to itself
   std::string ini_path_;                     //!< @brief path to ini file
   as::io_service io_;                        //!< @brief facilities of custom asynchronous services
@@ -146,6 +209,7 @@ private:
   pthread_mutex_t mutex_stop_;               //!< @brief mutex to protect access to stop_thread
   pthread_mutex_t mutex_error_;              //!< @brief mutex to protect access to checksum_error
   pthread_mutex_t mutex_dump_;               //!< @brief mutex to protect access to dump flag
+  pthread_mutex_t mutex_bin_;                //!< @brief mutex to protect access to BIN output state
   pthread_t th_;                             //!< @brief thread handle
 
   // General
@@ -153,10 +217,18 @@ private:
   bool stop_thread_;            //!< @brief flag to stop thread
   bool checksum_error_;         //!< @brief flag to generate checksum error occur or not
   bool dump_;                   //!< @brief flag to show debug output or not
+  uint8_t read_buf_[1024];      //!< @brief buffer for asynchronous read
+  std::string line_;            //!< @brief command line being received
 
   // BIN
   char log_file_[PATH_MAX];  //!< @brief log file
   bool bin_req_;             //!< @brief flag of BIN request received
+  int rate_;                 //!< @brief BIN output rate [Hz]
+  int default_rate_;         //!< @brief BIN output rate until a command changes it [Hz]
+
+  // Command
+  char command_file_[PATH_MAX];  //!< @brief command file
+  CommandTable commands_;        //!< @brief command table
 };
 
 #endif  // FAKE_IMU_SIMULATOR_FAKE_IMU_SIMULATOR_H_
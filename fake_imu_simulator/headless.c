@@ -0,0 +1,110 @@
+/**
+ * @file headless.c
+ * @brief Main program without GUI
+ */
+
+#include <getopt.h>
+#include <interface.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Show usage
+ * @param [in] name program name
+ */
+static void usage(const char * name)
+{
+  printf("Usage: %s [options]\n", name);
+  printf("  -c, --config FILE      load settings from FILE instead of the default ini file\n");
+  printf("  -d, --device NAME      device name\n");
+  printf("  -l, --log FILE         log file\n");
+  printf("  -m, --command FILE     command file\n");
+  printf("  -r, --rate HZ          BIN output rate until a command changes it\n");
+  printf("  -e, --checksum-error   generate checksum error\n");
+  printf("  -v, --debug            show debug output\n");
+  printf("  -h, --help             show this help\n");
+}
+
+/**
+ * @brief Main function
+ * @param [in] argc the count of command line arguments
+ * @param [in] argv the command line arguments
+ */
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    {"config", required_argument, NULL, 'c'},
+    {"device", required_argument, NULL, 'd'},
+    {"log", required_argument, NULL, 'l'},
+    {"command", required_argument, NULL, 'm'},
+    {"rate", required_argument, NULL, 'r'},
+    {"checksum-error", no_argument, NULL, 'e'},
+    {"debug", no_argument, NULL, 'v'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+  };
+  sigset_t set;
+  int sig;
+  int opt;
+
+  // Settings from the config file are loaded first, and flags override them
+  while ((opt = getopt_long(argc, argv, "c:d:l:m:r:evh", options, NULL)) != -1) {
+    if (opt == 'c') {
+      setIniFile(optarg);
+    } else if (opt == 'h') {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (opt == '?') {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Load data from ini file
+  loadIniFile();
+
+  optind = 1;
+  while ((opt = getopt_long(argc, argv, "c:d:l:m:r:evh", options, NULL)) != -1) {
+    switch (opt) {
+      case 'd':
+        setDeviceName(optarg);
+        break;
+      case 'l':
+        setLogFile(optarg);
+        break;
+      case 'm':
+        setCommandFile(optarg);
+        break;
+      case 'r':
+        setRate(atoi(optarg));
+        break;
+      case 'e':
+        setChecksumError(1);
+        break;
+      case 'v':
+        setDebugOutput(1);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Block signals before starting threads so that only sigwait() receives them
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  sigaddset(&set, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+  // Start serial port communication
+  if (start() != 0) return EXIT_FAILURE;
+
+  // Run until interrupted
+  sigwait(&set, &sig);
+
+  // Stop serial port communication
+  stop();
+
+  return EXIT_SUCCESS;
+}
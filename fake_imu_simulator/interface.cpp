@@ -10,6 +10,8 @@
 extern "C" {
 #endif
 
+void setIniFile(const char * ini_file) { FakeIMUSimulator::get()->setIniFile(ini_file); }
+
 void loadIniFile(void) { FakeIMUSimulator::get()->loadIniFile(); }
 
 void saveIniFile(void) { FakeIMUSimulator::get()->saveIniFile(); }
@@ -35,6 +37,18 @@ void setLogFile(const char * log_file) { return FakeIMUSimulator::get()->setLogF
 
 const char * getLogFile(void) { return FakeIMUSimulator::get()->getLogFile(); }
 
+void setRate(int rate) { FakeIMUSimulator::get()->setRate(rate); }
+
+int getRate(void) { return FakeIMUSimulator::get()->getRate(); }
+
+// Command
+void setCommandFile(const char * command_file)
+{
+  FakeIMUSimulator::get()->setCommandFile(command_file);
+}
+
+const char * getCommandFile(void) { return FakeIMUSimulator::get()->getCommandFile(); }
+
 #ifdef __cplusplus
 }
 #endif
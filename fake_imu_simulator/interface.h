@@ -12,6 +12,12 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Set path of ini file to use instead of the default one
+ * @param [in] ini_file path of ini file
+ */
+void setIniFile(const char * ini_file);
+
 /**
  * @brief Load data from ini file
  */
@@ -71,6 +77,31 @@ void setLogFile(const char * log_file);
  */
 const char * getLogFile(void);
 
+/**
+ * @brief Set BIN output rate used until a command changes it
+ * @param [in] rate BIN output rate [Hz]
+ */
+void setRate(int rate);
+
+/**
+ * @brief Get BIN output rate used until a command changes it
+ * @return BIN output rate [Hz]
+ */
+int getRate(void);
+
+// Command
+/**
+ * @brief Set path of command file for saving it to ini file
+ * @param [in] command_file path of command file
+ */
+void setCommandFile(const char * command_file);
+
+/**
+ * @brief Get path of command file stored in ini file
+ * @return path of command file
+ */
+const char * getCommandFile(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,8 +26,9 @@ typedef struct
   GtkWidget * sw_checksum_error;  //!< @brief GtkSwitch
   GtkWidget * sw_debug_output;    //!< @brief GtkSwitch
 
-  GtkWidget * grd_bin;        //!< @brief GtkGrid
-  GtkWidget * file_log_file;  //!< @brief GtkFileChooserButton
+  GtkWidget * grd_bin;            //!< @brief GtkGrid
+  GtkWidget * file_log_file;      //!< @brief GtkFileChooserButton
+  GtkWidget * file_command_file;  //!< @brief GtkFileChooserButton
 } Widgets;
 
 void initGeneral(GtkBuilder * b, Widgets * w)
@@ -52,6 +53,7 @@ void initBIN(GtkBuilder * b, Widgets * w)
   // Get the object
   w->grd_bin = GTK_WIDGET(gtk_builder_get_object(b, "grd_bin"));
   w->file_log_file = GTK_WIDGET(gtk_builder_get_object(b, "file_log_file"));
+  w->file_command_file = GTK_WIDGET(gtk_builder_get_object(b, "file_command_file"));
 
   // Adds a child to stack
   gtk_stack_add_named(GTK_STACK(w->stk_base), w->grd_bin, "BIN");
@@ -60,6 +62,8 @@ void initBIN(GtkBuilder * b, Widgets * w)
 
   // Set filename as the current filename for the file chooser
   gtk_file_chooser_set_filename(GTK_FILE_CHOOSER(w->file_log_file), getLogFile());
+  const char * file = getCommandFile();
+  if (strlen(file) > 0) gtk_file_chooser_set_filename(GTK_FILE_CHOOSER(w->file_command_file), file);
 }
 
 int main(int argc, char * argv[])
@@ -208,3 +212,15 @@ void on_file_log_file_selection_changed(GtkFileChooser * chooser, gpointer user_
   // and set path of log file for saving it to ini file
   setLogFile(gtk_file_chooser_get_filename(chooser));
 }
+
+/**
+ * @brief Emitted when there is a change in the set of selected files
+ * @param [in] chooser the object which received the signal
+ * @param [in] user data set when the signal handler was connected
+ */
+void on_file_command_file_selection_changed(GtkFileChooser * chooser, gpointer user_data)
+{
+  // Get the filename for the currently selected file in the file selector
+  // and set path of command file for saving it to ini file
+  setCommandFile(gtk_file_chooser_get_filename(chooser));
+}
@@ -25,10 +25,14 @@ FakeVelodyneSimulator * FakeVelodyneSimulator::get(void)
   return velodyne_;
 }
 
+void FakeVelodyneSimulator::setIniFile(const char * ini_file) { ini_path_ = ini_file; }
+
 void FakeVelodyneSimulator::loadIniFile(void)
 {
-  auto env = boost::this_process::environment();
-  ini_path_ = env["HOME"].to_string() + "/.config/fake_velodyne_simulator.ini";
+  if (ini_path_.empty()) {
+    auto env = boost::this_process::environment();
+    ini_path_ = env["HOME"].to_string() + "/.config/fake_velodyne_simulator.ini";
+  }
 
   if (!fs::exists(ini_path_)) return;
 
@@ -37,23 +41,23 @@ void FakeVelodyneSimulator::loadIniFile(void)
 
   if (boost::optional<std::string> v = pt.get_optional<std::string>("address")) {
     const char * str = v.get().c_str();
-    strncpy(address_, str, strlen(str));
+    strncpy(address_, str, sizeof(address_) - 1);
   }
   if (boost::optional<std::string> v = pt.get_optional<std::string>("info")) {
     const char * str = v.get().c_str();
-    strncpy(info_path_, str, strlen(str));
+    strncpy(info_path_, str, sizeof(info_path_) - 1);
   }
   if (boost::optional<std::string> v = pt.get_optional<std::string>("diag")) {
     const char * str = v.get().c_str();
-    strncpy(diag_path_, str, strlen(str));
+    strncpy(diag_path_, str, sizeof(diag_path_) - 1);
   }
   if (boost::optional<std::string> v = pt.get_optional<std::string>("status")) {
     const char * str = v.get().c_str();
-    strncpy(status_path_, str, strlen(str));
+    strncpy(status_path_, str, sizeof(status_path_) - 1);
   }
   if (boost::optional<std::string> v = pt.get_optional<std::string>("settings")) {
     const char * str = v.get().c_str();
-    strncpy(settings_path_, str, strlen(str));
+    strncpy(settings_path_, str, sizeof(settings_path_) - 1);
   }
 
   //  Load data from info.json
@@ -81,7 +85,7 @@ void FakeVelodyneSimulator::saveIniFile(void)
 
 void FakeVelodyneSimulator::setAddress(const char * address)
 {
-  strncpy(address_, address, strlen(address));
+  strncpy(address_, address, sizeof(address_) - 1);
 }
 
 const char * FakeVelodyneSimulator::getAddress(void) const { return address_; }
@@ -112,7 +116,7 @@ void FakeVelodyneSimulator::setDebugOutput(int is_debug)
 // Info
 void FakeVelodyneSimulator::setInfoJson(const char * path)
 {
-  strncpy(info_path_, path, strlen(path));
+  strncpy(info_path_, path, sizeof(info_path_) - 1);
   //  Load data from info.json
   loadInfoJson();
 }
@@ -122,7 +126,7 @@ const char * FakeVelodyneSimulator::getInfoJson(void) const { return info_path_;
 // Diagnostics
 void FakeVelodyneSimulator::setDiagJson(const char * path)
 {
-  strncpy(diag_path_, path, strlen(path));
+  strncpy(diag_path_, path, sizeof(diag_path_) - 1);
   // Load data from diag.json
   loadDiagJson();
 }
@@ -318,7 +322,7 @@ void FakeVelodyneSimulator::setBottomVIn(double bot_v_in)
 // Status
 void FakeVelodyneSimulator::setStatusJson(const char * path)
 {
-  strncpy(status_path_, path, strlen(path));
+  strncpy(status_path_, path, sizeof(status_path_) - 1);
   // Load data from status.json
   loadStatusJson();
 }
@@ -361,7 +365,7 @@ bool FakeVelodyneSimulator::getLaserState(void) const { return laser_state_; }
 // Settings
 void FakeVelodyneSimulator::setSettingsJson(const char * path)
 {
-  strncpy(settings_path_, path, strlen(path));
+  strncpy(settings_path_, path, sizeof(settings_path_) - 1);
   // Load data from settings.json
   loadSettingsJson();
 }
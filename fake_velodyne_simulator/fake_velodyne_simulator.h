@@ -18,6 +18,12 @@ class FakeVelodyneSimulator
 public:
   static FakeVelodyneSimulator * get();
 
+  /**
+   * @brief Set path of ini file to use instead of the default one
+   * @param [in] ini_file path of ini file
+   */
+  void setIniFile(const char * ini_file);
+
   /**
    * @brief Load data from ini file
    */
@@ -0,0 +1,110 @@
+/**
+ * @file headless.c
+ * @brief Main program without GUI
+ */
+
+#include <getopt.h>
+#include <interface.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Show usage
+ * @param [in] name program name
+ */
+static void usage(const char * name)
+{
+  printf("Usage: %s [options]\n", name);
+  printf("  -c, --config FILE      load settings from FILE instead of the default ini file\n");
+  printf("  -a, --address URL      server address\n");
+  printf("  -i, --info FILE        info.json\n");
+  printf("  -g, --diag FILE        diag.json\n");
+  printf("  -s, --status FILE      status.json\n");
+  printf("  -t, --settings FILE    settings.json\n");
+  printf("  -v, --debug            show debug output\n");
+  printf("  -h, --help             show this help\n");
+}
+
+/**
+ * @brief Main function
+ * @param [in] argc the count of command line arguments
+ * @param [in] argv the command line arguments
+ */
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    {"config", required_argument, NULL, 'c'},
+    {"address", required_argument, NULL, 'a'},
+    {"info", required_argument, NULL, 'i'},
+    {"diag", required_argument, NULL, 'g'},
+    {"status", required_argument, NULL, 's'},
+    {"settings", required_argument, NULL, 't'},
+    {"debug", no_argument, NULL, 'v'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+  };
+  sigset_t set;
+  int sig;
+  int opt;
+
+  // Settings from the config file are loaded first, and flags override them
+  while ((opt = getopt_long(argc, argv, "c:a:i:g:s:t:vh", options, NULL)) != -1) {
+    if (opt == 'c') {
+      setIniFile(optarg);
+    } else if (opt == 'h') {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (opt == '?') {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Load data from ini file
+  loadIniFile();
+
+  optind = 1;
+  while ((opt = getopt_long(argc, argv, "c:a:i:g:s:t:vh", options, NULL)) != -1) {
+    switch (opt) {
+      case 'a':
+        setAddress(optarg);
+        break;
+      case 'i':
+        setInfoJson(optarg);
+        break;
+      case 'g':
+        setDiagJson(optarg);
+        break;
+      case 's':
+        setStatusJson(optarg);
+        break;
+      case 't':
+        setSettingsJson(optarg);
+        break;
+      case 'v':
+        setDebugOutput(1);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Block signals before starting threads so that only sigwait() receives them
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  sigaddset(&set, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+  // Start HTTP server
+  if (start() != 0) return EXIT_FAILURE;
+
+  // Run until interrupted
+  sigwait(&set, &sig);
+
+  // Stop HTTP server
+  stop();
+
+  return EXIT_SUCCESS;
+}
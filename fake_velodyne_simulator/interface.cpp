@@ -10,6 +10,8 @@
 extern "C" {
 #endif
 
+void setIniFile(const char * ini_file) { FakeVelodyneSimulator::get()->setIniFile(ini_file); }
+
 void loadIniFile(void) { FakeVelodyneSimulator::get()->loadIniFile(); }
 
 void saveIniFile(void) { FakeVelodyneSimulator::get()->saveIniFile(); }
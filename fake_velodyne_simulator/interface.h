@@ -12,6 +12,12 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Set path of ini file to use instead of the default one
+ * @param [in] ini_file path of ini file
+ */
+void setIniFile(const char * ini_file);
+
 /**
  * @brief Load data from ini file
  */